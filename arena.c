@@ -0,0 +1,192 @@
+#include <jo/jo.h>
+#include "arena.h"
+
+ARENA g_Arena = {0};
+ARENA g_SoundArena = {0};
+
+// base must be ARENA_ALIGNMENT aligned
+// returns 0 on success
+int arenaInit(PARENA arena, unsigned char* base, unsigned int size)
+{
+    if(arena == NULL || base == NULL || size == 0 || ((unsigned int)(size_t)base & (ARENA_ALIGNMENT - 1)))
+    {
+        jo_core_error("Invalid arena parameters!!");
+        return -1;
+    }
+
+    jo_memset(arena, 0, sizeof(ARENA));
+    arena->base = base;
+    arena->size = size;
+
+    return 0;
+}
+
+// returns an ARENA_ALIGNMENT aligned buffer, NULL on failure
+void* arenaAlloc(PARENA arena, unsigned int size)
+{
+    unsigned int aligned = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    void* p = NULL;
+
+    if(arena == NULL || size == 0)
+    {
+        return NULL;
+    }
+
+    if(arena->base == NULL || aligned > arena->size - arena->used)
+    {
+        if(arena->base != NULL)
+        {
+            arena->fallbacks++;
+        }
+        return jo_malloc(size);
+    }
+
+    p = arena->base + arena->used;
+    arena->last = p;
+    arena->lastUsed = arena->used;
+    arena->used += aligned;
+
+    if(arena->used > arena->peak)
+    {
+        arena->peak = arena->used;
+    }
+
+    return p;
+}
+
+// resizes p in place when it is the most recent allocation and there is room
+// otherwise moves it to a new allocation like realloc()
+// returns NULL on failure, p is still valid
+void* arenaRealloc(PARENA arena, void* p, unsigned int oldSize, unsigned int newSize)
+{
+    unsigned int aligned = (newSize + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    void* newP = NULL;
+
+    if(p == NULL)
+    {
+        return arenaAlloc(arena, newSize);
+    }
+
+    if(arena == NULL || newSize == 0)
+    {
+        return NULL;
+    }
+
+    if(p == arena->last && aligned <= arena->size - arena->lastUsed)
+    {
+        arena->used = arena->lastUsed + aligned;
+
+        if(arena->used > arena->peak)
+        {
+            arena->peak = arena->used;
+        }
+
+        return p;
+    }
+
+    newP = arenaAlloc(arena, newSize);
+    if(newP == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(newP, p, oldSize < newSize ? oldSize : newSize);
+    arenaFree(arena, p);
+
+    return newP;
+}
+
+// pops the most recent allocation, other arena pointers wait for arenaRelease()
+void arenaFree(PARENA arena, void* p)
+{
+    if(arena == NULL || p == NULL)
+    {
+        return;
+    }
+
+    if((unsigned char*)p < arena->base || (unsigned char*)p >= arena->base + arena->size)
+    {
+        // came from the fallback
+        jo_free(p);
+        return;
+    }
+
+    if(p == arena->last)
+    {
+        arena->used = arena->lastUsed;
+        arena->last = NULL;
+    }
+}
+
+// the current position, pass to arenaRelease() to free everything allocated after it
+unsigned int arenaMark(PARENA arena)
+{
+    return arena != NULL ? arena->used : 0;
+}
+
+void arenaRelease(PARENA arena, unsigned int mark)
+{
+    if(arena == NULL || mark > arena->used)
+    {
+        return;
+    }
+
+    arena->used = mark;
+    arena->last = NULL;
+}
+
+void* arenaZalloc(void* opaque, size_t items, size_t size)
+{
+    return arenaAlloc((PARENA)opaque, items * size);
+}
+
+void arenaZfree(void* opaque, void* address)
+{
+    arenaFree((PARENA)opaque, address);
+}
+
+// HWRAM allocations come from the Jo heap, which no longer includes LWRAM
+// The arenas fall back to the Jo heap when full or not set up, e.g. on the host
+void* regionAlloc(unsigned int region, unsigned int size)
+{
+    switch(region)
+    {
+        case MEMORY_REGION_HOT:
+            return jo_malloc(size);
+
+        case MEMORY_REGION_BULK:
+            return arenaAlloc(&g_Arena, size);
+
+        case MEMORY_REGION_SOUND:
+            return arenaAlloc(&g_SoundArena, size);
+
+        default:
+            jo_core_error("Invalid memory region %d!!", region);
+            return NULL;
+    }
+}
+
+void regionFree(unsigned int region, void* p)
+{
+    switch(region)
+    {
+        case MEMORY_REGION_HOT:
+            if(p != NULL)
+            {
+                jo_free(p);
+            }
+            break;
+
+        case MEMORY_REGION_BULK:
+            arenaFree(&g_Arena, p);
+            break;
+
+        case MEMORY_REGION_SOUND:
+            arenaFree(&g_SoundArena, p);
+            break;
+
+        default:
+            jo_core_error("Invalid memory region %d!!", region);
+            break;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <jo/jo.h>
+
+/*
+ * Bump pointer arena for the per-transfer encode pipeline. Allocations are
+ * released all at once with arenaRelease(). Freeing the most recent
+ * allocation pops it, which is all miniz and escapeBuffer() need, anything
+ * else is a no-op until the next release.
+ *
+ * When the arena is full, or was never initialized (the host tools), the
+ * allocation falls back to jo_malloc() and arenaFree() passes it on to
+ * jo_free().
+ */
+
+#define ARENA_ALIGNMENT 8
+
+/*
+ * Where an allocation should live. LWRAM is slower than HWRAM so anything
+ * touched for every byte or sample goes in HWRAM, see regionAlloc().
+ */
+#define MEMORY_REGION_HOT       0 // HWRAM (Jo heap): lookup tables and per-sample buffers
+#define MEMORY_REGION_BULK      1 // LWRAM (g_Arena): the encode pipeline, released per transfer
+#define MEMORY_REGION_SOUND     2 // sound RAM (g_SoundArena): buffers the SCSP plays from
+#define MEMORY_NUM_REGIONS      3
+
+typedef struct _ARENA
+{
+    unsigned char* base;
+    unsigned int size;
+    unsigned int used; // bytes allocated
+    unsigned int peak; // high-water mark of used
+    unsigned char* last; // most recent allocation, can be popped
+    unsigned int lastUsed; // used before the most recent allocation
+    unsigned int fallbacks; // allocations that went to the Jo heap
+} ARENA, *PARENA;
+
+// the transfer arena and the sound RAM arena, set up in jo_main()
+extern ARENA g_Arena;
+extern ARENA g_SoundArena;
+
+int arenaInit(PARENA arena, unsigned char* base, unsigned int size);
+void* arenaAlloc(PARENA arena, unsigned int size);
+void* arenaRealloc(PARENA arena, void* p, unsigned int oldSize, unsigned int newSize);
+void arenaFree(PARENA arena, void* p);
+unsigned int arenaMark(PARENA arena);
+void arenaRelease(PARENA arena, unsigned int mark);
+
+// miniz zalloc/zfree hooks, opaque is the arena
+void* arenaZalloc(void* opaque, size_t items, size_t size);
+void arenaZfree(void* opaque, void* address);
+
+// allocates from the given MEMORY_REGION_
+void* regionAlloc(unsigned int region, unsigned int size);
+void regionFree(unsigned int region, void* p);
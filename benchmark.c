@@ -0,0 +1,342 @@
+#include <jo/jo.h>
+#include "main.h"
+#include "util.h"
+#include "encode.h"
+#include "profile.h"
+#include "benchmark.h"
+#include "saturn-minimodem.h"
+#include "simpleaudio.h"
+#include "arena.h"
+#include "crc32.h"
+
+#if USE_BENCHMARKS
+
+static const char* BENCHMARK_INPUT_NAMES[BENCHMARK_NUM_INPUTS] = {"empty", "text", "random", "bios"};
+static const char* BENCHMARK_STAGE_NAMES[BENCHMARK_NUM_STAGES] = {"md5", "crc32", "deflate", "rs", "escape", "tone"};
+
+// sizes picked to look like real saves, the BIOS is sent in BIOS_SEGMENT_SIZE pieces
+static const unsigned int BENCHMARK_INPUT_SIZES[BENCHMARK_NUM_INPUTS] = {8 * 1024, 16 * 1024, 32 * 1024, BIOS_SEGMENT_SIZE};
+
+static const char* BENCHMARK_WORDS[] = {"HERO", "SWORD", "POTION", "LEVEL", "GOLD", "ARMOR", "SAVE", "CASTLE",
+                                        "DRAGON", "MAGIC", "ITEM", "KEY", "CHAPTER", "ELF", "SHIELD", "HP"};
+
+static unsigned int g_BenchmarkSeed = 0;
+static unsigned int g_BenchmarkCrc = 0; // keeps the CRC stage from being optimized out
+
+// xorshift32, fixed seed per input so every run sees the same data
+static unsigned int benchmarkRandom(void)
+{
+    g_BenchmarkSeed ^= g_BenchmarkSeed << 13;
+    g_BenchmarkSeed ^= g_BenchmarkSeed >> 17;
+    g_BenchmarkSeed ^= g_BenchmarkSeed << 5;
+    return g_BenchmarkSeed;
+}
+
+const char* benchmarkInputName(unsigned int input)
+{
+    return input < BENCHMARK_NUM_INPUTS ? BENCHMARK_INPUT_NAMES[input] : "?";
+}
+
+const char* benchmarkStageName(unsigned int stage)
+{
+    return stage < BENCHMARK_NUM_STAGES ? BENCHMARK_STAGE_NAMES[stage] : "?";
+}
+
+unsigned int benchmarkInputSize(unsigned int input)
+{
+    return input < BENCHMARK_NUM_INPUTS ? BENCHMARK_INPUT_SIZES[input] : 0;
+}
+
+// fills buffer with the data for input
+static void generateInput(unsigned int input, unsigned char* buffer, unsigned int size, const unsigned char* biosSegment)
+{
+    unsigned int i = 0;
+
+    g_BenchmarkSeed = 0x2545F491 + input;
+    jo_memset(buffer, 0, size);
+
+    switch(input)
+    {
+        case BENCHMARK_INPUT_EMPTY:
+            // small header of counters and flags, the rest is untouched
+            for(i = 0; i < 64; i++)
+            {
+                buffer[i] = benchmarkRandom() & 0x0F;
+            }
+            for(i = 0; i < 16; i++)
+            {
+                buffer[benchmarkRandom() % size] = benchmarkRandom();
+            }
+            break;
+
+        case BENCHMARK_INPUT_TEXT:
+            // fixed size records of names and words
+            while(i < size)
+            {
+                const char* word = BENCHMARK_WORDS[benchmarkRandom() % COUNTOF(BENCHMARK_WORDS)];
+
+                while(*word && i < size)
+                {
+                    buffer[i++] = *word++;
+                }
+
+                if(i < size)
+                {
+                    buffer[i++] = (benchmarkRandom() & 3) ? ' ' : (benchmarkRandom() & 0xFF);
+                }
+            }
+            break;
+
+        case BENCHMARK_INPUT_RANDOM:
+            for(i = 0; i < size; i++)
+            {
+                buffer[i] = benchmarkRandom() >> 24;
+            }
+            break;
+
+        case BENCHMARK_INPUT_BIOS:
+            if(biosSegment != NULL)
+            {
+                memcpy(buffer, biosSegment, size);
+                break;
+            }
+
+            // big-endian 16-bit instructions from a small set with random registers
+            for(i = 0; i + 1 < size; i += 2)
+            {
+                static const unsigned short opcodes[] = {0x6003, 0x2000, 0x7000, 0xE000, 0x8B00, 0x000B, 0x0009, 0x4F22};
+                unsigned short opcode = opcodes[benchmarkRandom() % COUNTOF(opcodes)] | ((benchmarkRandom() >> 20) & 0x0FF0);
+
+                buffer[i] = opcode >> 8;
+                buffer[i + 1] = opcode & 0xFF;
+            }
+            break;
+    }
+}
+
+// transmits bytes the way fsk_transmit_frame() does into a stream that discards the audio
+static int benchmarkTone(unsigned char* buffer, unsigned int size)
+{
+    MODEM_CONFIG config = {0};
+    simpleaudio* sa = NULL;
+    unsigned int bitSamples = 0;
+
+    SaturnMinimodem_getConfig(&config);
+
+    // same defaults as SaturnMinimodem_init()
+    if(config.markFreq == 0)
+    {
+        config.markFreq = config.dataRate / 2 + 600;
+    }
+    if(config.spaceFreq == 0)
+    {
+        config.spaceFreq = config.markFreq + config.dataRate * 5 / 6;
+    }
+
+    bitSamples = config.sampleRate / config.dataRate + 0.5f;
+
+    sa = simpleaudio_open_stream(SA_BACKEND_BENCHMARK, NULL, SA_STREAM_PLAYBACK, SA_SAMPLE_FORMAT_S16,
+                                 config.sampleRate, 1, "SGEX", "benchmark");
+    if(sa == NULL)
+    {
+        return -1;
+    }
+
+    simpleaudio_tone_reset();
+
+    for(unsigned int i = 0; i < size; i++)
+    {
+        simpleaudio_tone(sa, config.spaceFreq, bitSamples * config.numStartBits);
+
+        for(unsigned int bit = 0; bit < 8; bit++)
+        {
+            simpleaudio_tone(sa, ((buffer[i] >> bit) & 1) ? config.markFreq : config.spaceFreq, bitSamples);
+        }
+
+        simpleaudio_tone(sa, config.markFreq, bitSamples * config.numStopBits);
+    }
+
+    simpleaudio_close(sa);
+    return 0;
+}
+
+// runs stage on input iterations times and records the time spent
+// returns 0 on success
+int benchmarkRun(unsigned int input, unsigned int stage, unsigned int iterations,
+                 const unsigned char* biosSegment, PBENCHMARK_RESULT result)
+{
+    unsigned char* buffer = NULL;
+    unsigned char* outBuffer = NULL;
+    unsigned int size = 0;
+    unsigned int start = 0;
+    int status = 0;
+
+    if(input >= BENCHMARK_NUM_INPUTS || stage >= BENCHMARK_NUM_STAGES || iterations == 0 || result == NULL)
+    {
+        return -1;
+    }
+
+    size = BENCHMARK_INPUT_SIZES[input];
+    result->bytes = 0;
+    result->ticks = 0;
+
+    buffer = jo_malloc(size);
+    if(buffer == NULL)
+    {
+        jo_core_error("Failed to allocate benchmark input!!");
+        return -1;
+    }
+
+    generateInput(input, buffer, size, biosSegment);
+
+    switch(stage)
+    {
+        case BENCHMARK_STAGE_MD5:
+        {
+            unsigned char md5Hash[MD5_HASH_SIZE];
+            unsigned char unalignedHash[MD5_HASH_SIZE];
+
+            // the aligned word load path must match the byte by byte path used for unaligned data
+            outBuffer = jo_malloc(size + 1);
+            if(outBuffer == NULL)
+            {
+                status = -1;
+                break;
+            }
+            memcpy(outBuffer + 1, buffer, size);
+
+            status = calculateMD5Hash(buffer, size, md5Hash);
+            status |= calculateMD5Hash(outBuffer + 1, size, unalignedHash);
+            for(unsigned int i = 0; i < MD5_HASH_SIZE && status == 0; i++)
+            {
+                if(md5Hash[i] != unalignedHash[i])
+                {
+                    jo_core_error("MD5 aligned and unaligned hashes differ!!");
+                    status = -1;
+                }
+            }
+
+            start = profileTicks();
+            for(unsigned int i = 0; i < iterations && status == 0; i++)
+            {
+                status = calculateMD5Hash(buffer, size, md5Hash);
+            }
+            result->ticks = profileTicks() - start;
+            break;
+        }
+
+        case BENCHMARK_STAGE_CRC32:
+            start = profileTicks();
+            for(unsigned int i = 0; i < iterations; i++)
+            {
+                g_BenchmarkCrc = crc32End(crc32Update(crc32Begin(), buffer, size));
+            }
+            result->ticks = profileTicks() - start;
+            break;
+
+        case BENCHMARK_STAGE_COMPRESS:
+            outBuffer = jo_malloc(compressOutSize(size));
+            if(outBuffer == NULL)
+            {
+                status = -1;
+                break;
+            }
+
+            start = profileTicks();
+            for(unsigned int i = 0; i < iterations && status == 0; i++)
+            {
+                unsigned int outSize = compressOutSize(size);
+                status = compressBuffer(buffer, size, outBuffer, &outSize);
+            }
+            result->ticks = profileTicks() - start;
+            break;
+
+        case BENCHMARK_STAGE_RS:
+            outBuffer = jo_malloc(reedSolomonOutSize(size));
+            if(outBuffer == NULL)
+            {
+                status = -1;
+                break;
+            }
+
+            start = profileTicks();
+            for(unsigned int i = 0; i < iterations && status == 0; i++)
+            {
+                status = reedSolomonEncode(buffer, size, outBuffer);
+            }
+            result->ticks = profileTicks() - start;
+            break;
+
+        case BENCHMARK_STAGE_ESCAPE:
+            // escapeBuffer replaces the buffer, time it on a fresh copy each iteration
+            for(unsigned int i = 0; i < iterations && status == 0; i++)
+            {
+                unsigned int escapedSize = size;
+
+                // from the arena like encodeTransmission() so it grows in place
+                outBuffer = arenaAlloc(&g_Arena, size);
+                if(outBuffer == NULL)
+                {
+                    status = -1;
+                    break;
+                }
+                memcpy(outBuffer, buffer, size);
+
+                start = profileTicks();
+                status = escapeBuffer(&outBuffer, &escapedSize);
+                result->ticks += profileTicks() - start;
+
+                arenaFree(&g_Arena, outBuffer);
+                outBuffer = NULL;
+            }
+            break;
+
+        case BENCHMARK_STAGE_TONE:
+            size = size < BENCHMARK_TONE_BYTES ? size : BENCHMARK_TONE_BYTES;
+
+            start = profileTicks();
+            for(unsigned int i = 0; i < iterations && status == 0; i++)
+            {
+                status = benchmarkTone(buffer, size);
+            }
+            result->ticks = profileTicks() - start;
+            break;
+    }
+
+    if(outBuffer != NULL)
+    {
+        jo_free(outBuffer);
+    }
+    jo_free(buffer);
+
+    if(status != 0)
+    {
+        jo_core_error("Benchmark %s %s failed!!", benchmarkInputName(input), benchmarkStageName(stage));
+        return -1;
+    }
+
+    result->bytes = size * iterations;
+    return 0;
+}
+
+unsigned int benchmarkKBytesPerSecond(PBENCHMARK_RESULT result)
+{
+    if(result == NULL || result->ticks == 0)
+    {
+        return 0;
+    }
+
+    return (unsigned int)((unsigned long long)result->bytes * profileTicksPerSecond() / result->ticks / 1024);
+}
+
+unsigned int benchmarkCyclesPerByte(PBENCHMARK_RESULT result)
+{
+    if(result == NULL || result->bytes == 0)
+    {
+        return 0;
+    }
+
+    return (unsigned int)((unsigned long long)result->ticks * profileCyclesPerTick() / result->bytes);
+}
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+/*
+ * Encode pipeline microbenchmarks. Times each stage of the transmitter on a
+ * few kinds of input so the SH-2 and host costs can be compared. Built when
+ * USE_BENCHMARKS is set, see the makefiles.
+ */
+
+// inputs
+#define BENCHMARK_INPUT_EMPTY       0 // freshly created save, mostly zeros
+#define BENCHMARK_INPUT_TEXT        1 // text heavy save, e.g. an RPG's dialog flags and names
+#define BENCHMARK_INPUT_RANDOM      2 // incompressible data
+#define BENCHMARK_INPUT_BIOS        3 // one BIOS_SEGMENT_SIZE segment
+#define BENCHMARK_NUM_INPUTS        4
+
+// stages
+#define BENCHMARK_STAGE_MD5         0 // calculateMD5Hash
+#define BENCHMARK_STAGE_CRC32       1 // crc32Update
+#define BENCHMARK_STAGE_COMPRESS    2 // compressBuffer
+#define BENCHMARK_STAGE_RS          3 // reedSolomonEncode
+#define BENCHMARK_STAGE_ESCAPE      4 // escapeBuffer
+#define BENCHMARK_STAGE_TONE        5 // simpleaudio_tone, the audio for each byte
+#define BENCHMARK_NUM_STAGES        6
+
+// tone synthesis is much slower than the other stages, only time one transmit block
+#define BENCHMARK_TONE_BYTES        128
+
+typedef struct _BENCHMARK_RESULT
+{
+    unsigned int bytes; // bytes processed over all iterations
+    unsigned int ticks; // profileTicks() spent
+} BENCHMARK_RESULT, *PBENCHMARK_RESULT;
+
+const char* benchmarkInputName(unsigned int input);
+const char* benchmarkStageName(unsigned int stage);
+unsigned int benchmarkInputSize(unsigned int input);
+
+// biosSegment is used for BENCHMARK_INPUT_BIOS, NULL to generate code-like data instead
+int benchmarkRun(unsigned int input, unsigned int stage, unsigned int iterations,
+                 const unsigned char* biosSegment, PBENCHMARK_RESULT result);
+
+unsigned int benchmarkKBytesPerSecond(PBENCHMARK_RESULT result);
+unsigned int benchmarkCyclesPerByte(PBENCHMARK_RESULT result); // 0 if unknown
@@ -4,6 +4,8 @@ SET JO_ENGINE_SRC_DIR=../../jo_engine
 SET PATH=%COMPILER_DIR%\WINDOWS\Other Utilities;%PATH%
 
 rm -f ./cd/0.bin
+rm -f ./cd/SND68K.BIN
+rm -f ./m68k/*.o ./m68k/*.elf
 rm -f *.o
 rm -f %JO_ENGINE_SRC_DIR%/*.o
 rm -f ./*.bin
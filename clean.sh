@@ -1,5 +1,7 @@
 #!/bin/bash
 rm -f ./cd/0.bin
+rm -f ./cd/SND68K.BIN
+rm -f ./m68k/*.o ./m68k/*.elf
 rm -f *.o
 rm -f ../../jo_engine/*.o
 rm -f ./*.bin
@@ -0,0 +1,72 @@
+#include <jo/jo.h>
+#include "crc32.h"
+
+#define CRC32_POLYNOMIAL 0xEDB88320 // reflected
+
+// g_Crc32Table[0] is the usual byte table, g_Crc32Table[n] advances it n more bytes
+static unsigned int g_Crc32Table[4][256];
+static bool g_Crc32Initialized = false;
+
+static void crc32Init(void)
+{
+    for(unsigned int i = 0; i < 256; i++)
+    {
+        unsigned int crc = i;
+
+        for(unsigned int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLYNOMIAL : crc >> 1;
+        }
+
+        g_Crc32Table[0][i] = crc;
+    }
+
+    for(unsigned int i = 0; i < 256; i++)
+    {
+        g_Crc32Table[1][i] = (g_Crc32Table[0][i] >> 8) ^ g_Crc32Table[0][g_Crc32Table[0][i] & 0xFF];
+        g_Crc32Table[2][i] = (g_Crc32Table[1][i] >> 8) ^ g_Crc32Table[0][g_Crc32Table[1][i] & 0xFF];
+        g_Crc32Table[3][i] = (g_Crc32Table[2][i] >> 8) ^ g_Crc32Table[0][g_Crc32Table[2][i] & 0xFF];
+    }
+
+    g_Crc32Initialized = true;
+}
+
+// returns the starting value for crc32Update(), builds the tables on first use
+unsigned int crc32Begin(void)
+{
+    if(g_Crc32Initialized == false)
+    {
+        crc32Init();
+    }
+
+    return 0xFFFFFFFF;
+}
+
+unsigned int crc32Update(unsigned int crc, const unsigned char* buffer, unsigned int bufferSize)
+{
+    // four bytes per step, assembled by hand so it is the same on the big-endian SH-2
+    while(bufferSize >= 4)
+    {
+        crc ^= buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((unsigned int)buffer[3] << 24);
+        crc = g_Crc32Table[3][crc & 0xFF] ^
+              g_Crc32Table[2][(crc >> 8) & 0xFF] ^
+              g_Crc32Table[1][(crc >> 16) & 0xFF] ^
+              g_Crc32Table[0][crc >> 24];
+
+        buffer += 4;
+        bufferSize -= 4;
+    }
+
+    while(bufferSize--)
+    {
+        crc = (crc >> 8) ^ g_Crc32Table[0][(crc ^ *buffer++) & 0xFF];
+    }
+
+    return crc;
+}
+
+// returns the finished CRC
+unsigned int crc32End(unsigned int crc)
+{
+    return crc ^ 0xFFFFFFFF;
+}
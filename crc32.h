@@ -0,0 +1,12 @@
+#pragma once
+
+/*
+ * CRC-32 (IEEE 802.3, same as zlib's crc32()) using slice-by-4 tables.
+ * A much cheaper integrity check than MD5 on the SH-2, see INTEGRITY_CRC32.
+ */
+
+#define CRC32_SIZE 4
+
+unsigned int crc32Begin(void);
+unsigned int crc32Update(unsigned int crc, const unsigned char* buffer, unsigned int bufferSize);
+unsigned int crc32End(unsigned int crc);
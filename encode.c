@@ -1,6 +1,60 @@
 #include "encode.h"
+#include "profile.h"
+#include "arena.h"
+#include "crc32.h"
 
 correct_reed_solomon* g_reedSolomon = NULL;
+unsigned int g_reedSolomonParity = PARITY_BYTES;
+
+// INTEGRITY_IMAGE_MD5 runs across the checkpoints
+static MD5_CTX g_ImageMd5 = {0};
+static const unsigned char* g_ImageMd5Image = NULL; // start of the image being hashed
+static unsigned int g_ImageMd5Offset = 0; // bytes of the image in g_ImageMd5
+
+// the image MD5 at the start of each checkpoint hashed so far, going back
+// to one only hashes from the checkpoint before it
+#define IMAGE_MD5_MARKS             BIOS_NUM_CHECKPOINTS
+
+typedef struct _IMAGE_MD5_MARK
+{
+    const unsigned char* image; // NULL until the checkpoint is reached
+    unsigned int offset;
+    MD5_CTX ctx;
+} IMAGE_MD5_MARK, *PIMAGE_MD5_MARK;
+
+static IMAGE_MD5_MARK g_ImageMd5Marks[IMAGE_MD5_MARKS] = {0};
+
+// creates the Reed Solomon encoder shared by all transmissions
+// numRoots is the number of parity bytes per codeword, sgex.py expects RS_NUM_ROOTS
+// returns 0 on success
+int initializeReedSolomon(unsigned int numRoots)
+{
+    if(numRoots == 0 || numRoots % 2 || numRoots >= CODEWORD_SIZE)
+    {
+        jo_core_error("Invalid Reed Solomon parity %d", numRoots);
+        return -1;
+    }
+
+    if(g_reedSolomon != NULL)
+    {
+        correct_reed_solomon_destroy(g_reedSolomon);
+        g_reedSolomon = NULL;
+    }
+
+    g_reedSolomon = correct_reed_solomon_create(correct_rs_primitive_polynomial_ccsds,
+                                                RS_FIRST_CONSECUTIVE_ROOT,
+                                                RS_ROOT_GAP,
+                                                numRoots);
+    if(g_reedSolomon == NULL)
+    {
+        jo_core_error("Failed to init Reed Solomon");
+        return -1;
+    }
+
+    g_reedSolomonParity = numRoots;
+
+    return 0;
+}
 
 // calculates the MD5 hash of buffer
 // md5Hash is an out parameter that must be at least MD5_HASH_SIZE (16) long
@@ -24,17 +78,20 @@ int calculateMD5Hash(unsigned char* buffer, unsigned int bufferSize, unsigned ch
 
 // initializes the transmission header consisting of:
 // - 4-byte signature SGEX
-// - md5hash
+// - version
+// - integrity checks
 // - filename
 // - numBytes
 // - numBytes length save data
-int initializeTransmissionHeader(unsigned char* md5Hash, unsigned int md5HashSize, char* saveFilename, unsigned int saveFileSize)
+// The integrity checks follow the save data in the trailer
+int initializeTransmissionHeader(char* saveFilename, unsigned int saveFileSize, unsigned char integrity)
 {
     PTRANSMISSION_HEADER header = (PTRANSMISSION_HEADER)g_Game.transmissionData;
 
-    if(header == NULL || md5Hash == NULL ||
-       md5HashSize != MD5_HASH_SIZE ||
-       saveFilename == NULL || saveFileSize == 0)
+    if(header == NULL || saveFilename == NULL || saveFileSize == 0 ||
+       integrity == 0 || (integrity & ~INTEGRITY_VALID) ||
+       ((integrity & INTEGRITY_IMAGE_MD5) && ((integrity & INTEGRITY_MD5) || g_Game.numCheckpoints == 0)) ||
+       (g_Game.numCheckpoints != 0 && g_Game.checkpoint >= g_Game.numCheckpoints))
     {
         jo_core_error("Invalid parameters to initialize transmission header!!");
         return -1;
@@ -43,9 +100,15 @@ int initializeTransmissionHeader(unsigned char* md5Hash, unsigned int md5HashSiz
     jo_memset(header, 0, sizeof(TRANSMISSION_HEADER));
 
     memcpy(header->magic, TRANSMISSION_MAGIC, TRANSMISSION_MAGIC_SIZE);
-    memcpy(header->md5Hash, md5Hash, MD5_HASH_SIZE);
+    header->version = TRANSMISSION_VERSION;
+    header->integrity = integrity;
     strncpy(header->saveFilename, saveFilename, MAX_SAVE_FILENAME - 1);
-    header->saveFileSize = saveFileSize;
+    header->saveFileSize = toBigEndian32(saveFileSize);
+
+    header->checkpoint = g_Game.checkpoint;
+    header->numCheckpoints = g_Game.numCheckpoints;
+    header->imageOffset = toBigEndian32(g_Game.imageOffset);
+    header->knownImage = g_Game.knownImage;
 
     return 0;
 }
@@ -68,15 +131,15 @@ int initializeBUPHeader(char* saveFilename, char* saveComment, unsigned char sav
     memcpy(header->magic, VMEM_MAGIC_STRING, VMEM_MAGIC_STRING_LEN);
 
     // save metadata
-    strncpy(header->dir.filename, saveFilename, JO_BACKUP_MAX_FILENAME_LENGTH);
-    strncpy(header->dir.comment, saveComment, JO_BACKUP_MAX_COMMENT_LENGTH + 1);
+    strncpy((char*)header->dir.filename, saveFilename, JO_BACKUP_MAX_FILENAME_LENGTH);
+    strncpy((char*)header->dir.comment, saveComment, JO_BACKUP_MAX_COMMENT_LENGTH + 1);
     header->dir.language = saveLanguage;
-    header->dir.date = date;
-    header->dir.datasize = saveFileSize;
+    header->dir.date = toBigEndian32(date);
+    header->dir.datasize = toBigEndian32(saveFileSize);
     header->dir.blocksize = 0; // not used
 
     // date is duplicated
-    header->date = date;
+    header->date = toBigEndian32(date);
     return 0;
 }
 
@@ -93,16 +156,254 @@ unsigned int compressOutSize(unsigned int dataSize)
 int compressBuffer(unsigned char* inBuf, unsigned int inBufLen, unsigned char* outBuf, unsigned int* outBufLen)
 {
     int result = 0;
-    unsigned long compressedLen = *outBufLen; // suppress compiler warning
-
-    result = compress(outBuf, &compressedLen, inBuf, inBufLen);
+    mz_stream stream = {0};
+
+    // same as compress() but the compressor state comes from the transfer arena
+    stream.next_in = inBuf;
+    stream.avail_in = inBufLen;
+    stream.next_out = outBuf;
+    stream.avail_out = *outBufLen;
+    stream.zalloc = arenaZalloc;
+    stream.zfree = arenaZfree;
+    stream.opaque = &g_Arena;
+
+    result = deflateInit(&stream, Z_DEFAULT_COMPRESSION);
     if(result != Z_OK)
+    {
+        jo_core_error("Failed to init compression with %d", result);
+        return -1;
+    }
+
+    result = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if(result != Z_STREAM_END)
     {
         jo_core_error("Failed to compress with %d", result);
         return -1;
     }
 
-    *outBufLen = compressedLen;
+    *outBufLen = stream.total_out;
+
+    return 0;
+}
+
+// feeds all of inBuf to the compressor
+static int deflateInput(mz_streamp stream, const unsigned char* inBuf, unsigned int inBufLen, int flush)
+{
+    int result = 0;
+
+    stream->next_in = inBuf;
+    stream->avail_in = inBufLen;
+
+    result = deflate(stream, flush);
+    if((flush == Z_FINISH && result != Z_STREAM_END) ||
+       (flush != Z_FINISH && (result != Z_OK || stream->avail_in != 0)))
+    {
+        jo_core_error("Failed to compress with %d", result);
+        return -1;
+    }
+
+    return 0;
+}
+
+// the latest checkpoint up to g_Game.checkpoint with a remembered image MD5, 0 for none
+static unsigned int imageMd5ClosestMark(const unsigned char* image, unsigned int checkpointSize)
+{
+    for(unsigned int i = g_Game.checkpoint < IMAGE_MD5_MARKS ? g_Game.checkpoint : IMAGE_MD5_MARKS - 1; i > 0; i--)
+    {
+        if(g_ImageMd5Marks[i].image == image && g_ImageMd5Marks[i].offset == i * checkpointSize)
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+static void imageMd5Remember(const unsigned char* image, unsigned int checkpoint)
+{
+    if(checkpoint < IMAGE_MD5_MARKS)
+    {
+        g_ImageMd5Marks[checkpoint].image = image;
+        g_ImageMd5Marks[checkpoint].offset = g_ImageMd5Offset;
+        g_ImageMd5Marks[checkpoint].ctx = g_ImageMd5;
+    }
+}
+
+// bytes of the image compressTransmission() has to hash before it gets to
+// g_Game.checkpoint, when it isn't carrying on from the checkpoint before
+unsigned int encodeImageMd5Backlog(void)
+{
+    const unsigned char* image = g_Game.saveFileData - g_Game.imageOffset;
+    unsigned int checkpointSize = 0;
+
+    if((g_Game.integrity & INTEGRITY_IMAGE_MD5) == 0 || g_Game.checkpoint == 0 ||
+       (g_ImageMd5Image == image && g_ImageMd5Offset == g_Game.imageOffset))
+    {
+        return 0;
+    }
+
+    checkpointSize = g_Game.imageOffset / g_Game.checkpoint;
+    return g_Game.imageOffset - imageMd5ClosestMark(image, checkpointSize) * checkpointSize;
+}
+
+// gets g_ImageMd5 to the start of g_Game.checkpoint. Carries on from the
+// checkpoint before, or else from the closest one remembered, a checkpoint at a time
+static void imageMd5CatchUp(void)
+{
+    const unsigned char* image = g_Game.saveFileData - g_Game.imageOffset;
+    unsigned int checkpointSize = g_Game.checkpoint ? g_Game.imageOffset / g_Game.checkpoint : 0;
+    unsigned int mark = 0;
+
+    if(g_Game.checkpoint != 0 && g_ImageMd5Image == image && g_ImageMd5Offset == g_Game.imageOffset)
+    {
+        imageMd5Remember(image, g_Game.checkpoint);
+        return;
+    }
+
+    mark = checkpointSize ? imageMd5ClosestMark(image, checkpointSize) : 0;
+    if(mark != 0)
+    {
+        g_ImageMd5 = g_ImageMd5Marks[mark].ctx;
+        g_ImageMd5Offset = g_ImageMd5Marks[mark].offset;
+    }
+    else
+    {
+        MD5_Init(&g_ImageMd5);
+        g_ImageMd5Offset = 0;
+    }
+    g_ImageMd5Image = image;
+
+    profileBegin(PROFILE_STAGE_MD5);
+    while(g_ImageMd5Offset < g_Game.imageOffset)
+    {
+        MD5_Update(&g_ImageMd5, image + g_ImageMd5Offset, checkpointSize);
+        g_ImageMd5Offset += checkpointSize;
+        imageMd5Remember(image, g_ImageMd5Offset / checkpointSize);
+    }
+    profileEnd(PROFILE_STAGE_MD5);
+
+    imageMd5Remember(image, g_Game.checkpoint);
+}
+
+// compresses the headers in g_Game.transmissionData, the save in g_Game.saveFileData
+// (unless it is g_Game.knownImage) and the trailer in a single pass. Each chunk of the save is run through the
+// g_Game.integrity checks right before it is compressed so it is only read from memory once
+// outbuffer must have been previously allocated with a size returned by compressOutSize
+int compressTransmission(unsigned char* outBuf, unsigned int* outBufLen)
+{
+    int result = 0;
+    mz_stream stream = {0};
+    MD5_CTX ctx = {0};
+    unsigned int crc = 0;
+    TRANSMISSION_TRAILER trailer = {0};
+
+    if(g_Game.transmissionData == NULL || g_Game.saveFileData == NULL || g_Game.saveFileSize == 0)
+    {
+        jo_core_error("Invalid parameters to compressTransmission!!");
+        return -1;
+    }
+
+    stream.next_out = outBuf;
+    stream.avail_out = *outBufLen;
+    stream.zalloc = arenaZalloc;
+    stream.zfree = arenaZfree;
+    stream.opaque = &g_Arena;
+
+    result = deflateInit(&stream, Z_DEFAULT_COMPRESSION);
+    if(result != Z_OK)
+    {
+        jo_core_error("Failed to init compression with %d", result);
+        return -1;
+    }
+
+    // transmission + bup headers
+    profileBegin(PROFILE_STAGE_DEFLATE);
+    result = deflateInput(&stream, g_Game.transmissionData, TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE, Z_NO_FLUSH);
+    profileEnd(PROFILE_STAGE_DEFLATE);
+
+    MD5_Init(&ctx);
+    crc = crc32Begin();
+
+    // the image is contiguous in memory so whatever comes before this checkpoint can be hashed again
+    if(g_Game.integrity & INTEGRITY_IMAGE_MD5)
+    {
+        imageMd5CatchUp();
+    }
+
+    for(unsigned int i = 0; i < g_Game.saveFileSize && result == 0; i += INGEST_CHUNK_SIZE)
+    {
+        unsigned int chunkSize = g_Game.saveFileSize - i < INGEST_CHUNK_SIZE ? g_Game.saveFileSize - i : INGEST_CHUNK_SIZE;
+
+        if(g_Game.integrity & INTEGRITY_MD5)
+        {
+            profileBegin(PROFILE_STAGE_MD5);
+            MD5_Update(&ctx, g_Game.saveFileData + i, chunkSize);
+            profileEnd(PROFILE_STAGE_MD5);
+        }
+
+        if(g_Game.integrity & INTEGRITY_IMAGE_MD5)
+        {
+            profileBegin(PROFILE_STAGE_MD5);
+            MD5_Update(&g_ImageMd5, g_Game.saveFileData + i, chunkSize);
+            profileEnd(PROFILE_STAGE_MD5);
+            g_ImageMd5Offset += chunkSize;
+        }
+
+        if(g_Game.integrity & INTEGRITY_CRC32)
+        {
+            profileBegin(PROFILE_STAGE_CRC32);
+            crc = crc32Update(crc, g_Game.saveFileData + i, chunkSize);
+            profileEnd(PROFILE_STAGE_CRC32);
+        }
+
+        // a known image is only hashed, the receiver has the data
+        if(g_Game.knownImage == 0)
+        {
+            profileBegin(PROFILE_STAGE_DEFLATE);
+            result = deflateInput(&stream, g_Game.saveFileData + i, chunkSize, Z_NO_FLUSH);
+            profileEnd(PROFILE_STAGE_DEFLATE);
+        }
+    }
+
+    jo_memset(g_Game.md5Hash, 0, MD5_HASH_SIZE);
+    g_Game.crc = 0;
+
+    if(g_Game.integrity & INTEGRITY_MD5)
+    {
+        MD5_Final(g_Game.md5Hash, &ctx);
+        memcpy(trailer.md5Hash, g_Game.md5Hash, MD5_HASH_SIZE);
+    }
+
+    if(g_Game.integrity & INTEGRITY_IMAGE_MD5)
+    {
+        // finish a copy, the next checkpoint carries on from here
+        ctx = g_ImageMd5;
+        MD5_Final(g_Game.md5Hash, &ctx);
+        memcpy(trailer.md5Hash, g_Game.md5Hash, MD5_HASH_SIZE);
+    }
+
+    if(g_Game.integrity & INTEGRITY_CRC32)
+    {
+        g_Game.crc = crc32End(crc);
+        trailer.crc = toBigEndian32(g_Game.crc);
+    }
+
+    // trailer
+    if(result == 0)
+    {
+        profileBegin(PROFILE_STAGE_DEFLATE);
+        result = deflateInput(&stream, (unsigned char*)&trailer, TRANSMISSION_TRAILER_SIZE, Z_FINISH);
+        profileEnd(PROFILE_STAGE_DEFLATE);
+    }
+
+    deflateEnd(&stream);
+    if(result != 0)
+    {
+        return -1;
+    }
+
+    *outBufLen = stream.total_out;
 
     return 0;
 }
@@ -119,17 +420,20 @@ unsigned int reedSolomonOutSize(unsigned int dataSize)
         numChunks++;
     }
 
-    return dataSize + (numChunks*PARITY_BYTES);
+    return dataSize + (numChunks*g_reedSolomonParity);
 }
 
 // Reed Solomon encodes a buffer
 // outbuffer must have been previously allocated with a size returned by reedSolomonOutSize
+// inBuf and outBuf may be the same buffer. Chunks are encoded last to first so
+// every codeword lands on data that has already been consumed
 int reedSolomonEncode(unsigned char* inBuf, unsigned int inBufLen, unsigned char* outBuf)
 {
-    unsigned int dataWritten = 0;
+    unsigned int numChunks = (inBufLen + DATA_CHUNK_SIZE - 1) / DATA_CHUNK_SIZE;
 
-    for(unsigned int i = 0; i < inBufLen; i += DATA_CHUNK_SIZE)
+    for(unsigned int chunk = numChunks; chunk > 0; chunk--)
     {
+        unsigned int i = (chunk - 1) * DATA_CHUNK_SIZE;
         unsigned int chunkSize = 0;
 
         if(inBufLen - i >= DATA_CHUNK_SIZE)
@@ -141,9 +445,8 @@ int reedSolomonEncode(unsigned char* inBuf, unsigned int inBufLen, unsigned char
             chunkSize = inBufLen  - i;
         }
 
-        correct_reed_solomon_encode(g_reedSolomon, inBuf + i, chunkSize, outBuf + dataWritten);
-
-        dataWritten += CODEWORD_SIZE;
+        // libcorrect reads the whole chunk before writing the codeword
+        correct_reed_solomon_encode(g_reedSolomon, inBuf + i, chunkSize, outBuf + (chunk - 1) * CODEWORD_SIZE);
     }
 
     return 0;
@@ -171,6 +474,8 @@ unsigned int countEscapeBytes(unsigned char* buffer, unsigned int bufferSize)
 }
 
 // escapes all SYNC_BYTEs and and ESCAPE_BYTEs. Resizes the buffer as needed
+// The buffer is grown in place (it is normally the last arena allocation) and
+// expanded from the tail backwards so no second buffer is needed
 unsigned int escapeBuffer(unsigned char** buffer, unsigned int* bufferSize)
 {
     unsigned int escapeCount = 0;
@@ -179,7 +484,7 @@ unsigned int escapeBuffer(unsigned char** buffer, unsigned int* bufferSize)
 
     escapeCount = countEscapeBytes(*buffer, *bufferSize);
 
-    // found escape bytes, need to reallocate the buffer
+    // found escape bytes, need to grow the buffer
     if(escapeCount != 0)
     {
         unsigned int i = 0;
@@ -187,44 +492,257 @@ unsigned int escapeBuffer(unsigned char** buffer, unsigned int* bufferSize)
 
         newBufSize = *bufferSize + escapeCount;
 
-        // we found escape bytes, resize the buffer
-        newBuf = jo_malloc(newBufSize);
+        newBuf = arenaRealloc(&g_Arena, *buffer, *bufferSize, newBufSize);
         if(newBuf == NULL)
         {
             jo_core_error("Failed to reallocate buffer!!");
             return -1;
         }
 
-        // copy over the buffers, escaping the escape sequence
-        for(i = 0, j = 0; i < *bufferSize; i++, j++)
+        // j catches up with i after the first escaped byte, the rest is already in place
+        for(i = *bufferSize, j = newBufSize; i != j; )
         {
-            if((*buffer)[i] == ESCAPE_BYTE)
+            i--;
+
+            if(newBuf[i] == ESCAPE_BYTE)
             {
                 // escape the escape byte
-                newBuf[j] = ESCAPE_BYTE;
-                j++;
-                newBuf[j] = ESCAPE_BYTE;
+                newBuf[--j] = ESCAPE_BYTE;
+                newBuf[--j] = ESCAPE_BYTE;
             }
-            else if((*buffer)[i] == SYNC_BYTE)
+            else if(newBuf[i] == SYNC_BYTE)
             {
                 // escape the sync byte
-                newBuf[j] = ESCAPE_BYTE;
-                j++;
-                newBuf[j] = ESCAPE_SYNC_BYTE;
+                newBuf[--j] = ESCAPE_SYNC_BYTE;
+                newBuf[--j] = ESCAPE_BYTE;
             }
             else
             {
                 // no escape
-                newBuf[j] = (*buffer)[i];
+                newBuf[--j] = newBuf[i];
             }
         }
 
-        // free the old buffer
-        jo_free(*buffer);
-
         *buffer = newBuf;
         *bufferSize = newBufSize;
     }
 
     return 0;
 }
+
+// escapes the few bytes of a marker's numbers into out, which needs room for
+// twice inSize. Returns the number of bytes written
+unsigned int escapeBytes(const unsigned char* in, unsigned int inSize, unsigned char* out)
+{
+    unsigned int j = 0;
+
+    for(unsigned int i = 0; i < inSize; i++)
+    {
+        if(in[i] == ESCAPE_BYTE)
+        {
+            out[j++] = ESCAPE_BYTE;
+            out[j++] = ESCAPE_BYTE;
+        }
+        else if(in[i] == SYNC_BYTE)
+        {
+            out[j++] = ESCAPE_BYTE;
+            out[j++] = ESCAPE_SYNC_BYTE;
+        }
+        else
+        {
+            out[j++] = in[i];
+        }
+    }
+
+    return j;
+}
+
+// puts ESCAPE_BYTE ESCAPE_CHECKPOINT_BYTE in front of an escaped checkpoint
+static int prependCheckpointMarker(unsigned char** buffer, unsigned int* bufferSize)
+{
+    unsigned char* newBuf = NULL;
+
+    newBuf = arenaRealloc(&g_Arena, *buffer, *bufferSize, *bufferSize + CHECKPOINT_MARKER_SIZE);
+    if(newBuf == NULL)
+    {
+        jo_core_error("Failed to reallocate buffer!!");
+        return -1;
+    }
+
+    memmove(newBuf + CHECKPOINT_MARKER_SIZE, newBuf, *bufferSize);
+    newBuf[0] = ESCAPE_BYTE;
+    newBuf[1] = ESCAPE_CHECKPOINT_BYTE;
+
+    *buffer = newBuf;
+    *bufferSize += CHECKPOINT_MARKER_SIZE;
+    return 0;
+}
+
+// number of Reed Solomon codewords dataSize bytes are sent in
+unsigned int reedSolomonNumCodewords(unsigned int dataSize)
+{
+    return (dataSize + DATA_CHUNK_SIZE - 1) / DATA_CHUNK_SIZE;
+}
+
+// builds a copy of g_Game.encodedTransmissionData that starts at the given
+// codeword, so an interrupted transfer can pick up where the receiver lost it.
+// The codeword is announced with ESCAPE_BYTE ESCAPE_RESUME_BYTE and the
+// escaped checkpoint and codeword numbers. A checkpoint keeps its marker
+// in front of that. *buffer is allocated from the transfer arena
+int encodeResume(unsigned int codeword, unsigned char** buffer, unsigned int* bufferSize)
+{
+    unsigned char marker[RESUME_MARKER_SIZE] = {ESCAPE_BYTE, ESCAPE_RESUME_BYTE,
+                                                (unsigned char)g_Game.checkpoint,
+                                                (unsigned char)(codeword >> 8),
+                                                (unsigned char)codeword};
+    unsigned int prefixSize = g_Game.numCheckpoints ? CHECKPOINT_MARKER_SIZE : 0;
+    unsigned int start = prefixSize;
+    unsigned int target = codeword * CODEWORD_SIZE;
+    unsigned int j = 0;
+    unsigned char* newBuf = NULL;
+
+    if(g_Game.encodedTransmissionData == NULL || codeword == 0 ||
+       codeword >= reedSolomonNumCodewords(g_Game.compressedSize) || codeword > 0xFFFF)
+    {
+        jo_core_error("Invalid codeword to resume from %d!!", codeword);
+        return -1;
+    }
+
+    // walk the escaped data to where the codeword starts, escape pairs are one byte
+    for(unsigned int i = 0; i < target && start < g_Game.encodedTransmissionSize; i++)
+    {
+        start += (g_Game.encodedTransmissionData[start] == ESCAPE_BYTE) ? 2 : 1;
+    }
+
+    // room for every number byte to need escaping
+    newBuf = arenaAlloc(&g_Arena, prefixSize + RESUME_MARKER_SIZE * 2 + g_Game.encodedTransmissionSize - start);
+    if(newBuf == NULL)
+    {
+        jo_core_error("Failed to allocate resume buffer!!");
+        return -1;
+    }
+
+    memcpy(newBuf, g_Game.encodedTransmissionData, prefixSize);
+    j = prefixSize;
+
+    newBuf[j++] = marker[0];
+    newBuf[j++] = marker[1];
+    j += escapeBytes(marker + 2, RESUME_MARKER_SIZE - 2, newBuf + j);
+
+    memcpy(newBuf + j, g_Game.encodedTransmissionData + start, g_Game.encodedTransmissionSize - start);
+
+    *buffer = newBuf;
+    *bufferSize = j + g_Game.encodedTransmissionSize - start;
+    return 0;
+}
+
+// runs the save in g_Game.saveFileData through the whole pipeline:
+// transmission + BUP headers, integrity checks and compression, Reed Solomon and escaping
+// On success g_Game.encodedTransmissionData holds the bytes to transmit
+int encodeTransmission(void)
+{
+    int result = 0;
+    unsigned int unencodedSize = 0;
+    unsigned int uncompressedSize = 0;
+    unsigned char* buffer = NULL;
+    unsigned int bufferSize = 0;
+
+    g_Game.compressedSize = 0;
+
+    // transmission header
+    result = initializeTransmissionHeader(g_Game.saveFilename, g_Game.saveFileSize, g_Game.integrity);
+    if(result != 0)
+    {
+        return -1;
+    }
+
+    // bup header
+    result = initializeBUPHeader(g_Game.saveFilename, g_Game.saveComment, g_Game.saveLanguage, g_Game.saveDate, g_Game.saveFileSize);
+    if(result != 0)
+    {
+        return -1;
+    }
+
+    //
+    // Compress the save
+    // compression, Reed Solomon and escaping all work in this one buffer,
+    // each stage resizes it for the next one
+    //
+
+    // estimate the compressed output size
+    uncompressedSize = TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + TRANSMISSION_TRAILER_SIZE;
+    uncompressedSize += g_Game.knownImage ? 0 : g_Game.saveFileSize;
+    g_Game.compressedSize = compressOutSize(uncompressedSize);
+
+    buffer = arenaAlloc(&g_Arena, g_Game.compressedSize);
+    if(buffer == NULL)
+    {
+        jo_core_error("Failed to allocate compression buffer!!");
+        return -1;
+    }
+    bufferSize = g_Game.compressedSize;
+
+    // also hashes the save, the profiler times MD5 and deflate separately
+    result = compressTransmission(buffer, &g_Game.compressedSize);
+    if(result != 0)
+    {
+        arenaFree(&g_Arena, buffer);
+        return -1;
+    }
+
+    //
+    // Reed Solomon encode the compressed buffer
+    //
+    unencodedSize = g_Game.compressedSize;
+    g_Game.encodedTransmissionSize = reedSolomonOutSize(unencodedSize);
+
+    // make room for the parity bytes, the compressed data stays at the start
+    g_Game.encodedTransmissionData = arenaRealloc(&g_Arena, buffer, bufferSize, g_Game.encodedTransmissionSize);
+    if(g_Game.encodedTransmissionData == NULL)
+    {
+        jo_core_error("Failed to allocate Reed Solomon buffer!!");
+        arenaFree(&g_Arena, buffer);
+        g_Game.encodedTransmissionSize = 0;
+        return -1;
+    }
+
+    profileBegin(PROFILE_STAGE_RS);
+    result = reedSolomonEncode(g_Game.encodedTransmissionData, unencodedSize, g_Game.encodedTransmissionData);
+    profileEnd(PROFILE_STAGE_RS);
+    if(result != 0)
+    {
+        jo_core_error("Failed to Reed Solomon encode data!!");
+        arenaFree(&g_Arena, g_Game.encodedTransmissionData);
+        g_Game.encodedTransmissionData = NULL;
+        g_Game.encodedTransmissionSize = 0;
+        return -1;
+    }
+
+    // escape the buffer if necessary
+    profileBegin(PROFILE_STAGE_ESCAPE);
+    result = escapeBuffer(&g_Game.encodedTransmissionData, &g_Game.encodedTransmissionSize);
+    profileEnd(PROFILE_STAGE_ESCAPE);
+    if(result != 0)
+    {
+        jo_core_error("Failed to escape the data!!");
+        arenaFree(&g_Arena, g_Game.encodedTransmissionData);
+        g_Game.encodedTransmissionData = NULL;
+        g_Game.encodedTransmissionSize = 0;
+        return -1;
+    }
+
+    // streamed images mark where each checkpoint starts
+    if(g_Game.numCheckpoints != 0)
+    {
+        result = prependCheckpointMarker(&g_Game.encodedTransmissionData, &g_Game.encodedTransmissionSize);
+        if(result != 0)
+        {
+            arenaFree(&g_Arena, g_Game.encodedTransmissionData);
+            g_Game.encodedTransmissionData = NULL;
+            g_Game.encodedTransmissionSize = 0;
+            return -1;
+        }
+    }
+
+    return 0;
+}
@@ -8,49 +8,116 @@
 
 /*
  * The entire transmission consists of the TRANSMISSION_HEADER + BUP_HEADER
- * + variable length save. This data is compressed, then Reed Solomon encoded,
- * then escaped.
+ * + variable length save + TRANSMISSION_TRAILER. This data is compressed,
+ * then Reed Solomon encoded, then escaped.
+ *
+ * The integrity checks are sent in the trailer so the save can be hashed and
+ * compressed in a single pass. Version 1 transmissions had the MD5 hash in
+ * the header and no trailer.
+ *
+ * A large image like the BIOS can be streamed as a run of checkpoints, each a
+ * complete transmission of the next piece of the image sent straight after the
+ * last one. Each is preceded by ESCAPE_BYTE ESCAPE_CHECKPOINT_BYTE, which
+ * escaped data never contains, so the receiver can split the stream and
+ * recover every piece that arrived intact.
+ *
+ * Data that matches a known image (see known.h) is not sent at all. The
+ * header's knownImage is set and the trailer follows the headers directly,
+ * saveFileSize is still the size of the data it stands for.
+ *
+ * An interrupted transfer can be resent from any Reed Solomon codeword, see
+ * encodeResume(). The receiver joins it to the codewords it already has.
  */
 
 #define TRANSMISSION_MAGIC_SIZE     4
 #define TRANSMISSION_MAGIC          "SGEX"
+#define TRANSMISSION_VERSION        2
 #define TRANSMISSION_HEADER_SIZE    sizeof(TRANSMISSION_HEADER)
+#define TRANSMISSION_TRAILER_SIZE   sizeof(TRANSMISSION_TRAILER)
 #define MD5_HASH_SIZE               16
 
+// integrity checks in the trailer, TRANSMISSION_HEADER.integrity is a mask of these
+#define INTEGRITY_MD5               0x01 // slow on the SH-2, for archiving
+#define INTEGRITY_CRC32             0x02 // cheap, Reed Solomon already catches nearly all corruption
+#define INTEGRITY_BOTH              (INTEGRITY_MD5 | INTEGRITY_CRC32)
+#define INTEGRITY_IMAGE_MD5         0x04 // checkpoints only, MD5 of the image from its start through this piece
+#define INTEGRITY_VALID             (INTEGRITY_BOTH | INTEGRITY_IMAGE_MD5)
+
+// bytes of save hashed and compressed at a time, small enough to stay in the SH-2 cache
+#define INGEST_CHUNK_SIZE           2048
+
 #define BUP_HEADER_SIZE             64
 
 #define CODEWORD_SIZE 255ul
 #define PARITY_BYTES 32ul
-#define DATA_CHUNK_SIZE (CODEWORD_SIZE - PARITY_BYTES)
+#define DATA_CHUNK_SIZE (CODEWORD_SIZE - g_reedSolomonParity)
 
 #define SYNC_BYTE           (unsigned char)0xAB
 #define ESCAPE_SYNC_BYTE    (unsigned char)0x9F
 #define ESCAPE_BYTE         (unsigned char)0x54
+#define ESCAPE_CHECKPOINT_BYTE  (unsigned char)0xC5 // after ESCAPE_BYTE, starts a checkpoint
+#define CHECKPOINT_MARKER_SIZE  2
+#define ESCAPE_RESUME_BYTE      (unsigned char)0xC6 // after ESCAPE_BYTE, checkpoint and 16-bit codeword follow
+#define RESUME_MARKER_SIZE      5 // before escaping the numbers
+#define ESCAPE_ANNOUNCE_BYTE    (unsigned char)0xC7 // after ESCAPE_BYTE, the escaped modem settings, see speed.h
 
 #define RS_FIRST_CONSECUTIVE_ROOT   1
 #define RS_ROOT_GAP                 1
-#define RS_NUM_ROOTS                32
+#define RS_NUM_ROOTS                PARITY_BYTES
 
 // structure preceding the save file
 // this needs to be Base64 encoded before being sent
 typedef struct _TRANSMISSION_HEADER
 {
     char magic[TRANSMISSION_MAGIC_SIZE]; // magic bytes be SGEX
-    unsigned char md5Hash[MD5_HASH_SIZE];
+    unsigned char version; // TRANSMISSION_VERSION
+    unsigned char integrity; // INTEGRITY_ mask of the checks in the trailer
+    unsigned char checkpoint; // index of this piece of a streamed image
+    unsigned char numCheckpoints; // pieces in the stream, 0 when not streamed
+    unsigned int imageOffset; // where this piece goes in the image
+    unsigned char knownImage; // the data wasn't sent, it is this known image. 0 when it was sent
+    unsigned char reserved[MD5_HASH_SIZE - 9]; // zero, bytes 4 to 20 held the MD5 hash in version 1
     char saveFilename[MAX_SAVE_FILENAME]; // save filename
     unsigned int saveFileSize;  // size of the file in bytes
     unsigned char saveFileData[0]; // saveFileSize number of bytes of save data
 } TRANSMISSION_HEADER, *PTRANSMISSION_HEADER;
 
+// structure following the save file
+// checks that weren't selected are zero
+typedef struct _TRANSMISSION_TRAILER
+{
+    unsigned char md5Hash[MD5_HASH_SIZE]; // MD5 of the save file data, or of the image so far with INTEGRITY_IMAGE_MD5
+    unsigned int crc; // CRC-32 of the save file data
+} TRANSMISSION_TRAILER, *PTRANSMISSION_TRAILER;
+
 extern correct_reed_solomon* g_reedSolomon;
+extern unsigned int g_reedSolomonParity;
+
+// multibyte header fields are sent big-endian, the Saturn's native byte order
+static inline unsigned int toBigEndian32(unsigned int value)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    return ((value & 0xFF) << 24) | ((value & 0xFF00) << 8) |
+           ((value >> 8) & 0xFF00) | ((value >> 24) & 0xFF);
+#else
+    return value;
+#endif
+}
 
+int initializeReedSolomon(unsigned int numRoots);
+int encodeTransmission(void);
 
 int calculateMD5Hash(unsigned char* buffer, unsigned int bufferSize, unsigned char* md5Hash);
-int initializeTransmissionHeader(unsigned char* md5Hash, unsigned int md5HashSize, char* saveFilename, unsigned int saveFileSize);
+int initializeTransmissionHeader(char* saveFilename, unsigned int saveFileSize, unsigned char integrity);
 int initializeBUPHeader(char* saveFilename, char* saveComment, unsigned char saveLanguage, unsigned int date, unsigned int saveFileSize);
 unsigned int countEscapeBytes(unsigned char* buffer, unsigned int bufferSize);
 unsigned int escapeBuffer(unsigned char** buffer, unsigned int* bufferSize);
+unsigned int escapeBytes(const unsigned char* in, unsigned int inSize, unsigned char* out);
 unsigned int reedSolomonOutSize(unsigned int dataSize);
+unsigned int reedSolomonNumCodewords(unsigned int dataSize);
+int encodeResume(unsigned int codeword, unsigned char** buffer, unsigned int* bufferSize);
+unsigned int encodeImageMd5Backlog(void);
 int reedSolomonEncode(unsigned char* inBuf, unsigned int inSize, unsigned char* outBuf);
 unsigned int compressOutSize(unsigned int dataSize);
 int compressBuffer(unsigned char* inBuf, unsigned int inBufLen, unsigned char* outBuf, unsigned int* outBufLen);
+int compressTransmission(unsigned char* outBuf, unsigned int* outBufLen);
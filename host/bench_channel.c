@@ -0,0 +1,572 @@
+/*
+ * sgex-bench-channel - modem settings vs. channel impairments
+ *
+ * Generates audio with the real transmitter for each modem setting, runs
+ * it through a set of simulated line-in impairments, decodes it with a
+ * reference receiver and reports success rate and throughput:
+ *
+ *   sgex-bench-channel [-s SIZE] [-t TRIALS] [-S SEED] [-m RATE/START/STOP/PARITY[/TRANSITION]]...
+ *   sgex-bench-channel [-s SIZE] [-t TRIALS] [-S SEED] -g TRANSITION
+ *
+ *   -s  random payload size in bytes (default 2048)
+ *   -t  trials per modem setting and channel (default 3)
+ *   -S  PRNG seed (default 1)
+ *   -m  modem setting to test, can be repeated. Replaces the default list.
+ *       TRANSITION sweeps between the tones over that much of a bit, see
+ *       MODEM_CONFIG.transitionBits
+ *   -g  instead of the table, step the baud rate up from SEARCH_MIN_RATE at
+ *       1+1 framing and find the fastest rate every channel still passes
+ *       all trials at, with abrupt tone switches and with TRANSITION
+ *
+ * A trial succeeds when the received stream unescapes cleanly, has the
+ * transmitted length and no codeword has more byte errors than
+ * PARITY/2, i.e. what sgex.py's Reed Solomon decode can correct.
+ * BER compares the demodulated bytes with the transmitted ones by position,
+ * so a lost or extra byte shows up as errors in everything after it.
+ */
+#include <jo/jo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../main.h"
+#include "../encode.h"
+#include "../saturn-minimodem.h"
+#include "../arena.h"
+#include "channel.h"
+#include "fsk_demod.h"
+#include "wav.h"
+
+#define MAX_MODEMS 16
+#define DEFAULT_PAYLOAD_SIZE 2048
+#define DEFAULT_TRIALS 3
+
+// -g rate search, the tones follow the rate like minimodem picks them
+#define SEARCH_MIN_RATE 1200
+#define SEARCH_MAX_RATE 9600
+#define SEARCH_RATE_STEP 600
+
+GAME g_Game = {0};
+
+typedef struct _BENCH_MODEM
+{
+    float dataRate;
+    unsigned int numStartBits;
+    unsigned int numStopBits;
+    unsigned int parityBytes;
+    float transitionBits; // MODEM_CONFIG.transitionBits, 0 for minimodem's abrupt tone switches
+} BENCH_MODEM, *PBENCH_MODEM;
+
+// the first entry is what the Saturn ships with
+static BENCH_MODEM g_DefaultModems[] =
+{
+    {1200, 4, 4, RS_NUM_ROOTS, 0},
+    {1200, 1, 1, RS_NUM_ROOTS, 0},
+    {1200, 1, 1, 16, 0},
+    {2400, 1, 1, RS_NUM_ROOTS, 0},
+    {2400, 1, 1, 64, 0},
+    {4800, 1, 1, RS_NUM_ROOTS, 0},
+};
+
+static CHANNEL_CONFIG g_Channels[] =
+{
+    // name            snr  low   high     ppm   clip  slip
+    {"clean",            0,  0,     0,       0,    0,    0},
+    {"awgn 20dB",       20,  0,     0,       0,    0,    0},
+    {"awgn 10dB",       10,  0,     0,       0,    0,    0},
+    {"awgn 6dB",         6,  0,     0,       0,    0,    0},
+    {"line-in 20-16k",  30, 20, 16000,       0,    0,    0},
+    {"phone 300-3400",  20, 300, 3400,       0,    0,    0},
+    {"clock +200ppm",    0,  0,     0,     200,    0,    0},
+    {"clock -200ppm",    0,  0,     0,    -200,    0,    0},
+    {"clip 50%",         0,  0,     0,       0, 0.5f,    0},
+    {"slip 1e-5",        0,  0,     0,       0,    0, 1e-5f},
+    {"combined",        20, 20, 16000,     200, 0.7f, 1e-6f},
+};
+
+// transmitted stream for one modem setting
+typedef struct _BENCH_SIGNAL
+{
+    float* samples;
+    unsigned int numSamples;
+    unsigned int sampleRate;
+    unsigned char* escaped; // what went over the air
+    unsigned int escapedSize;
+    unsigned char* codewords; // Reed Solomon output before escaping
+    unsigned int codewordsSize;
+    unsigned int payloadSize;
+    MODEM_CONFIG modem;
+} BENCH_SIGNAL, *PBENCH_SIGNAL;
+
+// reverses escapeBuffer(), same rules as sgex.py
+// returns 0 on success, -1 on an invalid escape sequence
+static int unescapeBuffer(const unsigned char* inBuf, unsigned int inBufLen, unsigned char* outBuf, unsigned int* outBufLen)
+{
+    unsigned int count = 0;
+
+    for(unsigned int i = 0; i < inBufLen; i++)
+    {
+        if(inBuf[i] != ESCAPE_BYTE)
+        {
+            outBuf[count++] = inBuf[i];
+            continue;
+        }
+
+        if(i + 1 >= inBufLen)
+        {
+            return -1;
+        }
+
+        i++;
+        if(inBuf[i] == ESCAPE_BYTE)
+        {
+            outBuf[count++] = ESCAPE_BYTE;
+        }
+        else if(inBuf[i] == ESCAPE_SYNC_BYTE)
+        {
+            outBuf[count++] = SYNC_BYTE;
+        }
+        else
+        {
+            return -1;
+        }
+    }
+
+    *outBufLen = count;
+    return 0;
+}
+
+static unsigned int countBits(unsigned char x)
+{
+    unsigned int count = 0;
+
+    for(; x; x >>= 1)
+    {
+        count += x & 1;
+    }
+
+    return count;
+}
+
+static void freeSignal(PBENCH_SIGNAL signal)
+{
+    jo_free(signal->samples);
+    arenaFree(&g_Arena, signal->escaped);
+    jo_free(signal->codewords);
+    jo_memset(signal, 0, sizeof(BENCH_SIGNAL));
+}
+
+// runs a random payload through the encoder and the modem into a temporary .wav
+static int transmit(PBENCH_MODEM modem, unsigned int payloadSize, PBENCH_SIGNAL signal)
+{
+    char wavFilename[] = "/tmp/sgex-bench-XXXXXX";
+    unsigned char* data = NULL;
+    MODEM_CONFIG config = {0};
+    int fd = -1;
+    int result = 0;
+
+    jo_memset(signal, 0, sizeof(BENCH_SIGNAL));
+
+    result = initializeReedSolomon(modem->parityBytes);
+    if(result != 0)
+    {
+        return -1;
+    }
+
+    data = jo_malloc(TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + payloadSize);
+    if(data == NULL)
+    {
+        return -1;
+    }
+
+    // random data doesn't compress so the payload size is what goes over the air
+    for(unsigned int i = 0; i < payloadSize; i++)
+    {
+        data[TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + i] = channelRandom() >> 24;
+    }
+
+    jo_memset(g_Game.saveFilename, 0, sizeof(g_Game.saveFilename));
+    strcpy(g_Game.saveFilename, "BENCH");
+    g_Game.transmissionData = data;
+    g_Game.saveFileData = data + TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE;
+    g_Game.saveFileSize = payloadSize;
+    g_Game.integrity = INTEGRITY_MD5;
+
+    result = encodeTransmission();
+    jo_free(data);
+    if(result != 0)
+    {
+        return -1;
+    }
+
+    signal->escaped = g_Game.encodedTransmissionData;
+    signal->escapedSize = g_Game.encodedTransmissionSize;
+    signal->payloadSize = payloadSize;
+    g_Game.encodedTransmissionData = NULL;
+
+    signal->codewords = jo_malloc(signal->escapedSize + 1);
+    if(signal->codewords == NULL ||
+       unescapeBuffer(signal->escaped, signal->escapedSize, signal->codewords, &signal->codewordsSize) != 0)
+    {
+        freeSignal(signal);
+        return -1;
+    }
+
+    fd = mkstemp(wavFilename);
+    if(fd < 0)
+    {
+        fprintf(stderr, "Error: could not create a temporary file\n");
+        freeSignal(signal);
+        return -1;
+    }
+    close(fd);
+
+    SaturnMinimodem_getConfig(&config);
+    config.dataRate = modem->dataRate;
+    config.numStartBits = modem->numStartBits;
+    config.numStopBits = modem->numStopBits;
+    config.markFreq = 0;
+    config.spaceFreq = 0;
+    config.transitionBits = modem->transitionBits;
+
+    result = SaturnMinimodem_setConfig(&config);
+    result |= SaturnMinimodem_setOutputFile(wavFilename);
+    result |= SaturnMinimodem_init();
+    result |= SaturnMinimodem_initTransfer(signal->escaped, signal->escapedSize);
+    if(result == 0)
+    {
+        do
+        {
+            result = SaturnMinimodem_transfer();
+        } while(result == TRANSFER_PROGRESS || result == TRANSFER_BUSY);
+
+        result = (result == TRANSFER_COMPLETE) ? 0 : -1;
+    }
+
+    SaturnMinimodem_getConfig(&signal->modem);
+    SaturnMinimodem_close();
+
+    if(result == 0)
+    {
+        result = readWavFile(wavFilename, &signal->samples, &signal->numSamples, &signal->sampleRate);
+    }
+    remove(wavFilename);
+
+    if(result != 0)
+    {
+        freeSignal(signal);
+        return -1;
+    }
+
+    return 0;
+}
+
+// runs one trial, returns true if sgex.py would have recovered the save
+static bool runTrial(PBENCH_SIGNAL signal, PCHANNEL_CONFIG channel, unsigned long long* bitErrors)
+{
+    DEMOD_CONFIG demod = {0};
+    float* samples = NULL;
+    unsigned int numSamples = 0;
+    unsigned char* received = NULL;
+    unsigned int receivedSize = 0;
+    unsigned char* codewords = NULL;
+    unsigned int codewordsSize = 0;
+    unsigned int common = 0;
+    bool success = false;
+
+    samples = jo_malloc(signal->numSamples * sizeof(float));
+    if(samples == NULL)
+    {
+        return false;
+    }
+    memcpy(samples, signal->samples, signal->numSamples * sizeof(float));
+
+    if(applyChannel(channel, samples, signal->numSamples, signal->sampleRate, &samples, &numSamples) != 0)
+    {
+        *bitErrors += signal->escapedSize * 8ull;
+        return false;
+    }
+
+    demod.dataRate = signal->modem.dataRate;
+    demod.sampleRate = signal->sampleRate;
+    demod.markFreq = signal->modem.markFreq;
+    demod.spaceFreq = signal->modem.spaceFreq;
+    demod.numStartBits = signal->modem.numStartBits;
+    demod.numStopBits = signal->modem.numStopBits;
+    demod.syncByte = SYNC_BYTE;
+
+    if(fskDemodulate(&demod, samples, numSamples, &received, &receivedSize) != 0)
+    {
+        jo_free(samples);
+        *bitErrors += signal->escapedSize * 8ull;
+        return false;
+    }
+    jo_free(samples);
+
+    // raw channel errors, lost or extra bytes count as 8 bit errors each
+    common = receivedSize < signal->escapedSize ? receivedSize : signal->escapedSize;
+    for(unsigned int i = 0; i < common; i++)
+    {
+        *bitErrors += countBits(received[i] ^ signal->escaped[i]);
+    }
+    *bitErrors += 8ull * (receivedSize > common ? receivedSize - common : signal->escapedSize - common);
+
+    codewords = jo_malloc(receivedSize + 1);
+    if(codewords != NULL &&
+       unescapeBuffer(received, receivedSize, codewords, &codewordsSize) == 0 &&
+       codewordsSize == signal->codewordsSize)
+    {
+        success = true;
+
+        for(unsigned int start = 0; start < codewordsSize && success; start += CODEWORD_SIZE)
+        {
+            unsigned int end = start + CODEWORD_SIZE < codewordsSize ? start + CODEWORD_SIZE : codewordsSize;
+            unsigned int errors = 0;
+
+            for(unsigned int i = start; i < end; i++)
+            {
+                errors += codewords[i] != signal->codewords[i];
+            }
+
+            success = errors <= g_reedSolomonParity / 2;
+        }
+    }
+
+    jo_free(codewords);
+    jo_free(received);
+    return success;
+}
+
+// parses RATE/START/STOP/PARITY[/TRANSITION]
+static int parseModem(const char* arg, PBENCH_MODEM modem)
+{
+    int fields = 0;
+
+    modem->transitionBits = 0;
+    fields = sscanf(arg, "%f/%u/%u/%u/%f", &modem->dataRate, &modem->numStartBits, &modem->numStopBits,
+                    &modem->parityBytes, &modem->transitionBits);
+    if(fields != 4 && fields != 5)
+    {
+        return -1;
+    }
+
+    if(modem->dataRate <= 0 || modem->numStartBits == 0 || modem->parityBytes == 0 || modem->parityBytes % 2 ||
+       modem->transitionBits < 0 || modem->transitionBits > 1)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+// fastest rate of the ladder each channel passes with every trial, with
+// every slower rate passing too, for abrupt and shaped tone switches. Both
+// get the same payload and the same noise at each rate
+static int searchRates(float transitionBits, unsigned int payloadSize, unsigned int trials, unsigned int seed)
+{
+    unsigned int numChannels = sizeof(g_Channels) / sizeof(g_Channels[0]);
+    float fastest[2][sizeof(g_Channels) / sizeof(g_Channels[0])] = {{0}};
+    bool failed[2][sizeof(g_Channels) / sizeof(g_Channels[0])] = {{0}};
+
+    printf("payload %u bytes, %u trials, 1+1 RS(255,%u), transitions over %.2f bits\n\n", payloadSize, trials,
+           (unsigned int)(CODEWORD_SIZE - RS_NUM_ROOTS), transitionBits);
+
+    for(unsigned int r = 0; SEARCH_MIN_RATE + r * SEARCH_RATE_STEP <= SEARCH_MAX_RATE; r++)
+    {
+        for(unsigned int shaped = 0; shaped < 2; shaped++)
+        {
+            BENCH_MODEM modem = {SEARCH_MIN_RATE + r * SEARCH_RATE_STEP, 1, 1, RS_NUM_ROOTS, shaped ? transitionBits : 0};
+            BENCH_SIGNAL signal;
+
+            channelSeed(seed + r);
+
+            if(transmit(&modem, payloadSize, &signal) != 0)
+            {
+                fprintf(stderr, "Error: failed to transmit at %.0f baud\n", modem.dataRate);
+                return 1;
+            }
+
+            for(unsigned int c = 0; c < numChannels; c++)
+            {
+                unsigned long long bitErrors = 0;
+                unsigned int successes = 0;
+
+                if(failed[shaped][c])
+                {
+                    continue;
+                }
+
+                for(unsigned int t = 0; t < trials; t++)
+                {
+                    channelSeed(seed * 7919 + r * 131 + c * 17 + t);
+                    successes += runTrial(&signal, &g_Channels[c], &bitErrors);
+                }
+
+                if(successes == trials)
+                {
+                    fastest[shaped][c] = modem.dataRate;
+                }
+                else
+                {
+                    failed[shaped][c] = true;
+                }
+            }
+
+            freeSignal(&signal);
+        }
+    }
+
+    printf("%-16s %12s %12s %8s\n", "channel", "abrupt baud", "shaped baud", "gain");
+    for(unsigned int c = 0; c < numChannels; c++)
+    {
+        char abrupt[16] = "-";
+        char shaped[16] = "-";
+        char gain[16] = "-";
+
+        if(fastest[0][c] > 0)
+        {
+            snprintf(abrupt, sizeof(abrupt), "%s%.0f", failed[0][c] ? "" : ">=", fastest[0][c]);
+        }
+        if(fastest[1][c] > 0)
+        {
+            snprintf(shaped, sizeof(shaped), "%s%.0f", failed[1][c] ? "" : ">=", fastest[1][c]);
+        }
+        if(fastest[0][c] > 0 && fastest[1][c] > 0)
+        {
+            snprintf(gain, sizeof(gain), "%+.0f%%", 100.0 * (fastest[1][c] / fastest[0][c] - 1));
+        }
+
+        printf("%-16s %12s %12s %8s\n", g_Channels[c].name, abrupt, shaped, gain);
+    }
+
+    if(jo_host_error_count() != 0)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: sgex-bench-channel [-s SIZE] [-t TRIALS] [-S SEED] [-m RATE/START/STOP/PARITY[/TRANSITION]]...\n");
+    fprintf(stderr, "       sgex-bench-channel [-s SIZE] [-t TRIALS] [-S SEED] -g TRANSITION\n");
+}
+
+int main(int argc, char** argv)
+{
+    BENCH_MODEM modems[MAX_MODEMS];
+    unsigned int numModems = 0;
+    unsigned int payloadSize = DEFAULT_PAYLOAD_SIZE;
+    unsigned int trials = DEFAULT_TRIALS;
+    unsigned int seed = 1;
+    float searchTransition = -1;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            payloadSize = strtoul(argv[++i], NULL, 0);
+        }
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            trials = strtoul(argv[++i], NULL, 0);
+        }
+        else if(strcmp(argv[i], "-S") == 0 && i + 1 < argc)
+        {
+            seed = strtoul(argv[++i], NULL, 0);
+        }
+        else if(strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+        {
+            searchTransition = strtof(argv[++i], NULL);
+            if(searchTransition <= 0 || searchTransition > 1)
+            {
+                usage();
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc && numModems < MAX_MODEMS)
+        {
+            if(parseModem(argv[++i], &modems[numModems]) != 0)
+            {
+                usage();
+                return 1;
+            }
+            numModems++;
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if(payloadSize == 0 || trials == 0)
+    {
+        usage();
+        return 1;
+    }
+
+    if(searchTransition > 0)
+    {
+        return searchRates(searchTransition, payloadSize, trials, seed);
+    }
+
+    if(numModems == 0)
+    {
+        numModems = sizeof(g_DefaultModems) / sizeof(g_DefaultModems[0]);
+        memcpy(modems, g_DefaultModems, sizeof(g_DefaultModems));
+    }
+
+    printf("payload %u bytes, %u trials\n\n", payloadSize, trials);
+    printf("%-22s %-16s %8s %10s %12s %10s\n", "modem", "channel", "success", "stream bps", "payload bps", "BER");
+
+    for(unsigned int m = 0; m < numModems; m++)
+    {
+        BENCH_SIGNAL signal;
+        char label[32];
+        double seconds = 0;
+
+        channelSeed(seed + m);
+
+        if(transmit(&modems[m], payloadSize, &signal) != 0)
+        {
+            fprintf(stderr, "Error: failed to transmit %.0f/%u/%u/%u\n", modems[m].dataRate,
+                    modems[m].numStartBits, modems[m].numStopBits, modems[m].parityBytes);
+            return 1;
+        }
+
+        snprintf(label, sizeof(label), "%.0f %u+%u RS(255,%u)%s", modems[m].dataRate,
+                 modems[m].numStartBits, modems[m].numStopBits, (unsigned int)(CODEWORD_SIZE - modems[m].parityBytes),
+                 modems[m].transitionBits > 0 ? " rc" : "");
+
+        seconds = (double)signal.numSamples / signal.sampleRate;
+
+        for(unsigned int c = 0; c < sizeof(g_Channels) / sizeof(g_Channels[0]); c++)
+        {
+            unsigned long long bitErrors = 0;
+            unsigned int successes = 0;
+
+            for(unsigned int t = 0; t < trials; t++)
+            {
+                channelSeed(seed * 7919 + m * 131 + c * 17 + t);
+                successes += runTrial(&signal, &g_Channels[c], &bitErrors);
+            }
+
+            printf("%-22s %-16s %7.0f%% %10.0f %12.0f %10.2e\n", label, g_Channels[c].name,
+                   100.0 * successes / trials,
+                   signal.escapedSize * 8.0 / seconds,
+                   payloadSize * 8.0 * successes / trials / seconds,
+                   (double)bitErrors / (8.0 * signal.escapedSize * trials));
+        }
+
+        freeSignal(&signal);
+    }
+
+    if(jo_host_error_count() != 0)
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * sgex-bench-encode - per stage encode pipeline benchmark
+ *
+ * Times MD5, deflate, Reed Solomon, escaping and tone synthesis on the same
+ * inputs the Saturn build's benchmark screen uses:
+ *
+ *   sgex-bench-encode [-n SCALE] [-b bios.bin]
+ *
+ *   -n  multiplies the number of iterations (default 1)
+ *   -b  BIOS dump to use for the bios input instead of generated code
+ */
+#include <jo/jo.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../main.h"
+#include "../encode.h"
+#include "../profile.h"
+#include "../benchmark.h"
+#include "../arena.h"
+#include "../util.h"
+
+// roughly this many bytes per measurement, enough to dwarf the timer overhead
+#define BENCH_BYTES_PER_RUN     (8 * 1024 * 1024)
+#define BENCH_TONE_BYTES_PER_RUN (64 * 1024)
+
+GAME g_Game = {0};
+
+static unsigned char* readBios(const char* filename)
+{
+    FILE* file = NULL;
+    unsigned char* buffer = NULL;
+
+    file = fopen(filename, "rb");
+    if(file == NULL)
+    {
+        fprintf(stderr, "Error: could not open %s for reading\n", filename);
+        return NULL;
+    }
+
+    buffer = jo_malloc(BIOS_SEGMENT_SIZE);
+    if(buffer != NULL && fread(buffer, 1, BIOS_SEGMENT_SIZE, file) != BIOS_SEGMENT_SIZE)
+    {
+        fprintf(stderr, "Error: %s is smaller than a BIOS segment\n", filename);
+        jo_free(buffer);
+        buffer = NULL;
+    }
+
+    fclose(file);
+    return buffer;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: sgex-bench-encode [-n SCALE] [-b bios.bin]\n");
+}
+
+int main(int argc, char** argv)
+{
+    unsigned char* bios = NULL;
+    unsigned char* arenaBase = NULL;
+    unsigned int scale = 1;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            scale = strtoul(argv[++i], NULL, 0);
+        }
+        else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+        {
+            bios = readBios(argv[++i]);
+            if(bios == NULL)
+            {
+                return 1;
+            }
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if(scale == 0)
+    {
+        usage();
+        return 1;
+    }
+
+    if(profileInit() != 0 || initializeReedSolomon(RS_NUM_ROOTS) != 0)
+    {
+        return 1;
+    }
+
+    // same arena size the Saturn gets from LWRAM so escaping grows in place
+    arenaBase = jo_malloc(LWRAM_SIZE);
+    if(arenaBase == NULL || arenaInit(&g_Arena, arenaBase, LWRAM_SIZE) != 0)
+    {
+        fprintf(stderr, "Error: failed to allocate the transfer arena\n");
+        return 1;
+    }
+
+    printf("%-8s %8s %-8s %10s %12s\n", "input", "bytes", "stage", "MB/s", "cycles/byte");
+
+    for(unsigned int input = 0; input < BENCHMARK_NUM_INPUTS; input++)
+    {
+        unsigned int size = benchmarkInputSize(input);
+
+        for(unsigned int stage = 0; stage < BENCHMARK_NUM_STAGES; stage++)
+        {
+            BENCHMARK_RESULT result = {0};
+            unsigned int perRun = (stage == BENCHMARK_STAGE_TONE) ? BENCH_TONE_BYTES_PER_RUN : BENCH_BYTES_PER_RUN;
+            unsigned int iterations = (perRun / size > 0 ? perRun / size : 1) * scale;
+            double seconds = 0;
+
+            if(benchmarkRun(input, stage, iterations, bios, &result) != 0)
+            {
+                return 1;
+            }
+
+            seconds = (double)result.ticks / profileTicksPerSecond();
+
+            printf("%-8s %8u %-8s %10.2f ", benchmarkInputName(input), size, benchmarkStageName(stage),
+                   seconds > 0 ? result.bytes / seconds / (1024.0 * 1024.0) : 0.0);
+
+            if(profileCyclesPerTick() != 0)
+            {
+                printf("%12.1f\n", (double)result.ticks * profileCyclesPerTick() / result.bytes);
+            }
+            else
+            {
+                printf("%12s\n", "-");
+            }
+        }
+    }
+
+    jo_free(arenaBase);
+    jo_free(bios);
+    return jo_host_error_count() != 0;
+}
@@ -0,0 +1,531 @@
+/*
+ * sgex-ber - link qualification with the test screen's PRBS
+ *
+ * Synchronizes to the pseudo-random bit sequence sent by the "Test Audio
+ * Transmission" screen and reports the bit error rate, error bursts, lost
+ * sync and the timing drift between the Saturn and the PC's sound card:
+ *
+ *   sgex-ber [-p 15|23] [-r RATE] [-t CODE] [-f START/STOP] [-n BYTES] [-b] capture
+ *
+ *   -p  PRBS picked on the Saturn (default 15)
+ *   -r  baud rate picked on the Saturn (default the modem's)
+ *   -t  tone plan code entered on the Saturn, sets the rate and the tones
+ *   -f  start and stop bits picked on the Saturn (default the modem's)
+ *   -n  bytes the Saturn sent (default PRBS_TEST_SIZE)
+ *   -b  the capture is minimodem's output instead of a recording, there is
+ *       no timing to measure then
+ *
+ * The capture is a 16-bit mono .wav of the line in, e.g.
+ * arecord -f S16_LE -c 1 -r 44100 capture.wav, decoded with the reference
+ * receiver the benchmarks use.
+ *
+ * Every bit of every byte is compared, including the top bit the PRBS leaves
+ * clear. A burst is a run of errors no more than BURST_GUARD_BITS apart.
+ * Too many errors in SYNC_WINDOW_BYTES and sync is searched for again. If
+ * the sequence carries on where it was the window was a burst of errors,
+ * otherwise a byte was lost or added and the bytes skipped count as unsynced.
+ */
+#include <jo/jo.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../main.h"
+#include "../encode.h"
+#include "../saturn-minimodem.h"
+#include "../prbs.h"
+#include "../toneplan.h"
+#include "fsk_demod.h"
+#include "wav.h"
+
+#define SYNC_VERIFY_BYTES       8 // predicted bytes that must match exactly after seeding
+#define SYNC_WINDOW_BYTES       8 // bytes watched for losing sync
+#define SYNC_LOSS_ERRORS        16 // bit errors in the window that mean sync was lost, random data averages 28
+#define BURST_GUARD_BITS        16
+#define NUM_BURST_BUCKETS       5
+#define BLOCK_BYTES             128 // TRANSFER_BLOCK_SIZE in saturn-minimodem.c, frames between resyncs on the leader
+
+// whole bytes needed to hold order received bits
+#define SEED_BYTES(order)       (((order) + PRBS_BITS_PER_BYTE - 1) / PRBS_BITS_PER_BYTE)
+
+GAME g_Game = {0};
+
+static const unsigned int BURST_BUCKETS[NUM_BURST_BUCKETS] = {1, 2, 8, 16, 64}; // smallest length in each
+
+typedef struct _BER_STATS
+{
+    unsigned long long bitsCompared;
+    unsigned long long bitErrors;
+    unsigned int bytesCompared;
+    unsigned int byteErrors;
+    unsigned int unsyncedBytes; // skipped while looking for sync
+    unsigned int syncLosses;
+
+    unsigned int numBursts;
+    unsigned int longestBurst;
+    unsigned int bursts[NUM_BURST_BUCKETS];
+
+    unsigned int codewordErrors; // byte errors in the current CODEWORD_SIZE bytes
+    unsigned int codewordBytes;
+    unsigned int worstCodeword; // most byte errors in one CODEWORD_SIZE run of bytes
+    unsigned int failedCodewords; // runs Reed Solomon couldn't have corrected
+} BER_STATS, *PBER_STATS;
+
+static unsigned int countBits(unsigned char x)
+{
+    unsigned int count = 0;
+
+    for(; x; x >>= 1)
+    {
+        count += x & 1;
+    }
+
+    return count;
+}
+
+// seeds the generator from the bytes at position and checks it predicts the
+// ones after them. On success prbs continues after the seed bytes
+static bool findSync(PPRBS prbs, unsigned int order, const unsigned char* received, unsigned int position, unsigned int size)
+{
+    PRBS check = {0};
+
+    if(position + SEED_BYTES(order) + SYNC_VERIFY_BYTES > size)
+    {
+        return false;
+    }
+
+    prbsInit(prbs, order);
+
+    for(unsigned int i = 0; i < SEED_BYTES(order); i++)
+    {
+        if(received[position + i] & ~((1 << PRBS_BITS_PER_BYTE) - 1))
+        {
+            return false;
+        }
+
+        for(unsigned int b = 0; b < PRBS_BITS_PER_BYTE; b++)
+        {
+            prbsSeedBit(prbs, received[position + i] >> b);
+        }
+    }
+
+    check = *prbs;
+    for(unsigned int i = 0; i < SYNC_VERIFY_BYTES; i++)
+    {
+        if(prbsNextByte(&check) != received[position + SEED_BYTES(order) + i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void endBurst(PBER_STATS stats, unsigned int length)
+{
+    unsigned int bucket = 0;
+
+    while(bucket + 1 < NUM_BURST_BUCKETS && length >= BURST_BUCKETS[bucket + 1])
+    {
+        bucket++;
+    }
+
+    stats->bursts[bucket]++;
+    stats->numBursts++;
+    stats->longestBurst = length > stats->longestBurst ? length : stats->longestBurst;
+}
+
+static void endCodeword(PBER_STATS stats)
+{
+    if(stats->codewordBytes == 0)
+    {
+        return;
+    }
+
+    stats->worstCodeword = stats->codewordErrors > stats->worstCodeword ? stats->codewordErrors : stats->worstCodeword;
+    stats->failedCodewords += stats->codewordErrors > RS_NUM_ROOTS / 2;
+    stats->codewordErrors = 0;
+    stats->codewordBytes = 0;
+}
+
+// bit positions of the burst being measured
+typedef struct _BURST
+{
+    unsigned long long bit; // compared bits so far
+    unsigned long long start;
+    unsigned long long lastError;
+    bool inBurst;
+} BURST, *PBURST;
+
+// compares a received byte with the predicted one, returns the bit errors
+static unsigned int compareByte(PBER_STATS stats, PBURST burst, unsigned char expected, unsigned char received)
+{
+    unsigned char diff = expected ^ received;
+    unsigned int errors = countBits(diff);
+
+    for(unsigned int b = 0; b < 8; b++, burst->bit++)
+    {
+        if((diff >> b) & 1)
+        {
+            if(burst->inBurst == false)
+            {
+                burst->start = burst->bit;
+                burst->inBurst = true;
+            }
+            burst->lastError = burst->bit;
+        }
+        else if(burst->inBurst && burst->bit - burst->lastError > BURST_GUARD_BITS)
+        {
+            endBurst(stats, (unsigned int)(burst->lastError - burst->start + 1));
+            burst->inBurst = false;
+        }
+    }
+
+    stats->bitsCompared += 8;
+    stats->bitErrors += errors;
+    stats->bytesCompared++;
+    stats->byteErrors += errors != 0;
+
+    stats->codewordErrors += errors != 0;
+    if(++stats->codewordBytes == CODEWORD_SIZE)
+    {
+        endCodeword(stats);
+    }
+
+    return errors;
+}
+
+// the measurement before a compared byte, to take it back if sync turns out lost
+typedef struct _BER_SNAPSHOT
+{
+    PRBS prbs;
+    BER_STATS stats;
+    BURST burst;
+    unsigned int errors; // bit errors in the byte
+} BER_SNAPSHOT, *PBER_SNAPSHOT;
+
+static void measureErrors(unsigned int order, const unsigned char* received, unsigned int size, PBER_STATS stats)
+{
+    BER_SNAPSHOT window[SYNC_WINDOW_BYTES];
+    unsigned int windowTotal = 0;
+    unsigned int windowBytes = 0; // compared since sync
+    bool synced = false;
+    PRBS prbs = {0};
+    PRBS lost = {0}; // the generator where sync was lost
+    unsigned int lostPosition = 0;
+    bool wasSynced = false;
+    BURST burst = {0};
+    unsigned int i = 0;
+
+    while(i < size)
+    {
+        PBER_SNAPSHOT snapshot = &window[windowBytes % SYNC_WINDOW_BYTES];
+
+        if(synced == false)
+        {
+            // look for the sequence a byte at a time
+            if(findSync(&prbs, order, received, i, size) == false)
+            {
+                stats->unsyncedBytes++;
+                i++;
+                continue;
+            }
+
+            // still in step with where sync was lost, it was a burst of errors and not a slip
+            if(wasSynced)
+            {
+                PRBS check = lost;
+
+                for(unsigned int j = lostPosition; j < i + SEED_BYTES(order); j++)
+                {
+                    prbsNextByte(&check);
+                }
+
+                if(check.state == prbs.state)
+                {
+                    stats->syncLosses--;
+                    stats->unsyncedBytes -= i - lostPosition;
+                    for(unsigned int j = lostPosition; j < i; j++)
+                    {
+                        compareByte(stats, &burst, prbsNextByte(&lost), received[j]);
+                    }
+                }
+            }
+
+            // the seed bytes are what the rest is predicted from, they aren't compared
+            i += SEED_BYTES(order);
+            windowTotal = 0;
+            windowBytes = 0;
+            synced = true;
+            continue;
+        }
+
+        windowTotal -= windowBytes >= SYNC_WINDOW_BYTES ? snapshot->errors : 0;
+
+        snapshot->prbs = prbs;
+        snapshot->stats = *stats;
+        snapshot->burst = burst;
+        snapshot->errors = compareByte(stats, &burst, prbsNextByte(&prbs), received[i]);
+
+        windowTotal += snapshot->errors;
+        windowBytes++;
+        i++;
+
+        if(windowTotal > SYNC_LOSS_ERRORS)
+        {
+            // take back the window, the errors might be from a lost or extra byte
+            unsigned int rollback = windowBytes < SYNC_WINDOW_BYTES ? windowBytes : SYNC_WINDOW_BYTES;
+            PBER_SNAPSHOT oldest = &window[(windowBytes - rollback) % SYNC_WINDOW_BYTES];
+
+            *stats = oldest->stats;
+            burst = oldest->burst;
+            lost = oldest->prbs;
+            lostPosition = i - rollback;
+            wasSynced = true;
+
+            stats->syncLosses++;
+
+            // search again from the oldest byte in the window
+            i = lostPosition;
+            synced = false;
+        }
+    }
+
+    if(burst.inBurst)
+    {
+        endBurst(stats, (unsigned int)(burst.lastError - burst.start + 1));
+    }
+    endCodeword(stats);
+}
+
+// compares the spacing of back to back frames with the bit length the
+// transmitter rounds to, at the Saturn's sample rate scaled to the capture's
+static void measureTiming(PMODEM_CONFIG modem, unsigned int sampleRate, const unsigned int* frameStarts, unsigned int numFrames)
+{
+    unsigned int txBitSamples = (unsigned int)(modem->sampleRate / modem->dataRate + 0.5f);
+    double nominal = (double)(modem->numStartBits + 8 + modem->numStopBits) * txBitSamples * sampleRate / modem->sampleRate;
+    double bitSamples = (double)txBitSamples * sampleRate / modem->sampleRate;
+    unsigned long long span = 0;
+    unsigned int frames = 0;
+    double worstJitter = 0;
+    double drift = 0;
+
+    for(unsigned int i = 0; i + 1 < numFrames; i++)
+    {
+        double delta = (double)frameStarts[i + 1] - frameStarts[i];
+
+        // frames across a block gap or a lost byte aren't back to back
+        if(delta < nominal - bitSamples / 2 || delta > nominal + bitSamples / 2)
+        {
+            continue;
+        }
+
+        span += frameStarts[i + 1] - frameStarts[i];
+        frames++;
+
+        if(delta - nominal > worstJitter || nominal - delta > worstJitter)
+        {
+            worstJitter = delta > nominal ? delta - nominal : nominal - delta;
+        }
+    }
+
+    if(frames == 0)
+    {
+        printf("Timing:           no back to back frames to measure\n");
+        return;
+    }
+
+    drift = ((double)span / frames - nominal) / nominal * 1e6;
+
+    printf("Frame length:     %.3f samples (%.3f expected)\n", (double)span / frames, nominal);
+    printf("Timing drift:     %+.0f ppm, %.2f bits over a %u byte block\n", drift,
+           drift * 1e-6 * nominal * BLOCK_BYTES / bitSamples, BLOCK_BYTES);
+    printf("Worst jitter:     %.1f samples (%.0f%% of a bit)\n", worstJitter, 100.0 * worstJitter / bitSamples);
+}
+
+static void printStats(PBER_STATS stats, unsigned int expectedBytes, unsigned int receivedBytes)
+{
+    printf("Bytes received:   %u of %u\n", receivedBytes, expectedBytes);
+    printf("Bytes compared:   %u, %u unsynced, sync lost %u times\n", stats->bytesCompared, stats->unsyncedBytes, stats->syncLosses);
+    printf("Bit errors:       %llu of %llu\n", stats->bitErrors, stats->bitsCompared);
+    printf("BER:              %.2e\n", stats->bitsCompared ? (double)stats->bitErrors / stats->bitsCompared : 1.0);
+    printf("Byte errors:      %u (%.2e)\n", stats->byteErrors,
+           stats->bytesCompared ? (double)stats->byteErrors / stats->bytesCompared : 1.0);
+    printf("Worst codeword:   %u byte errors of %u correctable, %u over\n", stats->worstCodeword, RS_NUM_ROOTS / 2,
+           stats->failedCodewords);
+    printf("Error bursts:     %u, longest %u bits\n", stats->numBursts, stats->longestBurst);
+
+    for(unsigned int i = 0; i < NUM_BURST_BUCKETS; i++)
+    {
+        if(i + 1 < NUM_BURST_BUCKETS)
+        {
+            printf("    %2u-%-2u bits:    %u\n", BURST_BUCKETS[i], BURST_BUCKETS[i + 1] - 1, stats->bursts[i]);
+        }
+        else
+        {
+            printf("    %2u+ bits:      %u\n", BURST_BUCKETS[i], stats->bursts[i]);
+        }
+    }
+}
+
+// minimodem's output, no timing
+static int readCapture(const char* filename, unsigned char** buffer, unsigned int* size)
+{
+    FILE* file = fopen(filename, "rb");
+    long length = 0;
+
+    if(file == NULL)
+    {
+        return -1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    *buffer = jo_malloc(length + 1);
+    if(*buffer == NULL || fread(*buffer, 1, length, file) != (size_t)length)
+    {
+        fclose(file);
+        return -1;
+    }
+
+    fclose(file);
+    *size = length;
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: sgex-ber [-p 15|23] [-r RATE] [-t CODE] [-f START/STOP] [-n BYTES] [-b] capture\n");
+}
+
+int main(int argc, char** argv)
+{
+    MODEM_CONFIG modem = {0};
+    DEMOD_CONFIG demod = {0};
+    BER_STATS stats = {0};
+    const char* filename = NULL;
+    unsigned int order = PRBS_15;
+    unsigned int expectedBytes = PRBS_TEST_SIZE;
+    bool rawCapture = false;
+    float* samples = NULL;
+    unsigned int numSamples = 0;
+    unsigned int sampleRate = 0;
+    unsigned char* received = NULL;
+    unsigned int receivedSize = 0;
+    unsigned int* frameStarts = NULL;
+    TONE_PLAN tonePlan = {0};
+
+    // the Saturn's defaults until told otherwise
+    SaturnMinimodem_getConfig(&modem);
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            order = strtoul(argv[++i], NULL, 0);
+        }
+        else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            modem.dataRate = strtof(argv[++i], NULL);
+        }
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            if(tonePlanDecode(strtoul(argv[++i], NULL, 10), &tonePlan) != 0)
+            {
+                fprintf(stderr, "Error: %s is not a valid tone plan code\n", argv[i]);
+                return 1;
+            }
+            modem.dataRate = tonePlan.dataRate;
+            modem.markFreq = tonePlan.markFreq;
+            modem.spaceFreq = tonePlan.spaceFreq;
+        }
+        else if(strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+        {
+            if(sscanf(argv[++i], "%u/%u", &modem.numStartBits, &modem.numStopBits) != 2)
+            {
+                usage();
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            expectedBytes = strtoul(argv[++i], NULL, 0);
+        }
+        else if(strcmp(argv[i], "-b") == 0)
+        {
+            rawCapture = true;
+        }
+        else if(filename == NULL)
+        {
+            filename = argv[i];
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if(filename == NULL || (order != PRBS_15 && order != PRBS_23) || modem.dataRate < 400 || modem.numStartBits == 0)
+    {
+        usage();
+        return 1;
+    }
+
+    if(rawCapture)
+    {
+        if(readCapture(filename, &received, &receivedSize) != 0)
+        {
+            fprintf(stderr, "Error: could not read %s\n", filename);
+            return 1;
+        }
+    }
+    else
+    {
+        if(readWavFile(filename, &samples, &numSamples, &sampleRate) != 0)
+        {
+            fprintf(stderr, "Error: could not read %s\n", filename);
+            return 1;
+        }
+
+        // the tones SaturnMinimodem_init() picks for 400 baud and up
+        demod.dataRate = modem.dataRate;
+        demod.sampleRate = sampleRate;
+        demod.markFreq = modem.markFreq ? modem.markFreq : modem.dataRate / 2 + 600;
+        demod.spaceFreq = modem.spaceFreq ? modem.spaceFreq : demod.markFreq + modem.dataRate * 5 / 6;
+        demod.numStartBits = modem.numStartBits;
+        demod.numStopBits = modem.numStopBits;
+        demod.syncByte = SYNC_BYTE;
+
+        if(fskDemodulateFrames(&demod, samples, numSamples, &received, &receivedSize, &frameStarts) != 0)
+        {
+            fprintf(stderr, "Error: could not demodulate %s\n", filename);
+            jo_free(samples);
+            return 1;
+        }
+        jo_free(samples);
+    }
+
+    printf("PRBS-%u at %.0f baud %u+%u\n\n", order, modem.dataRate, modem.numStartBits, modem.numStopBits);
+
+    measureErrors(order, received, receivedSize, &stats);
+    printStats(&stats, expectedBytes, receivedSize);
+
+    if(frameStarts != NULL)
+    {
+        printf("\n");
+        measureTiming(&modem, sampleRate, frameStarts, receivedSize);
+    }
+
+    jo_free(received);
+    jo_free(frameStarts);
+
+    if(stats.bytesCompared == 0)
+    {
+        fprintf(stderr, "Error: never synchronized to the PRBS\n");
+        return 1;
+    }
+
+    return 0;
+}
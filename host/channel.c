@@ -0,0 +1,238 @@
+/*
+ * Audio channel impairments for the host benchmarks
+ */
+#include <jo/jo.h>
+#include <math.h>
+
+#include "channel.h"
+
+static unsigned int g_ChannelSeed = 0x12345678;
+
+// RBJ cookbook biquad, direct form 1
+typedef struct _BIQUAD
+{
+    double b0, b1, b2, a1, a2;
+    double x1, x2, y1, y2;
+} BIQUAD, *PBIQUAD;
+
+void channelSeed(unsigned int seed)
+{
+    g_ChannelSeed = seed ? seed : 0x12345678;
+}
+
+// xorshift32
+unsigned int channelRandom(void)
+{
+    g_ChannelSeed ^= g_ChannelSeed << 13;
+    g_ChannelSeed ^= g_ChannelSeed >> 17;
+    g_ChannelSeed ^= g_ChannelSeed << 5;
+    return g_ChannelSeed;
+}
+
+// uniform in (0, 1]
+static double channelUniform(void)
+{
+    return (channelRandom() + 1.0) / 4294967296.0;
+}
+
+// standard normal with Box-Muller
+static double channelGaussian(void)
+{
+    return sqrt(-2.0 * log(channelUniform())) * cos(2.0 * M_PI * channelUniform());
+}
+
+static void initBiquad(PBIQUAD filter, double cutoff, double sampleRate, bool highPass)
+{
+    double w0 = 2.0 * M_PI * cutoff / sampleRate;
+    double alpha = sin(w0) / (2.0 * M_SQRT1_2);
+    double cosw0 = cos(w0);
+    double a0 = 1.0 + alpha;
+
+    jo_memset(filter, 0, sizeof(BIQUAD));
+
+    if(highPass)
+    {
+        filter->b0 = (1.0 + cosw0) / 2.0 / a0;
+        filter->b1 = -(1.0 + cosw0) / a0;
+    }
+    else
+    {
+        filter->b0 = (1.0 - cosw0) / 2.0 / a0;
+        filter->b1 = (1.0 - cosw0) / a0;
+    }
+
+    filter->b2 = filter->b0;
+    filter->a1 = -2.0 * cosw0 / a0;
+    filter->a2 = (1.0 - alpha) / a0;
+}
+
+static void runBiquad(PBIQUAD filter, float* samples, unsigned int numSamples)
+{
+    for(unsigned int i = 0; i < numSamples; i++)
+    {
+        double x = samples[i];
+        double y = filter->b0 * x + filter->b1 * filter->x1 + filter->b2 * filter->x2
+                   - filter->a1 * filter->y1 - filter->a2 * filter->y2;
+
+        filter->x2 = filter->x1;
+        filter->x1 = x;
+        filter->y2 = filter->y1;
+        filter->y1 = y;
+
+        samples[i] = (float)y;
+    }
+}
+
+// resamples as if the receiver's clock ran ppm faster than the transmitter's
+static float* resample(float* samples, unsigned int numSamples, float ppm, unsigned int* outNumSamples)
+{
+    double step = 1.0 / (1.0 + ppm * 1e-6);
+    unsigned int count = (unsigned int)((numSamples - 1) / step);
+    float* out = jo_malloc(count * sizeof(float) + 1);
+
+    if(out == NULL)
+    {
+        return NULL;
+    }
+
+    for(unsigned int i = 0; i < count; i++)
+    {
+        double position = i * step;
+        unsigned int index = (unsigned int)position;
+        double fraction = position - index;
+
+        out[i] = (float)(samples[index] + (samples[index + 1] - samples[index]) * fraction);
+    }
+
+    *outNumSamples = count;
+    return out;
+}
+
+// randomly drops or repeats samples like a capture device losing sync
+static float* slipSamples(float* samples, unsigned int numSamples, float slipRate, unsigned int* outNumSamples)
+{
+    unsigned int threshold = (unsigned int)(slipRate * 4294967295.0);
+    unsigned int count = 0;
+    float* out = jo_malloc(numSamples * 2 * sizeof(float) + 1);
+
+    if(out == NULL)
+    {
+        return NULL;
+    }
+
+    for(unsigned int i = 0; i < numSamples; i++)
+    {
+        if(channelRandom() < threshold)
+        {
+            // half of the slips drop the sample, half repeat it
+            if(channelRandom() & 1)
+            {
+                continue;
+            }
+            out[count++] = samples[i];
+        }
+        out[count++] = samples[i];
+    }
+
+    *outNumSamples = count;
+    return out;
+}
+
+// average power of the non-silent samples, the flush padding would skew it
+static double signalPower(float* samples, unsigned int numSamples)
+{
+    double power = 0;
+    unsigned int count = 0;
+
+    for(unsigned int i = 0; i < numSamples; i++)
+    {
+        if(samples[i] != 0.0f)
+        {
+            power += (double)samples[i] * samples[i];
+            count++;
+        }
+    }
+
+    return count ? power / count : 0;
+}
+
+int applyChannel(PCHANNEL_CONFIG config, float* samples, unsigned int numSamples, unsigned int sampleRate,
+                 float** outSamples, unsigned int* outNumSamples)
+{
+    if(config == NULL || samples == NULL || numSamples < 2 || outSamples == NULL || outNumSamples == NULL)
+    {
+        return -1;
+    }
+
+    if(config->clockPpm != 0)
+    {
+        float* resampled = resample(samples, numSamples, config->clockPpm, &numSamples);
+
+        jo_free(samples);
+        samples = resampled;
+        if(samples == NULL)
+        {
+            return -1;
+        }
+    }
+
+    if(config->lowCutHz > 0)
+    {
+        BIQUAD filter;
+
+        initBiquad(&filter, config->lowCutHz, sampleRate, true);
+        runBiquad(&filter, samples, numSamples);
+    }
+
+    if(config->highCutHz > 0)
+    {
+        BIQUAD filter;
+
+        initBiquad(&filter, config->highCutHz, sampleRate, false);
+        runBiquad(&filter, samples, numSamples);
+    }
+
+    if(config->clipLevel > 0)
+    {
+        float peak = 0;
+
+        for(unsigned int i = 0; i < numSamples; i++)
+        {
+            peak = fabsf(samples[i]) > peak ? fabsf(samples[i]) : peak;
+        }
+
+        // clip and scale back up, like an overdriven line in
+        float level = peak * config->clipLevel;
+        for(unsigned int i = 0; i < numSamples; i++)
+        {
+            float x = samples[i] > level ? level : (samples[i] < -level ? -level : samples[i]);
+            samples[i] = x / config->clipLevel;
+        }
+    }
+
+    if(config->snrDb != 0)
+    {
+        double sigma = sqrt(signalPower(samples, numSamples) / pow(10.0, config->snrDb / 10.0));
+
+        for(unsigned int i = 0; i < numSamples; i++)
+        {
+            samples[i] += (float)(sigma * channelGaussian());
+        }
+    }
+
+    if(config->slipRate > 0)
+    {
+        float* slipped = slipSamples(samples, numSamples, config->slipRate, &numSamples);
+
+        jo_free(samples);
+        samples = slipped;
+        if(samples == NULL)
+        {
+            return -1;
+        }
+    }
+
+    *outSamples = samples;
+    *outNumSamples = numSamples;
+    return 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+/*
+ * Audio channel impairments for the host benchmarks. Models what happens
+ * between the Saturn's audio out and the PC's line in.
+ */
+
+// one set of impairments, 0 disables each of them
+typedef struct _CHANNEL_CONFIG
+{
+    const char* name;
+    float snrDb; // additive white gaussian noise relative to the tone power, 0 for none
+    float lowCutHz; // band-pass, 0 for none
+    float highCutHz; // band-pass, 0 for none
+    float clockPpm; // receiver sample clock offset from the transmitter
+    float clipLevel; // fraction of the peak level to clip at, 0 for none
+    float slipRate; // per sample chance of a dropped or inserted sample
+} CHANNEL_CONFIG, *PCHANNEL_CONFIG;
+
+// deterministic PRNG so a benchmark run can be repeated
+void channelSeed(unsigned int seed);
+unsigned int channelRandom(void);
+
+// applies the impairments to samples and returns the new buffer in outSamples
+// the input buffer is freed, the output length can differ from the input
+// returns 0 on success
+int applyChannel(PCHANNEL_CONFIG config, float* samples, unsigned int numSamples, unsigned int sampleRate,
+                 float** outSamples, unsigned int* outNumSamples);
@@ -0,0 +1,222 @@
+/*
+ * Reference BFSK receiver for the host benchmarks
+ */
+#include <jo/jo.h>
+#include <math.h>
+
+#include "fsk_demod.h"
+
+// squelch, fraction of the strongest tone energy seen
+#define SQUELCH_LEVEL 0.1
+
+// running I/Q sums of the input mixed down by one tone
+// the energy of any window is then two subtractions away
+typedef struct _TONE_SUMS
+{
+    double* i;
+    double* q;
+} TONE_SUMS, *PTONE_SUMS;
+
+static int computeToneSums(PTONE_SUMS sums, const float* samples, unsigned int numSamples, double freq, unsigned int sampleRate)
+{
+    double w = 2.0 * M_PI * freq / sampleRate;
+
+    sums->i = jo_malloc((numSamples + 1) * sizeof(double));
+    sums->q = jo_malloc((numSamples + 1) * sizeof(double));
+    if(sums->i == NULL || sums->q == NULL)
+    {
+        return -1;
+    }
+
+    sums->i[0] = 0;
+    sums->q[0] = 0;
+
+    for(unsigned int n = 0; n < numSamples; n++)
+    {
+        sums->i[n + 1] = sums->i[n] + samples[n] * cos(w * n);
+        sums->q[n + 1] = sums->q[n] + samples[n] * sin(w * n);
+    }
+
+    return 0;
+}
+
+static void freeToneSums(PTONE_SUMS sums)
+{
+    jo_free(sums->i);
+    jo_free(sums->q);
+}
+
+// tone energy over [start, start + length)
+static double windowEnergy(PTONE_SUMS sums, unsigned int start, unsigned int length)
+{
+    double i = sums->i[start + length] - sums->i[start];
+    double q = sums->q[start + length] - sums->q[start];
+
+    return i * i + q * q;
+}
+
+int fskDemodulate(PDEMOD_CONFIG config, const float* samples, unsigned int numSamples,
+                  unsigned char** outBuf, unsigned int* outBufLen)
+{
+    return fskDemodulateFrames(config, samples, numSamples, outBuf, outBufLen, NULL);
+}
+
+int fskDemodulateFrames(PDEMOD_CONFIG config, const float* samples, unsigned int numSamples,
+                        unsigned char** outBuf, unsigned int* outBufLen, unsigned int** frameStarts)
+{
+    TONE_SUMS mark = {0};
+    TONE_SUMS space = {0};
+    unsigned int bitSamples = 0;
+    unsigned int frameBits = 0;
+    unsigned int last = 0;
+    unsigned char* buffer = NULL;
+    unsigned int* starts = NULL;
+    unsigned int count = 0;
+    double squelch = 0;
+    bool markSeen = false;
+    int result = -1;
+
+    if(config == NULL || samples == NULL || outBuf == NULL || outBufLen == NULL || config->numStartBits == 0)
+    {
+        return -1;
+    }
+
+    // same rounding as fsk_transmit_buffer()
+    bitSamples = (unsigned int)(config->sampleRate / config->dataRate + 0.5f);
+    frameBits = config->numStartBits + 8 + config->numStopBits;
+
+    if(numSamples <= bitSamples * (frameBits + 1))
+    {
+        return -1;
+    }
+
+    // every frame takes at least the start and data bits
+    buffer = jo_malloc(numSamples / (bitSamples * (config->numStartBits + 8)) + 1);
+    if(buffer == NULL)
+    {
+        return -1;
+    }
+
+    if(frameStarts != NULL)
+    {
+        starts = jo_malloc((numSamples / (bitSamples * (config->numStartBits + 8)) + 1) * sizeof(unsigned int));
+        if(starts == NULL)
+        {
+            goto cleanup;
+        }
+    }
+
+    if(computeToneSums(&mark, samples, numSamples, config->markFreq, config->sampleRate) != 0 ||
+       computeToneSums(&space, samples, numSamples, config->spaceFreq, config->sampleRate) != 0)
+    {
+        goto cleanup;
+    }
+
+    last = numSamples - bitSamples;
+
+    for(unsigned int n = 0; n <= last; n += bitSamples / 4 + 1)
+    {
+        double energy = windowEnergy(&mark, n, bitSamples) + windowEnergy(&space, n, bitSamples);
+        squelch = energy > squelch ? energy : squelch;
+    }
+    squelch *= SQUELCH_LEVEL;
+
+    for(unsigned int n = 0; n <= last; n++)
+    {
+        double markEnergy = windowEnergy(&mark, n, bitSamples);
+        double spaceEnergy = windowEnergy(&space, n, bitSamples);
+        unsigned int start = 0;
+        unsigned int bits = 0;
+        bool framingError = false;
+
+        if(markEnergy + spaceEnergy < squelch)
+        {
+            markSeen = false;
+            continue;
+        }
+
+        if(markEnergy >= spaceEnergy)
+        {
+            markSeen = true;
+            continue;
+        }
+
+        if(!markSeen)
+        {
+            continue;
+        }
+
+        // the window straddling the mark to space edge is where the energies cross
+        start = n + bitSamples / 2;
+        if(start + frameBits * bitSamples > numSamples)
+        {
+            break;
+        }
+
+        for(unsigned int b = 0; b < frameBits; b++)
+        {
+            unsigned int position = start + b * bitSamples;
+            double bitMark = windowEnergy(&mark, position, bitSamples);
+            double bitSpace = windowEnergy(&space, position, bitSamples);
+            bool isMark = bitMark >= bitSpace;
+
+            // the carrier dropping out mid frame, e.g. the tail of a block
+            if(bitMark + bitSpace < squelch)
+            {
+                framingError = true;
+                break;
+            }
+
+            if(b < config->numStartBits)
+            {
+                framingError |= isMark;
+            }
+            else if(b < config->numStartBits + 8)
+            {
+                bits |= (isMark ? 1 : 0) << (b - config->numStartBits);
+            }
+            else
+            {
+                framingError |= !isMark;
+                break; // only the first stop bit has to be there
+            }
+        }
+
+        markSeen = false;
+
+        if(framingError)
+        {
+            continue;
+        }
+
+        if(bits != config->syncByte)
+        {
+            if(starts != NULL)
+            {
+                starts[count] = start;
+            }
+            buffer[count++] = (unsigned char)bits;
+        }
+
+        // continue in the first stop bit, the next start edge follows the last one
+        n = start + (config->numStartBits + 8) * bitSamples - 1;
+    }
+
+    *outBuf = buffer;
+    *outBufLen = count;
+    buffer = NULL;
+
+    if(frameStarts != NULL)
+    {
+        *frameStarts = starts;
+        starts = NULL;
+    }
+    result = 0;
+
+cleanup:
+    freeToneSums(&mark);
+    freeToneSums(&space);
+    jo_free(buffer);
+    jo_free(starts);
+    return result;
+}
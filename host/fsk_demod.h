@@ -0,0 +1,29 @@
+#pragma once
+
+/*
+ * Reference BFSK receiver for the host benchmarks. Non-coherent mark/space
+ * energy detector that resyncs on the start edge of every frame, the same
+ * approach minimodem takes on the PC side.
+ */
+
+typedef struct _DEMOD_CONFIG
+{
+    float dataRate;
+    unsigned int sampleRate;
+    float markFreq;
+    float spaceFreq;
+    unsigned int numStartBits; // at least 1, frames are found by their start edge
+    unsigned int numStopBits;
+    unsigned char syncByte; // dropped from the output
+} DEMOD_CONFIG, *PDEMOD_CONFIG;
+
+// demodulates samples into bytes
+// outBuf is allocated with jo_malloc and must be freed with jo_free
+// returns 0 on success
+int fskDemodulate(PDEMOD_CONFIG config, const float* samples, unsigned int numSamples,
+                  unsigned char** outBuf, unsigned int* outBufLen);
+
+// same as fskDemodulate() and also returns the sample each byte's first start
+// bit began at in frameStarts, allocated with jo_malloc like outBuf
+int fskDemodulateFrames(PDEMOD_CONFIG config, const float* samples, unsigned int numSamples,
+                        unsigned char** outBuf, unsigned int* outBufLen, unsigned int** frameStarts);
@@ -0,0 +1,107 @@
+/*
+ * Minimal stand-in for the Jo Engine / SGL headers so the transmit stack
+ * (saturn-minimodem.c, simple-tone-generator.c, simpleaudio.c, encode.c,
+ * libcorrect, md5 and miniz) can be built and run on a PC.
+ *
+ * Only what those files use is declared here. Anything that needs the
+ * Saturn's hardware (video, pads, backup memory, PCM playback) is either
+ * stubbed out or left undeclared on purpose.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/types.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define JO_NULL NULL
+
+//
+// memory
+//
+void* jo_malloc(unsigned int size);
+void jo_free(const void* const p);
+void jo_memset(const void* const ptr, const int value, unsigned int size);
+
+//
+// errors and text output
+//
+
+// prints to stderr and keeps going like a debug build of Jo Engine
+void jo_core_error(const char* const message, ...);
+
+// there is no screen, text output is discarded
+void jo_printf(const int x, const int y, const char* const format, ...);
+
+// number of jo_core_error() calls, lets host tools fail on any error
+unsigned int jo_host_error_count(void);
+
+//
+// fixed point math, same 16.16 layout as Jo Engine
+//
+typedef int jo_fixed;
+
+static inline jo_fixed jo_float2fixed(const float x)
+{
+    return (jo_fixed)(x * 65536.0f);
+}
+
+static inline float jo_fixed2float(const jo_fixed x)
+{
+    return (float)x / 65536.0f;
+}
+
+static inline int jo_fixed2int(const jo_fixed x)
+{
+    return x >> 16;
+}
+
+static inline jo_fixed jo_int2fixed(const int x)
+{
+    return x << 16;
+}
+
+// uses the C library sine. Jo Engine's table based version can differ
+// from this by one LSB in a handful of samples
+float jo_sin_radf(const float angle);
+
+//
+// input, there is no pad so nothing is ever pressed
+//
+typedef enum
+{
+    JO_KEY_UP,
+    JO_KEY_DOWN,
+    JO_KEY_LEFT,
+    JO_KEY_RIGHT,
+    JO_KEY_START,
+    JO_KEY_A,
+    JO_KEY_B,
+    JO_KEY_C,
+    JO_KEY_X,
+    JO_KEY_Y,
+    JO_KEY_Z,
+    JO_KEY_L,
+    JO_KEY_R,
+} jo_gamepad_keys;
+
+static inline bool jo_is_pad1_key_pressed(const jo_gamepad_keys key)
+{
+    (void)key;
+    return false;
+}
+
+//
+// backup devices, only needed for the GAME structure in main.h
+//
+typedef enum
+{
+    JoInternalMemoryBackup = 0,
+    JoCartridgeMemoryBackup = 1,
+    JoExternalDeviceBackup = 2,
+} jo_backup_device;
@@ -0,0 +1,56 @@
+/*
+ * Host implementations of the Jo Engine functions declared in host/jo/jo.h
+ */
+#include <jo/jo.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned int g_ErrorCount = 0;
+
+void* jo_malloc(unsigned int size)
+{
+    return malloc(size);
+}
+
+void jo_free(const void* const p)
+{
+    free((void*)p);
+}
+
+void jo_memset(const void* const ptr, const int value, unsigned int size)
+{
+    memset((void*)ptr, value, size);
+}
+
+void jo_core_error(const char* const message, ...)
+{
+    va_list args;
+
+    g_ErrorCount++;
+
+    va_start(args, message);
+    fprintf(stderr, "jo_core_error: ");
+    vfprintf(stderr, message, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+void jo_printf(const int x, const int y, const char* const format, ...)
+{
+    (void)x;
+    (void)y;
+    (void)format;
+}
+
+unsigned int jo_host_error_count(void)
+{
+    return g_ErrorCount;
+}
+
+// saturn-minimodem.c provides its own sinf() so go through the double version
+float jo_sin_radf(const float angle)
+{
+    return (float)sin((double)angle);
+}
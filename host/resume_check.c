@@ -0,0 +1,352 @@
+/*
+ * sgex-check-resume - round trip of a resumed transfer
+ *
+ * Encodes a file like sgex-tx, sends it resumed from a codeword through the
+ * modem and decodes the audio with the reference receiver. The rest is then
+ * joined to the codewords before the resume point the way sgex.py joins a
+ * resumed capture to the earlier one, and has to match what a full transfer
+ * would have sent:
+ *
+ *   sgex-check-resume [-c BYTES] [-s [CHECKPOINT:]CODEWORD] input
+ *
+ *   -c  stream the file in checkpoints of BYTES like sgex-tx -c
+ *   -s  where to resume like sgex-tx -s, defaults to the middle codeword
+ *       of the first checkpoint
+ *
+ * make check runs it on a save and on a checkpoint of a stream.
+ */
+#include <jo/jo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../main.h"
+#include "../encode.h"
+#include "../saturn-minimodem.h"
+#include "../arena.h"
+#include "../util.h"
+#include "fsk_demod.h"
+#include "wav.h"
+
+GAME g_Game = {0};
+
+// reverses escapeBuffer(), same rules as sgex.py
+// returns 0 on success, -1 on an invalid escape sequence
+static int unescapeBuffer(const unsigned char* inBuf, unsigned int inBufLen, unsigned char* outBuf, unsigned int* outBufLen)
+{
+    unsigned int count = 0;
+
+    for(unsigned int i = 0; i < inBufLen; i++)
+    {
+        if(inBuf[i] != ESCAPE_BYTE)
+        {
+            outBuf[count++] = inBuf[i];
+            continue;
+        }
+
+        if(i + 1 >= inBufLen)
+        {
+            return -1;
+        }
+
+        i++;
+        if(inBuf[i] == ESCAPE_BYTE)
+        {
+            outBuf[count++] = ESCAPE_BYTE;
+        }
+        else if(inBuf[i] == ESCAPE_SYNC_BYTE)
+        {
+            outBuf[count++] = SYNC_BYTE;
+        }
+        else
+        {
+            return -1;
+        }
+    }
+
+    *outBufLen = count;
+    return 0;
+}
+
+// reads the whole file into a jo_malloc'ed buffer with room for the headers in front
+static unsigned char* readFile(const char* filename, unsigned int* size)
+{
+    FILE* file = NULL;
+    unsigned char* buffer = NULL;
+    long length = 0;
+
+    file = fopen(filename, "rb");
+    if(file == NULL)
+    {
+        fprintf(stderr, "Error: could not open %s for reading\n", filename);
+        return NULL;
+    }
+
+    if(fseek(file, 0, SEEK_END) != 0 || (length = ftell(file)) <= 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        fprintf(stderr, "Error: could not get the size of %s\n", filename);
+        fclose(file);
+        return NULL;
+    }
+
+    buffer = jo_malloc(TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + length);
+    if(buffer == NULL || fread(buffer + TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE, 1, length, file) != (size_t)length)
+    {
+        fprintf(stderr, "Error: could not read %s\n", filename);
+        jo_free(buffer);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+    *size = (unsigned int)length;
+    return buffer;
+}
+
+// sends buffer through the modem and decodes it again with the reference receiver
+static int roundTrip(unsigned char* buffer, unsigned int bufferSize, unsigned char** received, unsigned int* receivedSize)
+{
+    char wavFilename[] = "/tmp/sgex-resume-XXXXXX";
+    MODEM_CONFIG config = {0};
+    DEMOD_CONFIG demod = {0};
+    float* samples = NULL;
+    unsigned int numSamples = 0;
+    unsigned int sampleRate = 0;
+    int fd = -1;
+    int result = 0;
+
+    fd = mkstemp(wavFilename);
+    if(fd < 0)
+    {
+        fprintf(stderr, "Error: could not create a temporary file\n");
+        return -1;
+    }
+    close(fd);
+
+    result = SaturnMinimodem_setOutputFile(wavFilename);
+    result |= SaturnMinimodem_init();
+    result |= SaturnMinimodem_initTransfer(buffer, bufferSize);
+    if(result == 0)
+    {
+        do
+        {
+            result = SaturnMinimodem_transfer();
+        } while(result == TRANSFER_PROGRESS || result == TRANSFER_BUSY);
+
+        result = (result == TRANSFER_COMPLETE) ? 0 : -1;
+    }
+
+    SaturnMinimodem_getConfig(&config);
+    SaturnMinimodem_close();
+
+    if(result == 0)
+    {
+        result = readWavFile(wavFilename, &samples, &numSamples, &sampleRate);
+    }
+    remove(wavFilename);
+
+    if(result != 0)
+    {
+        fprintf(stderr, "Error: failed to send the resumed stream\n");
+        return -1;
+    }
+
+    demod.dataRate = config.dataRate;
+    demod.sampleRate = sampleRate;
+    demod.markFreq = config.markFreq;
+    demod.spaceFreq = config.spaceFreq;
+    demod.numStartBits = config.numStartBits;
+    demod.numStopBits = config.numStopBits;
+    demod.syncByte = SYNC_BYTE;
+
+    result = fskDemodulate(&demod, samples, numSamples, received, receivedSize);
+    jo_free(samples);
+
+    return result;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: sgex-check-resume [-c BYTES] [-s [CHECKPOINT:]CODEWORD] input\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* inFilename = NULL;
+    unsigned int checkpointSize = 0;
+    unsigned int numCheckpoints = 0;
+    unsigned int checkpoint = 0;
+    unsigned int codeword = 0;
+    unsigned int numCodewords = 0;
+    unsigned char* arenaBase = NULL;
+    unsigned char* data = NULL;
+    unsigned int size = 0;
+    unsigned char* resumed = NULL;
+    unsigned int resumedSize = 0;
+    unsigned char* full = NULL;
+    unsigned int fullSize = 0;
+    unsigned char* received = NULL;
+    unsigned int receivedSize = 0;
+    unsigned char* rest = NULL;
+    unsigned int restSize = 0;
+    unsigned int prefixSize = 0;
+    unsigned int resumeAt = 0;
+    unsigned int errors = 0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+        {
+            checkpointSize = strtoul(argv[++i], NULL, 0);
+        }
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            char* end = NULL;
+
+            codeword = strtoul(argv[++i], &end, 0);
+            if(*end == ':')
+            {
+                checkpoint = codeword ? codeword - 1 : 0;
+                codeword = strtoul(end + 1, NULL, 0);
+            }
+        }
+        else if(inFilename == NULL)
+        {
+            inFilename = argv[i];
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if(inFilename == NULL)
+    {
+        usage();
+        return 1;
+    }
+
+    // same arena size the Saturn gets from LWRAM
+    arenaBase = jo_malloc(LWRAM_SIZE);
+    if(arenaBase == NULL || arenaInit(&g_Arena, arenaBase, LWRAM_SIZE) != 0)
+    {
+        fprintf(stderr, "Error: failed to allocate the transfer arena\n");
+        return 1;
+    }
+
+    data = readFile(inFilename, &size);
+    if(data == NULL)
+    {
+        return 1;
+    }
+
+    if(checkpointSize != 0)
+    {
+        numCheckpoints = (size + checkpointSize - 1) / checkpointSize;
+        if(numCheckpoints > 255 || checkpoint >= numCheckpoints)
+        {
+            fprintf(stderr, "Error: no checkpoint %u in %u bytes of %u byte checkpoints\n", checkpoint + 1, size, checkpointSize);
+            return 1;
+        }
+    }
+
+    if(initializeReedSolomon(RS_NUM_ROOTS) != 0)
+    {
+        return 1;
+    }
+
+    // the checkpoint like sgex-tx and the Saturn encode it
+    jo_memset(g_Game.saveFilename, 0, sizeof(g_Game.saveFilename));
+    strcpy(g_Game.saveFilename, "RESUME");
+    g_Game.transmissionData = data;
+    g_Game.integrity = numCheckpoints ? BIOS_STREAM_INTEGRITY : INTEGRITY_MD5;
+    g_Game.numCheckpoints = numCheckpoints;
+    g_Game.checkpoint = checkpoint;
+    g_Game.imageOffset = checkpoint * checkpointSize;
+    g_Game.saveFileData = data + TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + g_Game.imageOffset;
+    g_Game.saveFileSize = size - g_Game.imageOffset;
+    if(numCheckpoints && g_Game.saveFileSize > checkpointSize)
+    {
+        g_Game.saveFileSize = checkpointSize;
+    }
+
+    if(encodeTransmission() != 0)
+    {
+        return 1;
+    }
+
+    numCodewords = reedSolomonNumCodewords(g_Game.compressedSize);
+    if(codeword == 0)
+    {
+        codeword = numCodewords / 2;
+    }
+
+    if(codeword == 0 || encodeResume(codeword, &resumed, &resumedSize) != 0)
+    {
+        fprintf(stderr, "Error: can't resume from codeword %u of %u\n", codeword, numCodewords);
+        return 1;
+    }
+
+    // what a full transfer sends, without the escaping
+    prefixSize = numCheckpoints ? CHECKPOINT_MARKER_SIZE : 0;
+    full = jo_malloc(g_Game.encodedTransmissionSize);
+    if(full == NULL || unescapeBuffer(g_Game.encodedTransmissionData + prefixSize, g_Game.encodedTransmissionSize - prefixSize, full, &fullSize) != 0)
+    {
+        fprintf(stderr, "Error: the full transfer doesn't unescape\n");
+        return 1;
+    }
+
+    if(roundTrip(resumed, resumedSize, &received, &receivedSize) != 0)
+    {
+        fprintf(stderr, "Error: failed to decode the resumed stream\n");
+        return 1;
+    }
+
+    // [ESCAPE CHECKPOINT] ESCAPE RESUME, then the numbers and the codewords escaped together
+    if(receivedSize < prefixSize + 2 ||
+       (numCheckpoints && (received[0] != ESCAPE_BYTE || received[1] != ESCAPE_CHECKPOINT_BYTE)) ||
+       received[prefixSize] != ESCAPE_BYTE || received[prefixSize + 1] != ESCAPE_RESUME_BYTE)
+    {
+        fprintf(stderr, "Error: the resumed stream doesn't start with its markers\n");
+        return 1;
+    }
+
+    rest = jo_malloc(receivedSize);
+    if(rest == NULL ||
+       unescapeBuffer(received + prefixSize + 2, receivedSize - prefixSize - 2, rest, &restSize) != 0 ||
+       restSize < RESUME_MARKER_SIZE - 2)
+    {
+        fprintf(stderr, "Error: the resumed stream doesn't unescape\n");
+        return 1;
+    }
+
+    if(rest[0] != checkpoint || (unsigned int)((rest[1] << 8) | rest[2]) != codeword)
+    {
+        fprintf(stderr, "Error: resumed checkpoint %u codeword %u, expected %u and %u\n",
+                rest[0] + 1, (rest[1] << 8) | rest[2], checkpoint + 1, codeword);
+        return 1;
+    }
+
+    // joined after the codewords an earlier capture would hold
+    resumeAt = codeword * CODEWORD_SIZE;
+    restSize -= RESUME_MARKER_SIZE - 2;
+    for(unsigned int i = 0; i < restSize && resumeAt + i < fullSize; i++)
+    {
+        errors += rest[RESUME_MARKER_SIZE - 2 + i] != full[resumeAt + i];
+    }
+
+    printf("Checkpoint: %u of %u\n", checkpoint + 1, numCheckpoints ? numCheckpoints : 1);
+    printf("Codeword: %u of %u\n", codeword, numCodewords);
+    printf("Resumed Size: %u\n", resumedSize);
+    printf("Received: %u bytes, %u differ\n", restSize, errors);
+
+    if(resumeAt + restSize != fullSize || errors != 0 || jo_host_error_count() != 0)
+    {
+        fprintf(stderr, "Error: the joined stream is %u bytes, the full transfer is %u\n", resumeAt + restSize, fullSize);
+        return 1;
+    }
+
+    printf("Joined stream matches the full transfer\n");
+    return 0;
+}
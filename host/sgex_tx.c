@@ -0,0 +1,469 @@
+/*
+ * sgex-tx - host build of the Saturn transmitter
+ *
+ * Runs a file through the same encode pipeline and modem code as the Saturn
+ * and writes the audio to a .wav file instead of the sound hardware:
+ *
+ *   sgex-tx [-n SAVENAME] [-i md5|crc32|both] [-c BYTES] [-k] [-s [CHECKPOINT:]CODEWORD] [-t CODE] [-p PROFILE] [-g BITS] [-r] input output.wav
+ *   sgex-tx [-t CODE] -w output.wav
+ *
+ *   -n  filename put in the transmission header (defaults to the input name)
+ *   -i  integrity checks to send (default md5, like saves on the Saturn)
+ *   -c  stream the file in checkpoints of BYTES like the whole BIOS dump,
+ *       sent with a CRC-32 each and the running image MD5
+ *   -k  send only the known image record if the file is in known.c
+ *   -s  resume from the codeword (of the checkpoint, counted from 1 like the
+ *       Saturn shows it) sgex.py asked for
+ *   -t  use the tone plan of a code from sgex-sweep, like entering it on the test screen
+ *   -p  send with a speed profile (conservative, fast or experimental) like
+ *       picking it on the main screen, announced ahead of the transmission
+ *   -g  sweep between the tones over BITS of a bit (0 to 1) instead of
+ *       switching at once, like the shaping row of the test screen
+ *   -r  send the file as is, like the "Test Audio Transmission" screen
+ *   -w  play the calibration sweep of the test screen
+ *
+ * The .wav can be decoded with the usual minimodem + sgex.py steps.
+ */
+#include <jo/jo.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../main.h"
+#include "../encode.h"
+#include "../saturn-minimodem.h"
+#include "../arena.h"
+#include "../util.h"
+#include "../known.h"
+#include "../toneplan.h"
+#include "../speed.h"
+
+GAME g_Game = {0};
+
+// reads the whole file into a jo_malloc'ed buffer
+static unsigned char* readFile(const char* filename, unsigned int* size)
+{
+    FILE* file = NULL;
+    unsigned char* buffer = NULL;
+    long length = 0;
+
+    file = fopen(filename, "rb");
+    if(file == NULL)
+    {
+        fprintf(stderr, "Error: could not open %s for reading\n", filename);
+        return NULL;
+    }
+
+    if(fseek(file, 0, SEEK_END) != 0 || (length = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        fprintf(stderr, "Error: could not get the size of %s\n", filename);
+        fclose(file);
+        return NULL;
+    }
+
+    // leave room in front for the transmission and BUP headers
+    buffer = jo_malloc(TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + length + 1);
+    if(buffer == NULL)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    if(fread(buffer + TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE, 1, length, file) != (size_t)length)
+    {
+        fprintf(stderr, "Error: could not read %s\n", filename);
+        jo_free(buffer);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+    *size = (unsigned int)length;
+    return buffer;
+}
+
+// strips the directory and keeps the name within MAX_SAVE_FILENAME
+static void setSaveFilename(const char* path)
+{
+    const char* name = strrchr(path, '/');
+
+    name = (name != NULL) ? name + 1 : path;
+
+    jo_memset(g_Game.saveFilename, 0, sizeof(g_Game.saveFilename));
+    strncpy(g_Game.saveFilename, name, sizeof(g_Game.saveFilename) - 1);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: sgex-tx [-n SAVENAME] [-i md5|crc32|both] [-c BYTES] [-k] [-s [CHECKPOINT:]CODEWORD] [-t CODE] [-p PROFILE] [-g BITS] [-r] input output.wav\n");
+    fprintf(stderr, "       sgex-tx [-t CODE] -w output.wav\n");
+}
+
+// no frame loop on the host, just keep transferring until done
+static int transmit(unsigned char* buffer, unsigned int size)
+{
+    int result = 0;
+
+    result = SaturnMinimodem_initTransfer(buffer, size);
+    if(result != 0)
+    {
+        return result;
+    }
+
+    do
+    {
+        result = SaturnMinimodem_transfer();
+    } while(result == TRANSFER_PROGRESS || result == TRANSFER_BUSY);
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    const char* inFilename = NULL;
+    char* outFilename = NULL;
+    const char* saveName = NULL;
+    bool rawMode = false;
+    bool sweep = false;
+    MODEM_CONFIG config = {0};
+    TONE_PLAN tonePlan = {0};
+    bool useTonePlan = false;
+    float transitionBits = 0;
+    SPEED_PROFILE speed = {0};
+    bool useSpeed = false;
+    unsigned char announcement[SPEED_ANNOUNCE_MAX_SIZE] = {0};
+    unsigned int announcementSize = 0;
+    unsigned char integrity = INTEGRITY_MD5;
+    unsigned int checkpointSize = 0;
+    unsigned int numCheckpoints = 0;
+    bool checkKnown = false;
+    unsigned int startCheckpoint = 0;
+    unsigned int startCodeword = 0;
+    unsigned char* arenaBase = NULL;
+    unsigned char* data = NULL;
+    unsigned int size = 0;
+    int result = 0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            saveName = argv[++i];
+        }
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(strcmp(argv[i], "md5") == 0)
+            {
+                integrity = INTEGRITY_MD5;
+            }
+            else if(strcmp(argv[i], "crc32") == 0)
+            {
+                integrity = INTEGRITY_CRC32;
+            }
+            else if(strcmp(argv[i], "both") == 0)
+            {
+                integrity = INTEGRITY_BOTH;
+            }
+            else
+            {
+                usage();
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+        {
+            checkpointSize = strtoul(argv[++i], NULL, 0);
+            integrity = BIOS_STREAM_INTEGRITY;
+        }
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            char* end = NULL;
+
+            startCodeword = strtoul(argv[++i], &end, 0);
+            if(*end == ':')
+            {
+                startCheckpoint = startCodeword ? startCodeword - 1 : 0;
+                startCodeword = strtoul(end + 1, NULL, 0);
+            }
+        }
+        else if(strcmp(argv[i], "-k") == 0)
+        {
+            checkKnown = true;
+        }
+        else if(strcmp(argv[i], "-r") == 0)
+        {
+            rawMode = true;
+        }
+        else if(strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            sweep = true;
+            outFilename = argv[++i];
+        }
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            if(tonePlanDecode(strtoul(argv[++i], NULL, 10), &tonePlan) != 0)
+            {
+                fprintf(stderr, "Error: %s is not a valid tone plan code\n", argv[i]);
+                return 1;
+            }
+            useTonePlan = true;
+        }
+        else if(strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+        {
+            transitionBits = strtof(argv[++i], NULL);
+            if(transitionBits < 0 || transitionBits > 1)
+            {
+                fprintf(stderr, "Error: %s is not between 0 and 1\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            i++;
+            for(unsigned int p = 0; p < SPEED_NUM_PROFILES; p++)
+            {
+                if(strcasecmp(argv[i], SPEED_PROFILES[p].name) == 0)
+                {
+                    speed = SPEED_PROFILES[p];
+                    useSpeed = true;
+                }
+            }
+
+            if(useSpeed == false)
+            {
+                fprintf(stderr, "Error: %s is not a speed profile\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(inFilename == NULL)
+        {
+            inFilename = argv[i];
+        }
+        else if(outFilename == NULL)
+        {
+            outFilename = argv[i];
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    // the sweep has no input
+    if((inFilename == NULL && sweep == false) || (inFilename != NULL && sweep) || outFilename == NULL)
+    {
+        usage();
+        return 1;
+    }
+
+    // same arena size the Saturn gets from LWRAM
+    arenaBase = jo_malloc(LWRAM_SIZE);
+    if(arenaBase == NULL || arenaInit(&g_Arena, arenaBase, LWRAM_SIZE) != 0)
+    {
+        fprintf(stderr, "Error: failed to allocate the transfer arena\n");
+        return 1;
+    }
+
+    if(useTonePlan || transitionBits > 0)
+    {
+        SaturnMinimodem_getConfig(&config);
+        if(useTonePlan)
+        {
+            config.dataRate = tonePlan.dataRate;
+            config.markFreq = tonePlan.markFreq;
+            config.spaceFreq = tonePlan.spaceFreq;
+        }
+        config.transitionBits = transitionBits;
+        if(SaturnMinimodem_setConfig(&config) != 0)
+        {
+            return 1;
+        }
+    }
+
+    if(sweep)
+    {
+        if(SaturnMinimodem_setOutputFile(outFilename) != 0 || SaturnMinimodem_init() != 0 ||
+           SaturnMinimodem_initSweep(SWEEP_START_FREQ, SWEEP_STEP_FREQ, SWEEP_NUM_STEPS, SWEEP_STEP_MS, SWEEP_GAP_MS) != 0)
+        {
+            fprintf(stderr, "Error: failed to start the sweep\n");
+            return 1;
+        }
+
+        do
+        {
+            result = SaturnMinimodem_transfer();
+        } while(result == TRANSFER_PROGRESS || result == TRANSFER_BUSY);
+
+        SaturnMinimodem_close();
+
+        if(result != TRANSFER_COMPLETE || jo_host_error_count() != 0)
+        {
+            fprintf(stderr, "Error: sweep failed\n");
+            return 1;
+        }
+
+        printf("Wrote %s\n", outFilename);
+        return 0;
+    }
+
+    data = readFile(inFilename, &size);
+    if(data == NULL)
+    {
+        return 1;
+    }
+
+    if(size == 0)
+    {
+        fprintf(stderr, "Error: save file size is invalid %u\n", size);
+        return 1;
+    }
+
+    if(checkpointSize != 0)
+    {
+        numCheckpoints = (size + checkpointSize - 1) / checkpointSize;
+        if(rawMode || numCheckpoints > 255)
+        {
+            fprintf(stderr, "Error: can't stream %u bytes in %u byte checkpoints\n", size, checkpointSize);
+            return 1;
+        }
+    }
+
+    result = SaturnMinimodem_setOutputFile(outFilename);
+    if(result != 0)
+    {
+        return 1;
+    }
+
+    result = SaturnMinimodem_init();
+    if(result != 0)
+    {
+        fprintf(stderr, "Error: failed to initialize minimodem\n");
+        return 1;
+    }
+
+    result = initializeReedSolomon(RS_NUM_ROOTS);
+    if(result != 0)
+    {
+        return 1;
+    }
+
+    if(useSpeed && speedApply(&speed) != 0)
+    {
+        return 1;
+    }
+
+    if(rawMode)
+    {
+        result = transmit(data + TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE, size);
+    }
+    else
+    {
+        setSaveFilename(saveName != NULL ? saveName : inFilename);
+        g_Game.transmissionData = data;
+        g_Game.integrity = integrity;
+        g_Game.numCheckpoints = numCheckpoints;
+
+        // like the Saturn, a known stream collapses into one checkpoint with only the record
+        if(checkKnown)
+        {
+            unsigned char md5Hash[MD5_HASH_SIZE] = {0};
+
+            calculateMD5Hash(data + TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE, size, md5Hash);
+            g_Game.knownImage = knownImageFind(md5Hash, size);
+            if(g_Game.knownImage != 0 && numCheckpoints != 0)
+            {
+                numCheckpoints = 1;
+                checkpointSize = size;
+                g_Game.numCheckpoints = 1;
+            }
+        }
+
+        // one pass for a save, one per checkpoint when streaming
+        for(unsigned int i = startCheckpoint; i < (numCheckpoints ? numCheckpoints : 1); i++)
+        {
+            unsigned char* buffer = NULL;
+            unsigned int bufferSize = 0;
+
+            arenaRelease(&g_Arena, 0);
+
+            g_Game.checkpoint = i;
+            g_Game.imageOffset = i * checkpointSize;
+            g_Game.saveFileData = data + TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + g_Game.imageOffset;
+            g_Game.saveFileSize = numCheckpoints ? size - g_Game.imageOffset : size;
+            if(numCheckpoints && g_Game.saveFileSize > checkpointSize)
+            {
+                g_Game.saveFileSize = checkpointSize;
+            }
+
+            result = encodeTransmission();
+            if(result != 0)
+            {
+                return 1;
+            }
+
+            buffer = g_Game.encodedTransmissionData;
+            bufferSize = g_Game.encodedTransmissionSize;
+
+            // the checkpoints after the one resumed go out in full
+            if(i == startCheckpoint && startCodeword != 0 && encodeResume(startCodeword, &buffer, &bufferSize) != 0)
+            {
+                return 1;
+            }
+
+            // announced once like the Saturn, the checkpoints after it follow unattended
+            if(i == startCheckpoint && (speedAnnouncement(announcement, &announcementSize) != 0 ||
+                                        SaturnMinimodem_setAnnouncement(announcement, announcementSize) != 0))
+            {
+                return 1;
+            }
+
+            result = transmit(buffer, bufferSize);
+            if(result != TRANSFER_COMPLETE)
+            {
+                break;
+            }
+        }
+    }
+
+    SaturnMinimodem_close();
+
+    if(result != TRANSFER_COMPLETE || jo_host_error_count() != 0)
+    {
+        fprintf(stderr, "Error: transfer failed\n");
+        return 1;
+    }
+
+    if(!rawMode)
+    {
+        printf("Filename: %s\n", g_Game.saveFilename);
+        printf("Size: %u\n", numCheckpoints ? size : g_Game.saveFileSize);
+        if(numCheckpoints)
+        {
+            printf("Checkpoints: %u\n", numCheckpoints);
+        }
+        if(g_Game.knownImage)
+        {
+            printf("Known Image: %s\n", knownImageName(g_Game.knownImage));
+        }
+        if(integrity & (INTEGRITY_MD5 | INTEGRITY_IMAGE_MD5))
+        {
+            printf("MD5: ");
+            for(unsigned int i = 0; i < MD5_HASH_SIZE; i++)
+            {
+                printf("%02x", g_Game.md5Hash[i]);
+            }
+            printf("\n");
+        }
+        if(integrity & INTEGRITY_CRC32)
+        {
+            printf("CRC32: %08x\n", g_Game.crc);
+        }
+        printf("Compressed Size: %u\n", g_Game.compressedSize);
+        printf("Total Size: %u\n", g_Game.encodedTransmissionSize);
+        printf("Arena Peak: %u (%u fallbacks)\n", g_Arena.peak, g_Arena.fallbacks);
+    }
+    printf("Wrote %s\n", outFilename);
+
+    return 0;
+}
@@ -0,0 +1,307 @@
+/*
+ * sgex-sweep - picks a tone plan from the test screen's calibration sweep
+ *
+ * Measures the level and the noise of the line at each step of the sweep
+ * and prints the code of the fastest tone plan that fits the flat, quiet
+ * part of the response. Enter the code on the test screen:
+ *
+ *   sgex-sweep [-v] capture.wav
+ *
+ *   -v  print the level and noise of every step
+ *
+ * The capture is a 16-bit mono .wav of the line in, e.g.
+ * arecord -f S16_LE -c 1 -r 44100 capture.wav, started before the sweep.
+ *
+ * The noise is measured in the gaps of silence between the steps. Both are
+ * measured over SWEEP_GAP_MS windows so the SNR is per ~1000/SWEEP_GAP_MS Hz.
+ * A plan fits when every step from a quarter of the baud rate below the mark
+ * tone to a quarter above the space tone is within FLATNESS_DB of the
+ * loudest step and has at least MIN_SNR_DB.
+ */
+#include <jo/jo.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../main.h"
+#include "../toneplan.h"
+#include "wav.h"
+
+#define ONSET_WINDOW_MS         5
+#define ONSET_LEVEL             0.1 // of the loudest window, where the sweep starts
+
+#define FLATNESS_DB             6.0
+#define MIN_SNR_DB              20.0
+
+GAME g_Game = {0};
+
+typedef struct _SWEEP_STEP
+{
+    double level; // tone power
+    double noise; // power at the step's frequency in the gaps
+} SWEEP_STEP, *PSWEEP_STEP;
+
+// power at freq over [start, start + length), normalized so it doesn't depend on length
+static double goertzel(const float* samples, unsigned int start, unsigned int length, double freq, unsigned int sampleRate)
+{
+    double coeff = 2.0 * cos(2.0 * M_PI * freq / sampleRate);
+    double s1 = 0;
+    double s2 = 0;
+
+    for(unsigned int i = 0; i < length; i++)
+    {
+        double s0 = samples[start + i] + coeff * s1 - s2;
+
+        s2 = s1;
+        s1 = s0;
+    }
+
+    return (s1 * s1 + s2 * s2 - coeff * s1 * s2) / ((double)length * length);
+}
+
+// the first window louder than ONSET_LEVEL of the loudest
+static int findOnset(const float* samples, unsigned int numSamples, unsigned int sampleRate, unsigned int* onset)
+{
+    unsigned int window = sampleRate * ONSET_WINDOW_MS / 1000;
+    double loudest = 0;
+
+    for(unsigned int start = 0; start + window <= numSamples; start += window)
+    {
+        double power = 0;
+
+        for(unsigned int i = start; i < start + window; i++)
+        {
+            power += samples[i] * samples[i];
+        }
+        loudest = power > loudest ? power : loudest;
+    }
+
+    if(loudest == 0)
+    {
+        return -1;
+    }
+
+    for(unsigned int start = 0; start + window <= numSamples; start += window)
+    {
+        double power = 0;
+
+        for(unsigned int i = start; i < start + window; i++)
+        {
+            power += samples[i] * samples[i];
+        }
+
+        if(power >= loudest * ONSET_LEVEL)
+        {
+            *onset = start;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static int measureSteps(const float* samples, unsigned int numSamples, unsigned int sampleRate, unsigned int onset, SWEEP_STEP* steps)
+{
+    unsigned int stepSamples = sampleRate * SWEEP_STEP_MS / 1000;
+    unsigned int gapSamples = sampleRate * SWEEP_GAP_MS / 1000;
+    unsigned int window = gapSamples / 2;
+
+    if(onset + SWEEP_NUM_STEPS * (stepSamples + gapSamples) > numSamples)
+    {
+        fprintf(stderr, "Error: the capture ends before the sweep does\n");
+        return -1;
+    }
+
+    for(unsigned int k = 0; k < SWEEP_NUM_STEPS; k++)
+    {
+        unsigned int stepStart = onset + k * (stepSamples + gapSamples);
+        double noise = 0;
+
+        // the middle of the step, away from where the tone starts and stops
+        steps[k].level = goertzel(samples, stepStart + (stepSamples - window) / 2, window, sweepStepFreq(k), sampleRate);
+
+        // the middle of every gap, at this step's frequency
+        for(unsigned int g = 0; g < SWEEP_NUM_STEPS; g++)
+        {
+            unsigned int gapStart = onset + g * (stepSamples + gapSamples) + stepSamples;
+
+            noise += goertzel(samples, gapStart + (gapSamples - window) / 2, window, sweepStepFreq(k), sampleRate);
+        }
+        steps[k].noise = noise / SWEEP_NUM_STEPS;
+    }
+
+    return 0;
+}
+
+static double decibels(double ratio)
+{
+    return ratio > 0 ? 10 * log10(ratio) : -200;
+}
+
+// worst SNR over the band a plan takes up, -1 if part of it isn't flat or quiet enough
+static double planMargin(PTONE_PLAN plan, SWEEP_STEP* steps, double loudest)
+{
+    double low = plan->markFreq - plan->dataRate / 4;
+    double high = plan->spaceFreq + plan->dataRate / 4;
+    double worst = 1e9;
+
+    if(low < SWEEP_START_FREQ || high > sweepStepFreq(SWEEP_NUM_STEPS - 1))
+    {
+        return -1;
+    }
+
+    for(unsigned int k = 0; k < SWEEP_NUM_STEPS; k++)
+    {
+        double snr = 0;
+
+        if(sweepStepFreq(k) < low || sweepStepFreq(k) > high)
+        {
+            continue;
+        }
+
+        snr = decibels(steps[k].level / steps[k].noise);
+        if(decibels(steps[k].level / loudest) < -FLATNESS_DB || snr < MIN_SNR_DB)
+        {
+            return -1;
+        }
+
+        worst = snr < worst ? snr : worst;
+    }
+
+    return worst;
+}
+
+// the fastest rate that fits anywhere, at the mark tone with the most margin
+static int choosePlan(SWEEP_STEP* steps, PTONE_PLAN best)
+{
+    double loudest = 0;
+
+    for(unsigned int k = 0; k < SWEEP_NUM_STEPS; k++)
+    {
+        loudest = steps[k].level > loudest ? steps[k].level : loudest;
+    }
+
+    for(int r = TONE_PLAN_NUM_RATES - 1; r >= 0; r--)
+    {
+        double bestMargin = -1;
+
+        for(unsigned int k = 0; k < SWEEP_NUM_STEPS; k++)
+        {
+            TONE_PLAN plan = {0};
+            double margin = 0;
+
+            plan.dataRate = TONE_PLAN_RATES[r];
+            plan.markFreq = sweepStepFreq(k);
+            plan.spaceFreq = tonePlanSpaceFreq(plan.dataRate, plan.markFreq);
+
+            margin = planMargin(&plan, steps, loudest);
+            if(margin > bestMargin)
+            {
+                bestMargin = margin;
+                *best = plan;
+            }
+        }
+
+        if(bestMargin >= 0)
+        {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: sgex-sweep [-v] capture.wav\n");
+}
+
+int main(int argc, char** argv)
+{
+    SWEEP_STEP steps[SWEEP_NUM_STEPS] = {0};
+    TONE_PLAN plan = {0};
+    const char* filename = NULL;
+    bool verbose = false;
+    float* samples = NULL;
+    unsigned int numSamples = 0;
+    unsigned int sampleRate = 0;
+    unsigned int onset = 0;
+    unsigned int code = 0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else if(filename == NULL)
+        {
+            filename = argv[i];
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if(filename == NULL)
+    {
+        usage();
+        return 1;
+    }
+
+    if(readWavFile(filename, &samples, &numSamples, &sampleRate) != 0)
+    {
+        fprintf(stderr, "Error: could not read %s\n", filename);
+        return 1;
+    }
+
+    if(findOnset(samples, numSamples, sampleRate, &onset) != 0)
+    {
+        fprintf(stderr, "Error: the capture is silent\n");
+        jo_free(samples);
+        return 1;
+    }
+
+    if(measureSteps(samples, numSamples, sampleRate, onset, steps) != 0)
+    {
+        jo_free(samples);
+        return 1;
+    }
+    jo_free(samples);
+
+    printf("Sweep starts at %.2f s\n", (double)onset / sampleRate);
+
+    if(verbose)
+    {
+        double loudest = 0;
+
+        for(unsigned int k = 0; k < SWEEP_NUM_STEPS; k++)
+        {
+            loudest = steps[k].level > loudest ? steps[k].level : loudest;
+        }
+
+        printf("\n%8s %10s %8s\n", "Hz", "level dB", "SNR dB");
+        for(unsigned int k = 0; k < SWEEP_NUM_STEPS; k++)
+        {
+            printf("%8.0f %10.1f %8.1f\n", sweepStepFreq(k), decibels(steps[k].level / loudest),
+                   decibels(steps[k].level / steps[k].noise));
+        }
+    }
+    printf("\n");
+
+    if(choosePlan(steps, &plan) != 0 || tonePlanEncode(&plan, &code) != 0)
+    {
+        fprintf(stderr, "Error: no tone plan fits, check the cable and the line in level\n");
+        return 1;
+    }
+
+    printf("Tone plan: %.0f baud, mark %.0f Hz, space %.0f Hz\n", plan.dataRate, plan.markFreq, plan.spaceFreq);
+    printf("Code: %04u\n\n", code);
+    printf("Enter the code on the test screen, check it with the PRBS test and sgex-ber -t %04u,\n", code);
+    printf("then receive with: minimodem -R 44100 -r %.0f -M %.0f -S %.0f --sync 0xAB --startbits 4 --stopbits 4\n",
+           plan.dataRate, plan.markFreq, plan.spaceFreq);
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * .wav reader for the host tools, the counterpart of simpleaudio-wav.c
+ */
+#include <jo/jo.h>
+#include <stdio.h>
+
+#include "wav.h"
+
+static unsigned int get_le16(const unsigned char* src)
+{
+    return src[0] | (src[1] << 8);
+}
+
+static unsigned int get_le32(const unsigned char* src)
+{
+    return src[0] | (src[1] << 8) | (src[2] << 16) | ((unsigned int)src[3] << 24);
+}
+
+int readWavFile(const char* filename, float** samples, unsigned int* numSamples, unsigned int* sampleRate)
+{
+    FILE* file = NULL;
+    unsigned char chunk[8] = {0};
+    unsigned char fmt[16] = {0};
+    unsigned int channels = 0;
+    unsigned int bitsPerSample = 0;
+    unsigned int rate = 0;
+    float* buffer = NULL;
+
+    if(filename == NULL || samples == NULL || numSamples == NULL || sampleRate == NULL)
+    {
+        return -1;
+    }
+
+    file = fopen(filename, "rb");
+    if(file == NULL)
+    {
+        jo_core_error("Failed to open %s", filename);
+        return -1;
+    }
+
+    if(fread(chunk, 1, 8, file) != 8 || memcmp(chunk, "RIFF", 4) != 0 ||
+       fread(chunk, 1, 4, file) != 4 || memcmp(chunk, "WAVE", 4) != 0)
+    {
+        jo_core_error("%s is not a .wav file", filename);
+        fclose(file);
+        return -1;
+    }
+
+    // walk the chunks until we find the samples
+    while(fread(chunk, 1, 8, file) == 8)
+    {
+        unsigned int chunkSize = get_le32(chunk + 4);
+
+        if(memcmp(chunk, "fmt ", 4) == 0)
+        {
+            if(chunkSize < sizeof(fmt) || fread(fmt, 1, sizeof(fmt), file) != sizeof(fmt))
+            {
+                break;
+            }
+
+            channels = get_le16(fmt + 2);
+            rate = get_le32(fmt + 4);
+            bitsPerSample = get_le16(fmt + 14);
+
+            if(get_le16(fmt) != 1 || channels != 1 || bitsPerSample != 16)
+            {
+                jo_core_error("%s must be 16-bit mono PCM", filename);
+                break;
+            }
+
+            fseek(file, chunkSize - sizeof(fmt) + (chunkSize & 1), SEEK_CUR);
+        }
+        else if(memcmp(chunk, "data", 4) == 0)
+        {
+            unsigned int count = chunkSize / 2;
+
+            if(rate == 0)
+            {
+                break;
+            }
+
+            buffer = jo_malloc(count * sizeof(float) + 1);
+            if(buffer == NULL)
+            {
+                break;
+            }
+
+            for(unsigned int i = 0; i < count; i++)
+            {
+                unsigned char le[2];
+
+                if(fread(le, 1, 2, file) != 2)
+                {
+                    count = i;
+                    break;
+                }
+
+                buffer[i] = (short)get_le16(le) / 32768.0f;
+            }
+
+            fclose(file);
+
+            *samples = buffer;
+            *numSamples = count;
+            *sampleRate = rate;
+            return 0;
+        }
+        else
+        {
+            fseek(file, chunkSize + (chunkSize & 1), SEEK_CUR);
+        }
+    }
+
+    jo_core_error("Failed to read samples from %s", filename);
+    fclose(file);
+    return -1;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// loads a 16-bit PCM .wav file as floats in [-1.0, 1.0]
+// mono files only, that's all the transmitter produces
+// samples is allocated with jo_malloc and must be freed with jo_free
+// returns 0 on success
+int readWavFile(const char* filename, float** samples, unsigned int* numSamples, unsigned int* sampleRate);
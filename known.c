@@ -0,0 +1,55 @@
+#include <jo/jo.h>
+#include "main.h"
+#include "known.h"
+
+// MD5s of the BIOS dumps most emulators ask for
+// saves seen on many consoles can be added the same way
+static const KNOWN_IMAGE g_KnownImages[] =
+{
+    {"BIOS JP v1.00", BIOS_SIZE, {0xaf, 0x58, 0x28, 0xfd, 0xff, 0x51, 0x38, 0x4f, 0x99, 0xb3, 0xc4, 0x92, 0x6b, 0xe2, 0x77, 0x62}},
+    {"BIOS JP v1.01", BIOS_SIZE, {0x85, 0xec, 0x9c, 0xa4, 0x7d, 0x8f, 0x68, 0x07, 0x71, 0x81, 0x51, 0xcb, 0xcc, 0xa8, 0xb9, 0x64}},
+    {"BIOS US/EU v1.00a", BIOS_SIZE, {0x32, 0x40, 0x87, 0x2c, 0x70, 0x98, 0x4b, 0x6c, 0xbf, 0xda, 0x15, 0x86, 0xca, 0xb6, 0x8d, 0xbe}},
+};
+
+#define NUM_KNOWN_IMAGES (sizeof(g_KnownImages) / sizeof(g_KnownImages[0]))
+
+bool knownImageHasSize(unsigned int size)
+{
+    for(unsigned int i = 0; i < NUM_KNOWN_IMAGES; i++)
+    {
+        if(g_KnownImages[i].size == size)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+unsigned int knownImageFind(const unsigned char* md5Hash, unsigned int size)
+{
+    if(md5Hash == NULL)
+    {
+        return 0;
+    }
+
+    for(unsigned int i = 0; i < NUM_KNOWN_IMAGES; i++)
+    {
+        if(g_KnownImages[i].size == size && memcmp(g_KnownImages[i].md5Hash, md5Hash, MD5_HASH_SIZE) == 0)
+        {
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+const char* knownImageName(unsigned int index)
+{
+    if(index == 0 || index > NUM_KNOWN_IMAGES)
+    {
+        return NULL;
+    }
+
+    return g_KnownImages[index - 1].name;
+}
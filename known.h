@@ -0,0 +1,29 @@
+#pragma once
+#include <jo/jo.h>
+#include "main.h"
+
+/*
+ * Images most consoles already have, like the stock BIOS revisions. When the
+ * selected data matches one only a known image record is sent: the headers
+ * and the usual integrity trailer without the data. sgex.py rebuilds the file
+ * from its library of reference files and checks it against the trailer.
+ *
+ * Entries are matched on size and MD5. A wrong or missing entry only means
+ * the data is sent in full.
+ */
+
+typedef struct _KNOWN_IMAGE
+{
+    const char* name; // shown on screen
+    unsigned int size;
+    unsigned char md5Hash[MD5_HASH_SIZE];
+} KNOWN_IMAGE, *PKNOWN_IMAGE;
+
+// true if a known image is size bytes, there's no need to hash the data otherwise
+bool knownImageHasSize(unsigned int size);
+
+// returns the 1 based index of the matching known image, 0 if there is none
+unsigned int knownImageFind(const unsigned char* md5Hash, unsigned int size);
+
+// the name of a knownImageFind() index, NULL for 0 or an invalid index
+const char* knownImageName(unsigned int index);
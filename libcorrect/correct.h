@@ -10,13 +10,16 @@ typedef ptrdiff_t ssize_t;
 #endif
 */
 
+#ifndef SGEX_HOST
 typedef unsigned int size_t;
 typedef int ssize_t;
+#endif
 typedef unsigned short uint16_t;
 typedef unsigned char uint8_t;
 
-
+#ifndef SGEX_HOST
 void *memcpy(void *dest, const void *src, unsigned int n);
+#endif
 
 // Convolutional Codes
 
@@ -1,6 +1,7 @@
 #ifndef CORRECT_REED_SOLOMON_FIELD
 #define CORRECT_REED_SOLOMON_FIELD
 #include "reed-solomon.h"
+#include "../arena.h"
 
 #define UNUSED(x) (void)(x)
 
@@ -31,8 +32,9 @@ static inline field_t field_create(field_operation_t primitive_poly) {
     // bits are in GF(2), compute alpha^val in GF(2^8)
     // exp should be of size 512 so that it can hold a "wraparound" which prevents some modulo ops
     // log should be of size 256. no wraparound here, the indices into this table are field elements
-    field_element_t *exp = jo_malloc(512 * sizeof(field_element_t));
-    field_logarithm_t *log = jo_malloc(256 * sizeof(field_logarithm_t));
+    // looked up for every byte encoded, keep them in HWRAM
+    field_element_t *exp = regionAlloc(MEMORY_REGION_HOT, 512 * sizeof(field_element_t));
+    field_logarithm_t *log = regionAlloc(MEMORY_REGION_HOT, 256 * sizeof(field_logarithm_t));
 
     // assume alpha is a primitive element, p(x) (primitive_poly) irreducible in GF(2^8)
     // addition is xor
@@ -64,8 +66,8 @@ static inline field_t field_create(field_operation_t primitive_poly) {
 }
 
 static inline void field_destroy(field_t field) {
-    jo_free(*(field_element_t **)&field.exp);
-    jo_free(*(field_element_t **)&field.log);
+    regionFree(MEMORY_REGION_HOT, *(field_element_t **)&field.exp);
+    regionFree(MEMORY_REGION_HOT, *(field_element_t **)&field.log);
 }
 
 static inline field_element_t field_add(field_t field, field_element_t l, field_element_t r) {
@@ -2,13 +2,13 @@
 
 polynomial_t polynomial_create(unsigned int order) {
     polynomial_t polynomial;
-    polynomial.coeff = jo_malloc(sizeof(field_element_t) * (order + 1));
+    polynomial.coeff = regionAlloc(MEMORY_REGION_HOT, sizeof(field_element_t) * (order + 1));
     polynomial.order = order;
     return polynomial;
 }
 
 void polynomial_destroy(polynomial_t polynomial) {
-    jo_free(polynomial.coeff);
+    regionFree(MEMORY_REGION_HOT, polynomial.coeff);
 }
 
 // if you want a full multiplication, then make res.order = l.order + r.order
@@ -215,16 +215,16 @@ polynomial_t polynomial_create_from_roots(field_t field, unsigned int nroots, fi
     unsigned int order = nroots;
     polynomial_t l;
     l.order = 1;
-    l.coeff = jo_malloc(2 * sizeof(field_element_t));
+    l.coeff = regionAlloc(MEMORY_REGION_HOT, 2 * sizeof(field_element_t));
     jo_memset(l.coeff, 0, 2 * sizeof(field_element_t));
 
     polynomial_t r[2];
     // we'll keep two temporary stores of rightside polynomial
     // each time through the loop, we take the previous result and use it as new rightside
     // swap back and forth (prevents the need for a copy)
-    r[0].coeff = jo_malloc((order + 1) * sizeof(field_element_t));
+    r[0].coeff = regionAlloc(MEMORY_REGION_HOT, (order + 1) * sizeof(field_element_t));
     jo_memset(r[0].coeff, 0, (order + 1) * sizeof(field_element_t));
-    r[1].coeff = jo_malloc((order + 1) * sizeof(field_element_t));
+    r[1].coeff = regionAlloc(MEMORY_REGION_HOT, (order + 1) * sizeof(field_element_t));
     jo_memset(r[1].coeff, 0, (order + 1) * sizeof(field_element_t));
     unsigned int rcoeffres = 0;
 
@@ -250,9 +250,9 @@ polynomial_t polynomial_create_from_roots(field_t field, unsigned int nroots, fi
     memcpy(poly.coeff, r[rcoeffres].coeff, (order + 1) * sizeof(field_element_t));
     poly.order = order;
 
-    jo_free(l.coeff);
-    jo_free(r[0].coeff);
-    jo_free(r[1].coeff);
+    regionFree(MEMORY_REGION_HOT, l.coeff);
+    regionFree(MEMORY_REGION_HOT, r[0].coeff);
+    regionFree(MEMORY_REGION_HOT, r[1].coeff);
 
     return poly;
 }
@@ -0,0 +1,133 @@
+| SGEX 68000 sound driver
+|
+| Plays FSK tones from a queue the SH-2 fills in sound RAM. One SCSP slot
+| loops over a single cycle sine and only its pitch is changed at each
+| symbol boundary, so no samples are generated. Symbols are timed with SCSP
+| timer A counting output samples.
+|
+| Each queue entry is two words:
+|   pitch     OCT/FNS pitch word, or QUEUE_SILENCE to mute the slot
+|   duration  1 to 255 samples at 44.1KHz
+|
+| The SH-2 writes entries at head, the driver plays them from tail and
+| advances tail once each entry has finished. The layout must match
+| simpleaudio-saturn68k.c
+|
+| Build: m68k-elf-as -m68000, linked at address 0, see the makefile
+
+        .equ    STACK_TOP,      0x1000
+
+        .equ    SHARED,         0x1000
+        .equ    SHARED_MAGIC,   0               | set once the driver is running
+        .equ    SHARED_HEAD,    2               | written by the SH-2
+        .equ    SHARED_TAIL,    4               | written by the driver
+        .equ    SHARED_SLOT,    6               | slot to play on, written by the SH-2
+        .equ    SHARED_SINE,    8               | sine offset in sound RAM, written by the SH-2
+        .equ    SHARED_SINE_LEN, 10             | sine length in samples, written by the SH-2
+
+        .equ    QUEUE,          0x1010
+        .equ    QUEUE_MASK,     0x0FFF          | 4096 entries
+        .equ    QUEUE_SILENCE,  15              | bit set in the pitch word
+
+        .equ    DRIVER_MAGIC,   0x5347          | "SG"
+
+        .equ    SCSP_SLOTS,     0x100000
+        .equ    SCSP_COMMON,    0x100400
+        .equ    MVOL,           0x00            | offsets from SCSP_COMMON
+        .equ    TIMER_A,        0x18
+        .equ    SCIEB,          0x1E
+        .equ    SCIPD,          0x20
+        .equ    SCIRE,          0x22
+        .equ    TIMER_A_BIT,    6
+
+        .equ    SLOT_CONTROL,   0x00
+        .equ    SLOT_SA,        0x02
+        .equ    SLOT_LSA,       0x04
+        .equ    SLOT_LEA,       0x06
+        .equ    SLOT_ENV1,      0x08
+        .equ    SLOT_ENV2,      0x0A
+        .equ    SLOT_LEVEL,     0x0C
+        .equ    SLOT_MOD,       0x0E
+        .equ    SLOT_PITCH,     0x10
+        .equ    SLOT_LFO,       0x12
+        .equ    SLOT_INPUT,     0x14
+        .equ    SLOT_OUTPUT,    0x16
+
+        .text
+        .org    0
+vectors:
+        .long   STACK_TOP
+        .long   start
+
+start:
+        move.w  #0x2700,%sr                     | no interrupts, everything is polled
+        lea     SHARED,%a3
+        lea     QUEUE,%a2
+        lea     SCSP_COMMON,%a5
+
+        move.w  #0x020F,MVOL(%a5)               | 4Mbit sound RAM, full master volume
+        move.w  #(1 << TIMER_A_BIT),SCIEB(%a5)  | timer A only shows up in SCIPD when enabled
+
+        | a4 = the slot's registers
+        move.w  SHARED_SLOT(%a3),%d0
+        and.w   #0x1F,%d0
+        lsl.w   #5,%d0
+        lea     SCSP_SLOTS,%a4
+        add.w   %d0,%a4
+
+        | loop over the sine, muted until the first entry
+        move.w  #0x1020,SLOT_CONTROL(%a4)       | KYONEX, key off, normal loop
+        move.w  SHARED_SINE(%a3),SLOT_SA(%a4)
+        move.w  #0,SLOT_LSA(%a4)
+        move.w  SHARED_SINE_LEN(%a3),SLOT_LEA(%a4)
+        move.w  #0x001F,SLOT_ENV1(%a4)          | no attack
+        move.w  #0x3C1F,SLOT_ENV2(%a4)          | immediate release
+        move.w  #0x00FF,SLOT_LEVEL(%a4)         | muted
+        move.w  #0,SLOT_MOD(%a4)
+        move.w  #0,SLOT_PITCH(%a4)
+        move.w  #0,SLOT_LFO(%a4)
+        move.w  #0,SLOT_INPUT(%a4)
+        move.w  #0xE000,SLOT_OUTPUT(%a4)        | full direct send level, centered
+        move.w  #0x1820,SLOT_CONTROL(%a4)       | KYONEX, key on, normal loop
+
+        move.w  #DRIVER_MAGIC,SHARED_MAGIC(%a3)
+
+idle:
+        move.w  SHARED_TAIL(%a3),%d1
+idle_wait:
+        cmp.w   SHARED_HEAD(%a3),%d1
+        beq.s   idle_wait
+
+next:
+        | d1 = tail. Timer A is reloaded first, well inside the sample it
+        | overflowed on, so symbol lengths don't drift
+        move.w  %d1,%d2
+        lsl.w   #2,%d2
+        move.w  0(%a2,%d2.w),%d3                | pitch
+        move.w  #256,%d4
+        sub.w   2(%a2,%d2.w),%d4
+        move.w  %d4,TIMER_A(%a5)                | count up from 256 - duration, one count per sample
+        move.w  #(1 << TIMER_A_BIT),SCIRE(%a5)
+
+        btst    #QUEUE_SILENCE,%d3
+        bne.s   silence
+        move.w  %d3,SLOT_PITCH(%a4)
+        move.w  #0,SLOT_LEVEL(%a4)
+        bra.s   wait
+silence:
+        move.w  #0x00FF,SLOT_LEVEL(%a4)
+
+wait:
+        move.w  SCIPD(%a5),%d0
+        btst    #TIMER_A_BIT,%d0
+        beq.s   wait
+
+        addq.w  #1,%d1
+        and.w   #QUEUE_MASK,%d1
+        move.w  %d1,SHARED_TAIL(%a3)
+        cmp.w   SHARED_HEAD(%a3),%d1
+        bne.s   next
+
+        | ran dry, mute until the SH-2 queues more
+        move.w  #0x00FF,SLOT_LEVEL(%a4)
+        bra.s   idle_wait
@@ -34,9 +34,35 @@
 #include "encode.h"
 #include "md5/md5.h"
 #include "saturn-minimodem.h"
+#include "profile.h"
+#include "benchmark.h"
+#include "arena.h"
+#include "savedir.h"
+#include "known.h"
+#include "prbs.h"
+#include "toneplan.h"
+#include "speed.h"
 
 GAME g_Game = {0};
-SAVES g_Saves[MAX_SAVES] = {0};
+
+// draw and input handlers of each state
+static const SCREEN g_Screens[NUM_STATES] = {
+    [STATE_MAIN]        = {main_draw, main_input},
+    [STATE_LIST_SAVES]  = {listSaves_draw, listSaves_input},
+    [STATE_PLAY_SAVES]  = {playSaves_draw, playSaves_input},
+    [STATE_DUMP_BIOS]   = {dumpBios_draw, dumpBios_input},
+    [STATE_TEST]        = {test_draw, test_input},
+    [STATE_COLLECT]     = {collect_draw, collect_input},
+    [STATE_CREDITS]     = {credits_draw, credits_input},
+#if USE_BENCHMARKS
+    [STATE_BENCHMARK]   = {benchmark_draw, benchmark_input},
+#endif
+};
+
+#if USE_BENCHMARKS
+BENCHMARK_RESULT g_BenchmarkResults[BENCHMARK_NUM_INPUTS][BENCHMARK_NUM_STAGES] = {0};
+unsigned int g_BenchmarkStep = 0; // next input * BENCHMARK_NUM_STAGES + stage to run
+#endif
 
 void jo_main(void)
 {
@@ -44,18 +70,35 @@ void jo_main(void)
 
     jo_core_init(JO_COLOR_Black);
 
-    // increase the default heap size. LWRAM is not being used
-    jo_add_memory_zone((unsigned char *)LWRAM, LWRAM_HEAP_SIZE);
+    // LWRAM is not used by Jo Engine, use it for the transfer arena
+    // instead of growing the heap so transfers don't fragment it
+    result = arenaInit(&g_Arena, (unsigned char *)LWRAM, LWRAM_SIZE);
+    if(result != 0)
+    {
+        return;
+    }
+
+    // the part of sound RAM SGL leaves alone, for buffers the SCSP plays from
+    result = arenaInit(&g_SoundArena, (unsigned char *)SOUND_RAM_ARENA, SOUND_RAM_ARENA_SIZE);
+    if(result != 0)
+    {
+        return;
+    }
 
-    // allocate our save file buffer
-    // the buffer consists of the transmission header + bup header + save data
-    g_Game.transmissionData = jo_malloc(TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + MAX_SAVE_SIZE);
+    // allocate our header buffer
+    // the buffer consists of the transmission header + bup header, the save
+    // data is compressed straight from where it was read
+    g_Game.transmissionData = arenaAlloc(&g_Arena, TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE);
     if(g_Game.transmissionData == NULL)
     {
-        jo_core_error("Failed to allocated save file data buffer!!");
+        jo_core_error("Failed to allocated transmission header buffer!!");
         return;
     }
-    g_Game.saveFileData = g_Game.transmissionData + TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE;
+
+    // everything after this point is per-transfer and released in transitionToState()
+    // a save read from a backup device goes first, see copySaveFile()
+    g_Game.saveArenaMark = arenaMark(&g_Arena);
+    g_Game.transferArenaMark = g_Game.saveArenaMark;
 
     // init Saturn minimodem
     result = SaturnMinimodem_init();
@@ -66,64 +109,136 @@ void jo_main(void)
     }
 
     // init Reed Solomon encoder
-    g_reedSolomon = correct_reed_solomon_create(correct_rs_primitive_polynomial_ccsds,
-                                                RS_FIRST_CONSECUTIVE_ROOT,
-                                                RS_ROOT_GAP,
-                                                RS_NUM_ROOTS);
-    if(g_reedSolomon == NULL)
+    result = initializeReedSolomon(RS_NUM_ROOTS);
+    if(result != 0)
+    {
+        return;
+    }
+
+    // the speed kept on internal memory, if any
+    loadDefaultSpeed();
+
+    // cycle counter for the benchmarks and profiling
+    result = profileInit();
+    if(result != 0)
     {
-        jo_core_error("Failed to init Reed Solomon");
         return;
     }
 
     // ABC + start handler
     jo_core_set_restart_game_callback(abcStartHandler);
 
-    // callbacks
-    jo_core_add_callback(main_draw);
-    jo_core_add_callback(main_input);
+    // callbacks, the current screen's handlers come from g_Screens
+    jo_core_add_callback(screenDispatch);
 
-    jo_core_add_callback(listSaves_draw);
-    jo_core_add_callback(listSaves_input);
+    // debug output, Z toggles the profiler overlay
+    jo_core_add_callback(debugOutput_draw);
+    jo_core_add_callback(debugOutput_input);
 
-    jo_core_add_callback(playSaves_draw);
-    jo_core_add_callback(playSaves_input);
+    // initial state
+    transitionToState(STATE_MAIN);
 
-    jo_core_add_callback(dumpBios_draw);
-    jo_core_add_callback(dumpBios_input);
+    jo_core_run();
+}
 
-    jo_core_add_callback(test_draw);
-    jo_core_add_callback(test_input);
+// runs the current screen's handlers instead of every screen checking the state
+// A transition in draw or input is picked up next frame
+void screenDispatch(void)
+{
+    const SCREEN* screen = NULL;
+    unsigned int state = g_Game.state;
 
-    jo_core_add_callback(collect_draw);
-    jo_core_add_callback(collect_input);
+    g_Game.frame++;
 
-    jo_core_add_callback(credits_draw);
-    jo_core_add_callback(credits_input);
+    if(state >= NUM_STATES || g_Screens[state].draw == NULL)
+    {
+        return;
+    }
+    screen = &g_Screens[state];
 
-    // debug output
-    //jo_core_add_callback(debugOutput_draw);
+    screen->draw();
 
-    // initial state
-    transitionToState(STATE_MAIN);
+    // a redraw only counts once the screen it was for has drawn
+    if(g_Game.state == state)
+    {
+        g_Game.redraw = false;
+        screen->input();
+    }
+}
 
-    jo_core_run();
+// true when the transfer status should be refreshed. Every frame when idle,
+// a few times a second while the modem is running so the UI stays out of its way
+bool transferStatusDue(void)
+{
+    if(g_Game.redraw || g_Game.isTransmissionRunning == false)
+    {
+        return true;
+    }
+
+    return (g_Game.frame % TRANSFER_UI_FRAMES) == 0;
+}
+
+// profiler overlay at the bottom of the screen
+// stage times cover the current transfer: encoding the save and playing it
+void debugOutput_draw(void)
+{
+    unsigned int bitsPerSecond = 0;
+    int memoryUsage = jo_memory_usage_percent();
+
+    if(memoryUsage > g_Game.peakMemoryUsage)
+    {
+        g_Game.peakMemoryUsage = memoryUsage;
+    }
+
+    if(g_Game.showProfiler == false || transferStatusDue() == false)
+    {
+        return;
+    }
+
+    if(SaturnMinimodem_transferRate(&bitsPerSecond) != 0)
+    {
+        bitsPerSecond = 0;
+    }
+
+    jo_printf(PROFILER_X, PROFILER_Y, "MD5%5d CRC%4d Dfl%6d RS%6d ms",
+              profileStageMilliseconds(PROFILE_STAGE_MD5),
+              profileStageMilliseconds(PROFILE_STAGE_CRC32),
+              profileStageMilliseconds(PROFILE_STAGE_DEFLATE),
+              profileStageMilliseconds(PROFILE_STAGE_RS));
+    jo_printf(PROFILER_X, PROFILER_Y + 1, "Esc %5d Tone %7d PCM %7d ms",
+              profileStageMilliseconds(PROFILE_STAGE_ESCAPE),
+              profileStageMilliseconds(PROFILE_STAGE_TONE),
+              profileStageMilliseconds(PROFILE_STAGE_PCM_WAIT));
+    jo_printf(PROFILER_X, PROFILER_Y + 2, "Heap %3d%% Peak %3d%% Frag %4d   ",
+              memoryUsage, g_Game.peakMemoryUsage, jo_memory_fragmentation());
+    jo_printf(PROFILER_X, PROFILER_Y + 3, "Air %5d bps Arena %4dK Pk %4dK ",
+              bitsPerSecond, g_Arena.used / 1024, g_Arena.peak / 1024);
 }
 
-// useful debug output
-void debugOutput_draw()
+// Z toggles the profiler overlay on any screen
+void debugOutput_input(void)
 {
-    jo_printf(2, 0, "Memory Usage: %d Frag: %d" , jo_memory_usage_percent(), jo_memory_fragmentation());
-    jo_printf(2, 1, "Save: %d CO: %d" , g_Game.numSaves, g_Game.cursorOffset);
+    if(jo_is_pad1_key_pressed(JO_KEY_Z))
+    {
+        if(g_Game.input.pressedZ == false)
+        {
+            g_Game.input.pressedZ = true;
+            g_Game.showProfiler = !g_Game.showProfiler;
 
-    /*
-    if(jo_memory_fragmentation() > 100)
+            // erase the overlay
+            if(g_Game.showProfiler == false)
+            {
+                for(unsigned int i = 0; i < PROFILER_NUM_LINES; i++)
+                {
+                    jo_printf(0, PROFILER_Y + i, "                                          ");
+                }
+            }
+        }
+    }
+    else
     {
-        jo_core_error("High fragmentation!! %d", jo_memory_fragmentation());
-        jo_reduce_memory_fragmentation();
-        jo_core_error("High fragmentation!! %d", jo_memory_fragmentation());
+        g_Game.input.pressedZ = false;
     }
-    */
 }
 
 // restarts the program if controller one presses ABC+Start
@@ -144,6 +259,13 @@ void transitionToState(int newState)
 {
     clearScreen();
 
+    // the transfer runs in the background, stop it before its buffers go away
+    if(g_Game.isTransmissionRunning)
+    {
+        SaturnMinimodem_cancelTransfer();
+        g_Game.isTransmissionRunning = false;
+    }
+
     g_Game.previousState = g_Game.state;
 
     switch(g_Game.state)
@@ -156,6 +278,7 @@ void transitionToState(int newState)
         case STATE_TEST:
         case STATE_COLLECT:
         case STATE_CREDITS:
+        case STATE_BENCHMARK:
             break;
 
         default:
@@ -170,6 +293,10 @@ void transitionToState(int newState)
             g_Game.cursorPosY = OPTIONS_Y;
             g_Game.cursorOffset = 0;
             g_Game.numStateOptions = MAIN_NUM_OPTIONS;
+
+            // the save is done with, give its part of the arena back to the other screens
+            freeSaveFile();
+            releaseSaveArena();
             break;
 
         case STATE_LIST_SAVES:
@@ -177,8 +304,8 @@ void transitionToState(int newState)
             g_Game.cursorPosY = OPTIONS_Y + 1;
             g_Game.cursorOffset = 0;
             g_Game.numStateOptions = 0; // 0 options until we list the number of saves
-            g_Game.numSaves = 0; // number of saves counted
-            g_Game.listedSaves = false;
+            g_Game.numSaves = 0; // number of saves counted, the names are cached in savedir.c
+            g_Game.sendInFull = false;
             break;
 
         case STATE_DUMP_BIOS:
@@ -186,22 +313,29 @@ void transitionToState(int newState)
             g_Game.cursorPosY = OPTIONS_Y + 1;
             g_Game.cursorOffset = 0;
             g_Game.numStateOptions = BIOS_NUM_OPTIONS;
+            g_Game.sendInFull = false;
             break;
 
         case STATE_PLAY_SAVES:
             g_Game.md5Calculated = false;
             g_Game.isTransmissionRunning = false;
+            g_Game.autoStart = false;
+            g_Game.resumeCodeword = 0;
+            g_Game.resumeData = NULL;
 
-            if(g_Game.encodedTransmissionData != NULL)
-            {
-                jo_free(g_Game.encodedTransmissionData);
-                g_Game.encodedTransmissionData = NULL;
-            }
+            // drops the encode buffers and anything else from the last transfer
+            arenaRelease(&g_Arena, g_Game.transferArenaMark);
+            g_Game.encodedTransmissionData = NULL;
             g_Game.encodedTransmissionSize = 0;
             break;
 
         case STATE_TEST:
+            g_Game.cursorPosX = CURSOR_X;
+            g_Game.cursorPosY = OPTIONS_Y;
+            g_Game.cursorOffset = 0;
+            g_Game.numStateOptions = TEST_NUM_OPTIONS;
             g_Game.isTransmissionRunning = false;
+            test_enter();
             break;
 
         case STATE_COLLECT:
@@ -210,25 +344,103 @@ void transitionToState(int newState)
         case STATE_CREDITS:
             break;
 
+#if USE_BENCHMARKS
+        case STATE_BENCHMARK:
+            g_BenchmarkStep = 0;
+            break;
+#endif
+
         default:
             jo_core_error("%d is an invalid state!!", newState);
             return;
     }
 
     g_Game.state = newState;
+    g_Game.redraw = true;
 
     return;
 }
 
+// true the first frame key is held down
+static bool keyPressedOnce(int key, bool* pressed)
+{
+    if(jo_is_pad1_key_pressed(key))
+    {
+        if(*pressed == false)
+        {
+            *pressed = true;
+            return true;
+        }
+        return false;
+    }
+
+    *pressed = false;
+    return false;
+}
+
+// result of the last C on the speed row of the main screen
+static const char* g_SpeedStatus = "";
+
+// picks up the speed saved with C on the main screen, the defaults without one
+void loadDefaultSpeed(void)
+{
+    SPEED_PROFILE speed = {0};
+    unsigned char* record = NULL;
+    unsigned int recordSize = 0;
+
+    if(jo_backup_mount(JoInternalMemoryBackup) == false)
+    {
+        return;
+    }
+
+    record = jo_backup_load_file_contents(JoInternalMemoryBackup, SPEED_SAVE_FILENAME, &recordSize);
+    if(record == NULL)
+    {
+        return;
+    }
+
+    if(recordSize == SPEED_RECORD_SIZE && speedUnpack(record, &speed) == 0)
+    {
+        speedApply(&speed);
+    }
+
+    jo_free(record);
+}
+
+// keeps the speed in use on internal memory for the next power on
+int saveDefaultSpeed(void)
+{
+    SPEED_PROFILE speed = {0};
+    unsigned char record[SPEED_RECORD_SIZE] = {0};
+
+    if(speedGetCurrent(&speed) != 0)
+    {
+        return -1;
+    }
+    speedPack(&speed, record);
+
+    if(jo_backup_mount(JoInternalMemoryBackup) == false ||
+       jo_backup_save_file_contents(JoInternalMemoryBackup, SPEED_SAVE_FILENAME, SPEED_SAVE_COMMENT,
+                                    record, SPEED_RECORD_SIZE) == false)
+    {
+        return -1;
+    }
+
+    // the list of internal saves has a new one
+    saveDirectoryRefresh(JoInternalMemoryBackup);
+    return 0;
+}
+
 // draws the main option screen
 // Number of options are hardcoded
 void main_draw(void)
 {
+    SPEED_PROFILE speed = {0};
     unsigned int y = 0;
 
-    if(g_Game.state != STATE_MAIN)
+    if(speedGetCurrent(&speed) != 0)
     {
-        return;
+        speed.name = "Unknown";
     }
 
     // heading
@@ -243,8 +455,27 @@ void main_draw(void)
     jo_printf(OPTIONS_X, OPTIONS_Y + y++, "External Device (Floppy)");
     jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Dump Bios");
     jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Test Audio Transmission");
+    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Speed: %-12s", speed.name);
     jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Save Games Collect Project");
     jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Credits");
+#if USE_BENCHMARKS
+    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Encode Benchmark");
+#endif
+
+    // what the speed is, minimodem needs the rate, tones and framing
+    y++;
+    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "%4d baud %d+%d RS(255,%d)    ",
+              (int)speed.dataRate, speed.numStartBits, speed.numStopBits, (int)(CODEWORD_SIZE - speed.parity));
+    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Tones %4d/%4d Hz", (int)speed.markFreq, (int)speed.spaceFreq);
+
+    if(g_Game.cursorOffset == MAIN_OPTION_SPEED)
+    {
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Left/Right:Change C:Save      ");
+    }
+    else
+    {
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "%-30s", g_SpeedStatus);
+    }
 
     // cursor
     jo_printf(g_Game.cursorPosX, g_Game.cursorPosY + g_Game.cursorOffset, ">>");
@@ -322,11 +553,6 @@ void moveCursor(bool savesPage)
 // handles input on the main screen
 void main_input(void)
 {
-    if(g_Game.state != STATE_MAIN)
-    {
-        return;
-    }
-
     // did the player hit start
     if(jo_is_pad1_key_pressed(JO_KEY_START) ||
        jo_is_pad1_key_pressed(JO_KEY_A) ||
@@ -367,6 +593,11 @@ void main_input(void)
                     transitionToState(STATE_TEST);
                     return;
                 }
+                case MAIN_OPTION_SPEED:
+                {
+                    g_SpeedStatus = saveDefaultSpeed() == 0 ? "Kept on internal memory" : "Couldn't save, memory full?";
+                    return;
+                }
                 case MAIN_OPTION_COLLECT:
                 {
                     transitionToState(STATE_COLLECT);
@@ -377,6 +608,13 @@ void main_input(void)
                     transitionToState(STATE_CREDITS);
                     return;
                 }
+#if USE_BENCHMARKS
+                case MAIN_OPTION_BENCHMARK:
+                {
+                    transitionToState(STATE_BENCHMARK);
+                    return;
+                }
+#endif
                 default:
                 {
                     jo_core_error("Invalid main option!!");
@@ -390,74 +628,47 @@ void main_input(void)
         g_Game.input.pressedStartAC = false;
     }
 
-    // update the cursor
-    moveCursor(false);
-    return;
-}
-
-// queries the saves on the backup device and fills out the fileSaves array
-int readSaveFiles(jo_backup_device backupDevice, PSAVES fileSaves, unsigned int numSaves)
-{
-    jo_list saveFilenames = {0};
-    bool result = false;
-    int count = 0;
-
-    jo_list_init(&saveFilenames);
-
-    result = jo_backup_read_device(backupDevice, &saveFilenames);
-    if(result == false)
-    {
-        jo_list_free_and_clear(&saveFilenames);
-        return -1;
-    }
-
-    for(unsigned int i = 0; i < (unsigned int)saveFilenames.count && i < numSaves; i++)
+    // Left/Right cycle the speed profiles, settings from a tone plan code go back to the first
+    if(g_Game.cursorOffset == MAIN_OPTION_SPEED)
     {
-        char comment[MAX_SAVE_COMMENT] = {0};
-        unsigned char language = 0;
-        unsigned int date = 0;
-        unsigned int numBytes = 0;
-        unsigned int numBlocks = 0;
+        int step = 0;
 
-        char* filename = jo_list_at(&saveFilenames, i)->data.ch_arr;
+        step -= keyPressedOnce(JO_KEY_LEFT, &g_Game.input.pressedLeft) ? 1 : 0;
+        step += keyPressedOnce(JO_KEY_RIGHT, &g_Game.input.pressedRight) ? 1 : 0;
 
-        if(filename == NULL)
+        if(step != 0)
         {
-            jo_core_error("readSaveFiles list is corrupt!!");
-            return -1;
-        }
+            SPEED_PROFILE speed = {0};
+            unsigned int profile = SPEED_CONSERVATIVE;
 
-        // query the save metadata
-        result = jo_backup_get_file_info(backupDevice, filename, comment, &language, &date, &numBytes, &numBlocks);
-        if(result == false)
-        {
-            jo_core_error("Failed to read file size!!");
-            return -1;
-        }
+            if(speedGetCurrent(&speed) == 0 && speedFindProfile(&speed) != SPEED_CUSTOM)
+            {
+                profile = (speedFindProfile(&speed) + SPEED_NUM_PROFILES + step) % SPEED_NUM_PROFILES;
+            }
 
-        strncpy((char*)fileSaves[i].filename, filename, MAX_SAVE_FILENAME);
-        strncpy((char*)fileSaves[i].comment, comment, MAX_SAVE_COMMENT);
-        fileSaves[i].language = language;
-        fileSaves[i].date = date;
-        fileSaves[i].datasize = numBytes;
-        fileSaves[i].blocksize = numBlocks;
-        count++;
+            speed = SPEED_PROFILES[profile];
+            if(speedApply(&speed) != 0)
+            {
+                return;
+            }
+            g_SpeedStatus = "";
+        }
     }
 
-    jo_list_free_and_clear(&saveFilenames);
-
-    return count;
+    // update the cursor
+    moveCursor(false);
+    return;
 }
 
 // draws the list saves screen
+// the page is only redrawn when it changes, the saves come from the directory cache
 void listSaves_draw(void)
 {
+    static int drawnPage = -1;
     char* backupDeviceType = NULL;
-
-    if(g_Game.state != STATE_LIST_SAVES)
-    {
-        return;
-    }
+    PSAVES save = NULL;
+    int page = 0;
+    int count = 0;
 
     switch(g_Game.backupDevice)
     {
@@ -476,46 +687,41 @@ void listSaves_draw(void)
             return;
     }
 
-    jo_printf(HEADING_X, HEADING_Y, "%s", backupDeviceType);
-    jo_printf(HEADING_X, HEADING_Y + 1, HEADING_UNDERSCORE);
-
-    if(g_Game.listedSaves == false)
+    if(g_Game.redraw)
     {
-        bool result;
-        int count;
-
-        jo_memset(g_Saves, 0, sizeof(g_Saves));
+        jo_printf(HEADING_X, HEADING_Y, "%s", backupDeviceType);
+        jo_printf(HEADING_X, HEADING_Y + 1, HEADING_UNDERSCORE);
 
-        g_Game.listedSaves = true;
-
-        result = jo_backup_mount(g_Game.backupDevice);
-        if(result == false)
+        // only reads the device the first time
+        count = saveDirectoryRead(g_Game.backupDevice);
+        if(count < 0)
         {
             jo_core_error("Failed to open internal %s!!", backupDeviceType);
             transitionToState(STATE_MAIN);
             return;
         }
 
-        // read the saves meta data
-        count = readSaveFiles(g_Game.backupDevice, g_Saves, COUNTOF(g_Saves));
-        if(count > 0)
-        {
-            // update the count of saves
-            g_Game.numSaves = count;
-        }
-        else
-        {
-            g_Game.numSaves = 0;
-        }
+        g_Game.numSaves = count;
+        g_Game.numStateOptions = count;
+        drawnPage = -1;
     }
 
-    if(g_Game.numSaves > 0)
+    if(g_Game.numSaves == 0)
+    {
+        jo_printf(OPTIONS_X, OPTIONS_Y, "Found 0 saves on the device");
+        return;
+    }
+
+    page = g_Game.cursorOffset / MAX_SAVES_PER_PAGE;
+    if(page != drawnPage)
     {
         int i = 0;
         int j = 0;
 
         // header
         jo_printf(OPTIONS_X, OPTIONS_Y, "%-11s  %-10s  %6s", "Filename", "Comment", "Bytes");
+        jo_printf(OPTIONS_X, OPTIONS_Y + MAX_SAVES_PER_PAGE + 2, "%d saves  X:Sort %s  Y:Reload  ",
+                  g_Game.numSaves, saveDirectorySortName(saveDirectoryGetSort(g_Game.backupDevice)));
 
         // zero out the save print fields otherwise we will have stale data on the screen
         // when we go to other pages
@@ -524,30 +730,37 @@ void listSaves_draw(void)
             jo_printf(OPTIONS_X, OPTIONS_Y + i  + 1, "                                      ");
         }
 
-        // print up to MAX_SAVES_PER_PAGE saves on the screen
-        for(i = (g_Game.cursorOffset / MAX_SAVES_PER_PAGE) * MAX_SAVES_PER_PAGE, j = 0; i < g_Game.numSaves && j < MAX_SAVES_PER_PAGE; i++, j++)
+        // print up to MAX_SAVES_PER_PAGE saves on the screen, their info is fetched as they're shown
+        for(i = page * MAX_SAVES_PER_PAGE, j = 0; i < g_Game.numSaves && j < MAX_SAVES_PER_PAGE; i++, j++)
         {
-            jo_printf(OPTIONS_X, OPTIONS_Y + (i % MAX_SAVES_PER_PAGE) + 1, "%-11s  %-10s  %6d", g_Saves[i].filename, g_Saves[i].comment, g_Saves[i].datasize);
+            save = saveDirectoryGet(g_Game.backupDevice, i);
+            if(save == NULL)
+            {
+                transitionToState(STATE_MAIN);
+                return;
+            }
+
+            jo_printf(OPTIONS_X, OPTIONS_Y + (i % MAX_SAVES_PER_PAGE) + 1, "%-11s  %-10s  %6d", save->filename, save->comment, save->datasize);
         }
 
-        g_Game.numStateOptions = g_Game.numSaves;
+        drawnPage = page;
     }
-    else
+
+    // copy the save data
+    save = saveDirectoryGet(g_Game.backupDevice, g_Game.cursorOffset);
+    if(save == NULL)
     {
-        jo_printf(OPTIONS_X, OPTIONS_Y, "Found 0 saves on the device");
+        transitionToState(STATE_MAIN);
+        return;
     }
 
-    if(g_Game.numStateOptions > 0)
-    {
-        // copy the save data
-        memcpy(g_Game.saveFilename, g_Saves[g_Game.cursorOffset].filename, MAX_SAVE_FILENAME);
-        strncpy(g_Game.saveComment, g_Saves[g_Game.cursorOffset].comment, MAX_SAVE_COMMENT);
-        g_Game.saveLanguage = g_Saves[g_Game.cursorOffset].language;
-        g_Game.saveDate = g_Saves[g_Game.cursorOffset].date;
-        g_Game.saveFileSize = g_Saves[g_Game.cursorOffset].datasize;
+    memcpy(g_Game.saveFilename, save->filename, MAX_SAVE_FILENAME);
+    strncpy(g_Game.saveComment, save->comment, MAX_SAVE_COMMENT);
+    g_Game.saveLanguage = save->language;
+    g_Game.saveDate = save->date;
+    g_Game.saveFileSize = save->datasize;
 
-        jo_printf(g_Game.cursorPosX, g_Game.cursorPosY + g_Game.cursorOffset % MAX_SAVES_PER_PAGE, ">>");
-    }
+    jo_printf(g_Game.cursorPosX, g_Game.cursorPosY + g_Game.cursorOffset % MAX_SAVES_PER_PAGE, ">>");
 
     return;
 }
@@ -556,11 +769,6 @@ void listSaves_draw(void)
 // B returns to the main menu
 void listSaves_input(void)
 {
-    if(g_Game.state != STATE_LIST_SAVES)
-    {
-        return;
-    }
-
     // did the player hit start
     if(jo_is_pad1_key_pressed(JO_KEY_START) ||
        jo_is_pad1_key_pressed(JO_KEY_A) ||
@@ -596,6 +804,47 @@ void listSaves_input(void)
         g_Game.input.pressedStartAC = false;
     }
 
+    // did the player hit x, sort by the next field
+    if(jo_is_pad1_key_pressed(JO_KEY_X))
+    {
+        if(g_Game.input.pressedX == false && g_Game.numSaves > 0)
+        {
+            unsigned int sort = (saveDirectoryGetSort(g_Game.backupDevice) + 1) % SAVE_NUM_SORTS;
+
+            g_Game.input.pressedX = true;
+
+            if(saveDirectorySort(g_Game.backupDevice, sort) != 0)
+            {
+                transitionToState(STATE_MAIN);
+                return;
+            }
+
+            // back to the first page
+            transitionToState(STATE_LIST_SAVES);
+            return;
+        }
+    }
+    else
+    {
+        g_Game.input.pressedX = false;
+    }
+
+    // did the player hit y, read the device again after swapping it
+    if(jo_is_pad1_key_pressed(JO_KEY_Y))
+    {
+        if(g_Game.input.pressedY == false)
+        {
+            g_Game.input.pressedY = true;
+            saveDirectoryRefresh(g_Game.backupDevice);
+            transitionToState(STATE_LIST_SAVES);
+            return;
+        }
+    }
+    else
+    {
+        g_Game.input.pressedY = false;
+    }
+
     if(jo_is_pad1_key_pressed(JO_KEY_B))
     {
         if(g_Game.input.pressedB == false)
@@ -615,179 +864,327 @@ void listSaves_input(void)
     return;
 }
 
-// draws the play saves screen
-void playSaves_draw(void)
+// sends the speed ahead of the next transmission unless it is the default
+static int announceSpeed(void)
 {
-    int result = 0;
-    int y = 0;
-    unsigned int bytesTransferred = 0;
-    unsigned int totalSize = 0;
-    jo_backup_date jo_date = {0};
+    static unsigned char announcement[SPEED_ANNOUNCE_MAX_SIZE] = {0};
+    unsigned int size = 0;
 
-    if(g_Game.state != STATE_PLAY_SAVES)
+    if(speedAnnouncement(announcement, &size) != 0)
     {
-        return;
+        return -1;
     }
 
-    jo_printf(HEADING_X, HEADING_Y, "Transmitting Data Over Audio");
-    jo_printf(HEADING_X, HEADING_Y + 1, HEADING_UNDERSCORE);
+    return SaturnMinimodem_setAnnouncement(size ? announcement : NULL, size);
+}
 
-    // only compute the MD5 hash once
-    if(g_Game.md5Calculated == false)
+// starts sending g_Game.encodedTransmissionData from g_Game.resumeCodeword
+static int startTransmission(void)
+{
+    unsigned char* data = g_Game.encodedTransmissionData;
+    unsigned int size = g_Game.encodedTransmissionSize;
+
+    if(data == NULL || size == 0)
     {
-        unsigned int unencodedSize = 0;
-        unsigned int uncompressedSize = 0;
-        unsigned char* compressedBuffer = NULL;
-        g_Game.compressedSize = 0;
+        jo_core_error("Transmission data isn't initialized!!");
+        return -1;
+    }
 
-        //
-        // print messages to the user so that can get an estimate of the time for longer operations
-        //
-        result = calculateMD5Hash(g_Game.saveFileData, g_Game.saveFileSize, g_Game.md5Hash);
-        if(result != 0)
-        {
-            // something went wrong
-            transitionToState(STATE_MAIN);
-            return;
-        }
+    // picks up an interrupted transfer where sgex.py said it lost it
+    if(g_Game.resumeCodeword != 0)
+    {
+        // the last one is the most recent arena allocation, it is popped
+        arenaFree(&g_Arena, g_Game.resumeData);
+        g_Game.resumeData = NULL;
 
-        // transmission header
-        result = initializeTransmissionHeader(g_Game.md5Hash, sizeof(g_Game.md5Hash), g_Game.saveFilename, g_Game.saveFileSize);
-        if(result != 0)
+        if(encodeResume(g_Game.resumeCodeword, &g_Game.resumeData, &g_Game.resumeSize) != 0)
         {
-            // something went wrong
-            transitionToState(STATE_MAIN);
-            return;
+            return -1;
         }
 
-        // bup header
-        initializeBUPHeader(g_Game.saveFilename, g_Game.saveComment, g_Game.saveLanguage, g_Game.saveDate, g_Game.saveFileSize);
-        if(result != 0)
-        {
-            // something went wrong
-            transitionToState(STATE_MAIN);
-            return;
-        }
+        data = g_Game.resumeData;
+        size = g_Game.resumeSize;
+    }
 
-        //
-        // Compress the save
-        //
+    SaturnMinimodem_initTransfer(data, size);
+    g_Game.isTransmissionRunning = true;
+    return 0;
+}
 
-        // estimate the compressed output size
-        uncompressedSize = TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + g_Game.saveFileSize;
-        g_Game.compressedSize = compressOutSize(uncompressedSize);
+// drops the encoded transmission so playSaves_draw() encodes the data again
+// the same as entering STATE_PLAY_SAVES again without losing the screen to go back to
+static void resetEncoding(void)
+{
+    arenaRelease(&g_Arena, g_Game.transferArenaMark);
+    g_Game.encodedTransmissionData = NULL;
+    g_Game.encodedTransmissionSize = 0;
+    g_Game.md5Calculated = false;
+    g_Game.resumeCodeword = 0;
+    g_Game.resumeData = NULL;
+    g_Game.autoStart = false;
+}
 
-        compressedBuffer = jo_malloc(g_Game.compressedSize);
-        if(compressedBuffer == NULL)
-        {
-            jo_core_error("Failed to allocate compression buffer!!");
-            transitionToState(STATE_MAIN);
-            return;
-        }
+// moves a streamed image on to its next checkpoint, playSaves_draw() encodes and starts it
+static void nextCheckpoint(void)
+{
+    if(copyBIOSCheckpoint(g_Game.checkpoint + 1) != 0)
+    {
+        transitionToState(STATE_MAIN);
+        return;
+    }
 
-        result = compressBuffer(g_Game.transmissionData, uncompressedSize, compressedBuffer, &g_Game.compressedSize);
-        if(result != 0)
+    resetEncoding();
+    g_Game.autoStart = true;
+}
+
+// replaces a known image record with the data itself
+static int sendInFull(void)
+{
+    int result = 0;
+
+    g_Game.sendInFull = true;
+
+    // a known BIOS is the only known image sent as a checkpoint
+    result = (g_Game.numCheckpoints != 0) ? copyBIOSImage() : copySaveFile();
+    if(result != 0)
+    {
+        return result;
+    }
+
+    resetEncoding();
+    return 0;
+}
+
+// draws the play saves screen
+void playSaves_draw(void)
+{
+    // last values drawn, only the fields that changed are printed again
+    static unsigned int drawnBytes = 0;
+    static unsigned int drawnRate = 0;
+    static unsigned int drawnSeconds = 0;
+    static unsigned int drawnFinish = 0;
+    static bool drawnRunning = false;
+    static unsigned int drawnCodeword = 0;
+    static bool drawnHashing = false;
+
+    int result = 0;
+    int y = 0;
+    unsigned int bytesTransferred = 0;
+    unsigned int totalSize = 0;
+    unsigned int bytesPerSecond = 0;
+    unsigned int secondsLeft = 0;
+    unsigned int finishTime = 0;
+    bool statusValid = false;
+    jo_backup_date jo_date = {0};
+    jo_datetime now = {0};
+    bool hasMd5 = (g_Game.integrity & (INTEGRITY_MD5 | INTEGRITY_IMAGE_MD5)) != 0; // image MD5 so far when streaming
+
+    // only compute the MD5 hash once
+    if(g_Game.md5Calculated == false)
+    {
+        // skipping ahead in a stream hashes the image up to the checkpoint first,
+        // say so for a frame before the screen stops updating
+        if(drawnHashing == false && encodeImageMd5Backlog() > BIOS_CHECKPOINT_SIZE)
         {
-            // something went wrong
-            transitionToState(STATE_MAIN);
+            jo_printf(OPTIONS_X, OPTIONS_Y, "Hashing the image: %dk", encodeImageMd5Backlog() / 1024);
+            drawnHashing = true;
             return;
         }
+        drawnHashing = false;
+
+        // MD5, compress, Reed Solomon encode and escape the save
+        profileReset();
+        result = encodeTransmission();
 
-        //
-        // Reed Solomon encode the compressed buffer
-        //
-        unencodedSize = g_Game.compressedSize;
-        g_Game.encodedTransmissionSize = reedSolomonOutSize(unencodedSize);
+        // the save has been consumed, only the encoded transmission is needed now
+        freeSaveFile();
 
-        g_Game.encodedTransmissionData = jo_malloc(g_Game.encodedTransmissionSize);
-        if(g_Game.encodedTransmissionData == NULL)
+        if(result != 0)
         {
-            jo_core_error("Failed to allocate Reed Solomon buffer!!");
+            // something went wrong
             transitionToState(STATE_MAIN);
             return;
         }
-        jo_memset(g_Game.encodedTransmissionData, 0, g_Game.encodedTransmissionSize);
 
-        result = reedSolomonEncode(compressedBuffer, unencodedSize, g_Game.encodedTransmissionData);
-        if(result != 0)
+        g_Game.md5Calculated = true;
+        g_Game.redraw = true;
+
+        // the user started the stream, the checkpoints after the first go out unattended
+        // A checkpoint picked with Up/Down waits for Start so a resume codeword can be set
+        if(g_Game.autoStart)
         {
-            jo_core_error("Failed to Reed Solomon encode data!!");
-            jo_free(g_Game.encodedTransmissionData);
-            jo_free(compressedBuffer);
-            g_Game.encodedTransmissionData = NULL;
-            g_Game.encodedTransmissionSize = 0;
-            transitionToState(STATE_MAIN);
-            return;
+            g_Game.autoStart = false;
+            if(startTransmission() != 0)
+            {
+                transitionToState(STATE_MAIN);
+                return;
+            }
         }
+    }
 
-        // no longer need the compressed buffer
-        jo_memset(compressedBuffer, 0, g_Game.compressedSize);
-        jo_free(compressedBuffer);
+    // the save details don't change once encoded
+    if(g_Game.redraw)
+    {
+        jo_printf(HEADING_X, HEADING_Y, "Transmitting Data Over Audio");
+        jo_printf(HEADING_X, HEADING_Y + 1, HEADING_UNDERSCORE);
 
+        // convert between internal date and jo_date
+        bup_getdate(g_Game.saveDate, &jo_date);
 
-        // escape the buffer if necessary
-        result = escapeBuffer(&g_Game.encodedTransmissionData, &g_Game.encodedTransmissionSize);
-        if(result != 0)
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Filename: %s        ", g_Game.saveFilename);
+        if(g_Game.numCheckpoints != 0)
         {
-            jo_core_error("Failed to escape the data!!");
-            jo_free(g_Game.encodedTransmissionData);
-            g_Game.encodedTransmissionData = NULL;
-            g_Game.encodedTransmissionSize = 0;
-            transitionToState(STATE_MAIN);
+            jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Checkpoint: %d/%d         ", g_Game.checkpoint + 1, g_Game.numCheckpoints);
+        }
+        else
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Comment: %s         ", g_Game.saveComment);
+        }
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Date: %d/%d/%d %d:%d         ", jo_date.month, jo_date.day, jo_date.year + 1980, jo_date.time, jo_date.min);
+        if(hasMd5)
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + y++, "MD5: %02x%02x%02x%02x%02x%02x%02x%02x", g_Game.md5Hash[0], g_Game.md5Hash[1], g_Game.md5Hash[2], g_Game.md5Hash[3], g_Game.md5Hash[4], g_Game.md5Hash[5], g_Game.md5Hash[6], g_Game.md5Hash[7]);
+            jo_printf(OPTIONS_X, OPTIONS_Y + y++, "     %02x%02x%02x%02x%02x%02x%02x%02x", g_Game.md5Hash[8], g_Game.md5Hash[9], g_Game.md5Hash[10], g_Game.md5Hash[11],  g_Game.md5Hash[12], g_Game.md5Hash[13], g_Game.md5Hash[14], g_Game.md5Hash[15]);
         }
 
-        g_Game.md5Calculated = true;
-    }
+        if(g_Game.integrity & INTEGRITY_CRC32)
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + y++, "CRC32: %08x", g_Game.crc);
+        }
+
+        // keep the rest of the screen where it was with just the MD5
+        if(hasMd5 == false)
+        {
+            y++;
+        }
 
-    // convert between internal date and jo_date
-    bup_getdate(g_Game.saveDate, &jo_date);
+        y++;
 
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Filename: %s        ", g_Game.saveFilename);
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Comment: %s         ", g_Game.saveComment);
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Date: %d/%d/%d %d:%d         ", jo_date.month, jo_date.day, jo_date.year + 1980, jo_date.time, jo_date.min);
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "MD5: %02x%02x%02x%02x%02x%02x%02x%02x", g_Game.md5Hash[0], g_Game.md5Hash[1], g_Game.md5Hash[2], g_Game.md5Hash[3], g_Game.md5Hash[4], g_Game.md5Hash[5], g_Game.md5Hash[6], g_Game.md5Hash[7]);
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "     %02x%02x%02x%02x%02x%02x%02x%02x", g_Game.md5Hash[8], g_Game.md5Hash[9], g_Game.md5Hash[10], g_Game.md5Hash[11],  g_Game.md5Hash[12], g_Game.md5Hash[13], g_Game.md5Hash[14], g_Game.md5Hash[15]);
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Size: %d            ", g_Game.saveFileSize);
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Compressed Size: %d            ", g_Game.compressedSize);
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Total Size: %d          ", g_Game.encodedTransmissionSize);
+    }
 
-    y++;
+    // status lines start below the fixed ones, a line lower with both checks shown
+    y = (hasMd5 && (g_Game.integrity & INTEGRITY_CRC32)) ? 10 : 9;
 
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Size: %d            ", g_Game.saveFileSize);
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Compressed Size: %d            ", g_Game.compressedSize);
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Total Size: %d          ", g_Game.encodedTransmissionSize);
+    if(g_Game.isTransmissionRunning)
+    {
+        result = SaturnMinimodem_transfer();
+        if(result < 0)
+        {
+            jo_core_error("something went wrong!!\n");
+            g_Game.isTransmissionRunning = false;
+        }
+        else if(result == TRANSFER_COMPLETE)
+        {
+            g_Game.isTransmissionRunning = false;
 
-    result = SaturnMinimodem_transferStatus(&bytesTransferred, &totalSize);
-    if(result == 0)
+            // a streamed image goes straight on to its next checkpoint
+            if(g_Game.numCheckpoints != 0 && g_Game.checkpoint + 1 < g_Game.numCheckpoints)
+            {
+                nextCheckpoint();
+                return;
+            }
+        }
+    }
+
+    if(g_Game.redraw || drawnCodeword != g_Game.resumeCodeword)
     {
-        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Bytes Sent: %d                ", bytesTransferred);
+        jo_printf(OPTIONS_X, OPTIONS_Y + y + 6, "Start At Codeword: %d/%d        ", g_Game.resumeCodeword,
+                  reedSolomonNumCodewords(g_Game.compressedSize));
+        drawnCodeword = g_Game.resumeCodeword;
     }
-    else
-    {   // it's ok to fail, that just means our transfer hasn't startedd
-        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Bytes Sent: N/A                ");
+
+    if(g_Game.redraw)
+    {
+        jo_printf(OPTIONS_X, OPTIONS_Y + y + 7, g_Game.numCheckpoints > 1 ? "<- ->/L R:Codeword Up/Down:Chkpt" : "<- ->/L R:Codeword");
     }
 
-    int estimatedTimeLeft = ((g_Game.encodedTransmissionSize - bytesTransferred) * 8)/ESTIMATED_TRANSFER_SPEED;
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Est Time: %d                   ", estimatedTimeLeft);
+    if(g_Game.redraw || drawnRunning != g_Game.isTransmissionRunning)
+    {
+        if(g_Game.knownImage != 0)
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + y + 4, "Known: %s X:Full", knownImageName(g_Game.knownImage));
+        }
 
+        if(g_Game.isTransmissionRunning == false)
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + y + 5, "Press C to play the data        ");
+        }
+        else
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + y + 5, "Press B to stop playing the data");
+        }
+        drawnRunning = g_Game.isTransmissionRunning;
+    }
+
+    if(transferStatusDue() == false)
+    {
+        return;
+    }
 
-     y++;
+    result = SaturnMinimodem_transferStatus(&bytesTransferred, &totalSize);
+    statusValid = (result == 0);
 
-    if(g_Game.isTransmissionRunning == false)
+    // measured rate once blocks have been sent, the on-air rate before that
+    result = SaturnMinimodem_transferEstimate(&bytesPerSecond, &secondsLeft);
+    if(result != 0 || g_Game.isTransmissionRunning == false)
     {
-        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Press C to play the data        ");
+        MODEM_CONFIG config = {0};
+
+        SaturnMinimodem_getConfig(&config);
+        bytesPerSecond = config.dataRate / (config.numStartBits + 8 + config.numStopBits);
+        bytesPerSecond = bytesPerSecond ? bytesPerSecond : 1;
+        totalSize = statusValid ? totalSize : g_Game.encodedTransmissionSize;
+        secondsLeft = (totalSize - bytesTransferred + bytesPerSecond - 1) / bytesPerSecond;
     }
-    else
+
+    // the checkpoints still to come are about the size of this one
+    if(g_Game.numCheckpoints != 0 && bytesPerSecond != 0)
     {
-        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Press B to stop playing the data");
+        secondsLeft += (g_Game.numCheckpoints - g_Game.checkpoint - 1) * g_Game.encodedTransmissionSize / bytesPerSecond;
+    }
 
-        result = SaturnMinimodem_transfer();
-        if(result < 0)
+    // projected completion from the real time clock
+    jo_getdate(&now);
+    finishTime = now.hour * 3600 + now.minute * 60 + now.second + secondsLeft;
+
+    if(g_Game.redraw || statusValid == false || bytesTransferred != drawnBytes)
+    {
+        if(statusValid)
         {
-            jo_core_error("something went wrong!!\n");
-            g_Game.isTransmissionRunning = false;
+            jo_printf(OPTIONS_X, OPTIONS_Y + y, "Bytes Sent: %d                ", bytesTransferred);
         }
-        else if(result == TRANSFER_COMPLETE)
-        {
-            g_Game.isTransmissionRunning = false;
+        else
+        {   // it's ok to fail, that just means our transfer hasn't startedd
+            jo_printf(OPTIONS_X, OPTIONS_Y + y, "Bytes Sent: N/A                ");
         }
+        drawnBytes = bytesTransferred;
+    }
+    y++;
+
+    if(g_Game.redraw || bytesPerSecond != drawnRate)
+    {
+        jo_printf(OPTIONS_X, OPTIONS_Y + y, "Rate: %d bytes/s             ", bytesPerSecond);
+        drawnRate = bytesPerSecond;
+    }
+    y++;
+
+    if(g_Game.redraw || secondsLeft != drawnSeconds)
+    {
+        jo_printf(OPTIONS_X, OPTIONS_Y + y, "ETA: %d:%02d:%02d                ",
+                  secondsLeft / 3600, (secondsLeft / 60) % 60, secondsLeft % 60);
+        drawnSeconds = secondsLeft;
+    }
+    y++;
+
+    // minute resolution on screen
+    if(g_Game.redraw || finishTime / 60 != drawnFinish / 60)
+    {
+        jo_printf(OPTIONS_X, OPTIONS_Y + y, "Done At: %02d:%02d +%d days        ",
+                  (finishTime / 3600) % 24, (finishTime / 60) % 60, finishTime / (24 * 3600));
+        drawnFinish = finishTime;
     }
 
     return;
@@ -795,13 +1192,9 @@ void playSaves_draw(void)
 
 // handles input on the play saves screen
 // B returns to the main menu
+// Left/Right and L/R pick the codeword to start from, Up/Down the checkpoint of a stream
 void playSaves_input(void)
 {
-    if(g_Game.state != STATE_PLAY_SAVES)
-    {
-        return;
-    }
-
     // did the player hit start
     if(jo_is_pad1_key_pressed(JO_KEY_START) ||
        jo_is_pad1_key_pressed(JO_KEY_A) ||
@@ -812,17 +1205,14 @@ void playSaves_input(void)
             g_Game.input.pressedStartAC = true;
 
             // the test is not currently running, start the test
+            // the user started it, minimodem may still be on the default settings
             if(g_Game.isTransmissionRunning == false)
             {
-                if(g_Game.encodedTransmissionData == NULL || g_Game.encodedTransmissionSize == 0)
+                if(announceSpeed() != 0 || startTransmission() != 0)
                 {
-                    jo_core_error("Transmission data isn't initialized!!");
                     transitionToState(STATE_MAIN);
                     return;
                 }
-
-                SaturnMinimodem_initTransfer(g_Game.encodedTransmissionData, g_Game.encodedTransmissionSize);
-                g_Game.isTransmissionRunning = true;
             }
             return;
         }
@@ -832,6 +1222,29 @@ void playSaves_input(void)
         g_Game.input.pressedStartAC = false;
     }
 
+    // did the player hit x, send a known image in full after all
+    if(jo_is_pad1_key_pressed(JO_KEY_X))
+    {
+        if(g_Game.input.pressedX == false && g_Game.knownImage != 0 && g_Game.isTransmissionRunning == false)
+        {
+            g_Game.input.pressedX = true;
+
+            if(sendInFull() != 0)
+            {
+                transitionToState(STATE_MAIN);
+                return;
+            }
+
+            // the known line goes and the sizes change, everything is drawn again once encoded
+            clearScreen();
+            return;
+        }
+    }
+    else
+    {
+        g_Game.input.pressedX = false;
+    }
+
     if(jo_is_pad1_key_pressed(JO_KEY_B))
     {
         if(g_Game.input.pressedB == false)
@@ -846,51 +1259,98 @@ void playSaves_input(void)
         g_Game.input.pressedB = false;
     }
 
-    // update the cursor
-    moveCursor(false);
+    // pick the codeword and checkpoint to resume from before starting
+    if(g_Game.isTransmissionRunning == false)
+    {
+        unsigned int numCodewords = reedSolomonNumCodewords(g_Game.compressedSize);
+        int step = 0;
+
+        step -= keyPressedOnce(JO_KEY_LEFT, &g_Game.input.pressedLeft) ? 1 : 0;
+        step += keyPressedOnce(JO_KEY_RIGHT, &g_Game.input.pressedRight) ? 1 : 0;
+        step -= keyPressedOnce(JO_KEY_L, &g_Game.input.pressedLT) ? 100 : 0;
+        step += keyPressedOnce(JO_KEY_R, &g_Game.input.pressedRT) ? 100 : 0;
+
+        if(step < 0)
+        {
+            g_Game.resumeCodeword = (unsigned int)-step > g_Game.resumeCodeword ? 0 : g_Game.resumeCodeword + step;
+        }
+        else if(step > 0 && numCodewords != 0)
+        {
+            g_Game.resumeCodeword = g_Game.resumeCodeword + step >= numCodewords ? numCodewords - 1 : g_Game.resumeCodeword + step;
+        }
+
+        // a known image is a single checkpoint
+        if(g_Game.numCheckpoints > 1)
+        {
+            step = 0;
+            step -= keyPressedOnce(JO_KEY_UP, &g_Game.input.pressedUp) ? 1 : 0;
+            step += keyPressedOnce(JO_KEY_DOWN, &g_Game.input.pressedDown) ? 1 : 0;
+
+            if(step != 0)
+            {
+                if(copyBIOSCheckpoint((g_Game.checkpoint + g_Game.numCheckpoints + step) % g_Game.numCheckpoints) != 0)
+                {
+                    transitionToState(STATE_MAIN);
+                    return;
+                }
+
+                // encoded and drawn again on the next frame
+                resetEncoding();
+                clearScreen();
+            }
+        }
+    }
+
     return;
 }
 
 const char* BIOS_FILENAMES[] = {"BIOS.BIN.1", "BIOS.BIN.2", "BIOS.BIN.3", "BIOS.BIN.4"};
 
 // draws the dump bios screen
+// everything but the cursor only changes when the screen is entered
 void dumpBios_draw(void)
 {
-    if(g_Game.state != STATE_DUMP_BIOS)
+    // the BIOS doesn't change, hash it once
+    if(g_Game.md5BiosCalculated == false)
     {
-        return;
-    }
+        int result = 0;
 
-    jo_printf(HEADING_X, HEADING_Y, "Dump Bios");
-    jo_printf(HEADING_X, HEADING_Y + 1, HEADING_UNDERSCORE);
+        result = calculateMD5Hash(BIOS_START_ADDR, BIOS_SIZE, g_Game.md5BiosHash);
+        if(result != 0)
+        {
+            // something went wrong
+            transitionToState(STATE_MAIN);
+            return;
+        }
 
-    jo_printf(OPTIONS_X, OPTIONS_Y, "%-11s %10s", "Filename", "Bytes");
-    for(int i = 0; i < 4; i++)
-    {
-        jo_printf(OPTIONS_X, OPTIONS_Y + i + 1, "%-11s %10d", BIOS_FILENAMES[i], BIOS_SIZE/4);
+        g_Game.knownBios = knownImageFind(g_Game.md5BiosHash, BIOS_SIZE);
+        g_Game.md5BiosCalculated = true;
+        g_Game.redraw = true;
     }
 
-    if(g_Game.md5BiosCalculated == false)
-	{
-		int result = 0;
+    if(g_Game.redraw)
+    {
+        jo_printf(HEADING_X, HEADING_Y, "Dump Bios");
+        jo_printf(HEADING_X, HEADING_Y + 1, HEADING_UNDERSCORE);
 
-		result = calculateMD5Hash(BIOS_START_ADDR, BIOS_SIZE, g_Game.md5BiosHash);
-		if(result != 0)
-		{
-			// something went wrong
-			transitionToState(STATE_MAIN);
-			return;
-		}
+        jo_printf(OPTIONS_X, OPTIONS_Y, "%-11s %10s", "Filename", "Bytes");
 
-		g_Game.md5BiosCalculated = true;
-	}
+        // the whole BIOS in one unattended stream, then each segment on its own
+        jo_printf(OPTIONS_X, OPTIONS_Y + 1, "%-11s %10d", BIOS_FILENAME, BIOS_SIZE);
+        for(int i = 0; i < BIO_NUM_SEGMENTS; i++)
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + i + 2, "%-11s %10d", BIOS_FILENAMES[i], BIOS_SIZE/4);
+        }
 
-    jo_printf(OPTIONS_X, OPTIONS_Y + 6, "BIOS MD5: %02x%02x%02x%02x%02x%02x%02x%02x", g_Game.md5BiosHash[0], g_Game.md5BiosHash[1], g_Game.md5BiosHash[2], g_Game.md5BiosHash[3], g_Game.md5BiosHash[4], g_Game.md5BiosHash[5], g_Game.md5BiosHash[6], g_Game.md5BiosHash[7]);
-    jo_printf(OPTIONS_X, OPTIONS_Y + 7, "          %02x%02x%02x%02x%02x%02x%02x%02x", g_Game.md5BiosHash[8], g_Game.md5BiosHash[9], g_Game.md5BiosHash[10], g_Game.md5BiosHash[11],  g_Game.md5BiosHash[12], g_Game.md5BiosHash[13], g_Game.md5BiosHash[14], g_Game.md5BiosHash[15]);
+        jo_printf(OPTIONS_X, OPTIONS_Y + 7, "BIOS MD5: %02x%02x%02x%02x%02x%02x%02x%02x", g_Game.md5BiosHash[0], g_Game.md5BiosHash[1], g_Game.md5BiosHash[2], g_Game.md5BiosHash[3], g_Game.md5BiosHash[4], g_Game.md5BiosHash[5], g_Game.md5BiosHash[6], g_Game.md5BiosHash[7]);
+        jo_printf(OPTIONS_X, OPTIONS_Y + 8, "          %02x%02x%02x%02x%02x%02x%02x%02x", g_Game.md5BiosHash[8], g_Game.md5BiosHash[9], g_Game.md5BiosHash[10], g_Game.md5BiosHash[11],  g_Game.md5BiosHash[12], g_Game.md5BiosHash[13], g_Game.md5BiosHash[14], g_Game.md5BiosHash[15]);
 
-    // bugbug use strncpy here
-    strncpy(g_Game.saveFilename, BIOS_FILENAMES[g_Game.cursorOffset], sizeof(g_Game.saveFilename) - 1);
-    g_Game.saveFileSize = BIOS_SIZE/4;
+        // a known BIOS only needs its record sent
+        if(g_Game.knownBios != 0)
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + 10, "Known: %s", knownImageName(g_Game.knownBios));
+        }
+    }
 
     // cursor
     jo_printf(g_Game.cursorPosX, g_Game.cursorPosY + g_Game.cursorOffset, ">>");
@@ -904,11 +1364,6 @@ void dumpBios_input(void)
 {
     int result = 0;
 
-    if(g_Game.state != STATE_DUMP_BIOS)
-    {
-        return;
-    }
-
     // did the player hit start
     if(jo_is_pad1_key_pressed(JO_KEY_START) ||
        jo_is_pad1_key_pressed(JO_KEY_A) ||
@@ -918,7 +1373,15 @@ void dumpBios_input(void)
         {
             g_Game.input.pressedStartAC = true;
 
-            result = copyBIOS(g_Game.cursorOffset);
+            if(g_Game.cursorOffset == 0)
+            {
+                result = copyBIOSImage();
+            }
+            else
+            {
+                result = copyBIOS(g_Game.cursorOffset - 1);
+            }
+
             if(result != 0)
             {
                 // something went wrong
@@ -953,39 +1416,217 @@ void dumpBios_input(void)
     return;
 }
 
-// draws the test screen
-void test_draw(void)
+// start+stop bits the test screen can try, the rates are TONE_PLAN_RATES
+static const unsigned int TEST_FRAMINGS[][2] = {{1, 1}, {1, 2}, {2, 2}, {4, 4}};
+
+#define TEST_NUM_FRAMINGS   (sizeof(TEST_FRAMINGS) / sizeof(TEST_FRAMINGS[0]))
+
+// bits the tone transitions take, for trying shaped transitions against sgex-ber
+static const float TEST_SHAPINGS[] = {0, 0.25f, 0.5f, 1};
+static const char* TEST_SHAPING_NAMES[] = {"Off", "1/4 bit", "1/2 bit", "1 bit"};
+
+#define TEST_NUM_SHAPINGS   (sizeof(TEST_SHAPINGS) / sizeof(TEST_SHAPINGS[0]))
+
+static const char* TEST_PATTERN_NAMES[TEST_NUM_PATTERNS] = {"Message", "PRBS-15", "PRBS-23", "Sweep"};
+
+// modem settings when the test screen was entered, put back when leaving it
+static MODEM_CONFIG g_TestSavedConfig = {0};
+
+// tone plan code being entered and the digit Left/Right changes
+static unsigned char g_TestCode[TONE_PLAN_CODE_DIGITS] = {0};
+static unsigned int g_TestCodeDigit = 0;
+static const char* g_TestStatus = NULL; // result of the last code entered
+
+// name of a MODEM_OUTPUT_ value for the test screen
+static const char* modemOutputName(unsigned int output)
 {
-    int result;
-    unsigned int y = 0;
+    switch(output)
+    {
+        case MODEM_OUTPUT_SAMPLES:
+            return "Samples";
+        case MODEM_OUTPUT_68K:
+            return "68000";
+        case MODEM_OUTPUT_PITCH:
+            return "SCSP Pitch";
+    }
+
+    return "?";
+}
+
+// restarts the modem with new settings
+static int reopenModem(PMODEM_CONFIG config)
+{
+    SaturnMinimodem_close();
+    if(SaturnMinimodem_setConfig(config) != 0 || SaturnMinimodem_init() != 0)
+    {
+        jo_core_error("Failed to change the modem settings!!");
+        return -1;
+    }
 
-    if(g_Game.state != STATE_TEST)
+    return 0;
+}
+
+// index of the current rate or framing in the test screen lists, the first if it isn't one of them
+static unsigned int testRateIndex(PMODEM_CONFIG config)
+{
+    for(unsigned int i = 0; i < TONE_PLAN_NUM_RATES; i++)
+    {
+        if((unsigned int)config->dataRate == TONE_PLAN_RATES[i])
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+static unsigned int testFramingIndex(PMODEM_CONFIG config)
+{
+    for(unsigned int i = 0; i < TEST_NUM_FRAMINGS; i++)
+    {
+        if(config->numStartBits == TEST_FRAMINGS[i][0] && config->numStopBits == TEST_FRAMINGS[i][1])
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+static unsigned int testShapingIndex(PMODEM_CONFIG config)
+{
+    for(unsigned int i = 0; i < TEST_NUM_SHAPINGS; i++)
+    {
+        if(config->transitionBits == TEST_SHAPINGS[i])
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+// remembers the modem settings so the test screen can change them freely
+// the code starts out as the tone plan in use
+void test_enter(void)
+{
+    TONE_PLAN plan = {0};
+    unsigned int code = 0;
+
+    SaturnMinimodem_getConfig(&g_TestSavedConfig);
+
+    plan.dataRate = g_TestSavedConfig.dataRate;
+    plan.markFreq = g_TestSavedConfig.markFreq;
+    plan.spaceFreq = g_TestSavedConfig.spaceFreq;
+    tonePlanEncode(&plan, &code);
+
+    for(int i = TONE_PLAN_CODE_DIGITS - 1; i >= 0; i--)
+    {
+        g_TestCode[i] = code % 10;
+        code /= 10;
+    }
+    g_TestCodeDigit = 0;
+    g_TestStatus = NULL;
+}
+
+// the rate, framing and shaping only apply to the test, the output and an entered tone plan are kept
+static void test_leave(void)
+{
+    MODEM_CONFIG config = {0};
+
+    SaturnMinimodem_getConfig(&config);
+    if(config.dataRate == g_TestSavedConfig.dataRate &&
+       config.markFreq == g_TestSavedConfig.markFreq &&
+       config.spaceFreq == g_TestSavedConfig.spaceFreq &&
+       config.numStartBits == g_TestSavedConfig.numStartBits &&
+       config.numStopBits == g_TestSavedConfig.numStopBits &&
+       config.transitionBits == g_TestSavedConfig.transitionBits)
     {
         return;
     }
 
-    // heading
-    jo_printf(HEADING_X, HEADING_Y + y++, "Test Audio Transmission");
-    jo_printf(HEADING_X, HEADING_Y + y++, HEADING_UNDERSCORE);
+    config.dataRate = g_TestSavedConfig.dataRate;
+    config.markFreq = g_TestSavedConfig.markFreq;
+    config.spaceFreq = g_TestSavedConfig.spaceFreq;
+    config.numStartBits = g_TestSavedConfig.numStartBits;
+    config.numStopBits = g_TestSavedConfig.numStopBits;
+    config.transitionBits = g_TestSavedConfig.transitionBits;
+    reopenModem(&config);
+}
 
-    y = 0;
+// switches to the tone plan of the code entered for the rest of the session
+static void testApplyCode(void)
+{
+    MODEM_CONFIG config = {0};
+    TONE_PLAN plan = {0};
+    unsigned int code = 0;
 
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "The test sends the string:");
-    y++;
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "    This ");
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "      is ");
-    jo_printf(OPTIONS_X, OPTIONS_Y + y++, "      COOL");
+    for(unsigned int i = 0; i < TONE_PLAN_CODE_DIGITS; i++)
+    {
+        code = code * 10 + g_TestCode[i];
+    }
 
-    y++;
+    if(tonePlanDecode(code, &plan) != 0)
+    {
+        g_TestStatus = "Invalid code, check the digits";
+        return;
+    }
 
-    if(g_Game.isTransmissionRunning == false)
+    SaturnMinimodem_getConfig(&config);
+    config.dataRate = plan.dataRate;
+    config.markFreq = plan.markFreq;
+    config.spaceFreq = plan.spaceFreq;
+    if(reopenModem(&config) != 0)
     {
-        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Press C to play the test        ");
+        return;
     }
-    else
+
+    g_TestSavedConfig.dataRate = plan.dataRate;
+    g_TestSavedConfig.markFreq = plan.markFreq;
+    g_TestSavedConfig.spaceFreq = plan.spaceFreq;
+    g_TestStatus = "Tone plan in use until power off";
+}
+
+// fills the transfer arena with PRBS_TEST_SIZE bytes of the selected sequence
+static unsigned char* testPrbsData(unsigned int order)
+{
+    unsigned char* data = NULL;
+    PRBS prbs = {0};
+
+    if(prbsInit(&prbs, order) != 0)
+    {
+        return NULL;
+    }
+
+    arenaRelease(&g_Arena, g_Game.transferArenaMark);
+
+    data = arenaAlloc(&g_Arena, PRBS_TEST_SIZE);
+    if(data == NULL)
     {
-        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Press B to stop playing the test");
+        jo_core_error("Failed to allocate the PRBS test!!");
+        return NULL;
+    }
 
+    for(unsigned int i = 0; i < PRBS_TEST_SIZE; i++)
+    {
+        data[i] = prbsNextByte(&prbs);
+    }
+
+    return data;
+}
+
+// draws the test screen
+void test_draw(void)
+{
+    static bool drawnRunning = false;
+    MODEM_CONFIG config = {0};
+    unsigned int bytesSent = 0;
+    unsigned int bytesTotal = 0;
+    int result;
+    unsigned int y = 0;
+
+    if(g_Game.isTransmissionRunning)
+    {
         result = SaturnMinimodem_transfer();
         if(result < 0)
         {
@@ -998,18 +1639,149 @@ void test_draw(void)
         }
     }
 
+    if(g_Game.redraw)
+    {
+        // heading
+        jo_printf(HEADING_X, HEADING_Y + y++, "Test Audio Transmission");
+        jo_printf(HEADING_X, HEADING_Y + y++, HEADING_UNDERSCORE);
+
+        jo_printf(OPTIONS_X, OPTIONS_Y + 11, "Up/Down:Select Left/Right:Change");
+    }
+
+    if(g_Game.redraw || g_Game.isTransmissionRunning == false)
+    {
+        // the backend actually opened, the 68000 and pitch outputs fall back to samples
+        SaturnMinimodem_getConfig(&config);
+
+        y = 0;
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Pattern: %s   ", TEST_PATTERN_NAMES[g_Game.testPattern]);
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Baud:    %d   ", (unsigned int)config.dataRate);
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Framing: %d+%d start+stop bits", config.numStartBits, config.numStopBits);
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Shaping: %s   ", TEST_SHAPING_NAMES[testShapingIndex(&config)]);
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Output:  %s       ", modemOutputName(config.output));
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Code:    %d%d%d%d", g_TestCode[0], g_TestCode[1], g_TestCode[2], g_TestCode[3]);
+
+        // which digit Left/Right changes
+        if(g_Game.cursorOffset == TEST_OPTION_CODE)
+        {
+            char caret[TONE_PLAN_CODE_DIGITS + 1] = "    ";
+
+            caret[g_TestCodeDigit] = '^';
+            jo_printf(OPTIONS_X, OPTIONS_Y + y++, "         %s L/R:Digit C:Use", caret);
+        }
+        else
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + y++, "                               ");
+        }
+
+        jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Tones:   %d/%d Hz   ", (unsigned int)config.markFreq, (unsigned int)config.spaceFreq);
+
+        y++;
+        switch(g_Game.testPattern)
+        {
+            case TEST_PATTERN_MESSAGE:
+                jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Sends \"This is COOL\"          ");
+                jo_printf(OPTIONS_X, OPTIONS_Y + y++, "                              ");
+                break;
+
+            case TEST_PATTERN_SWEEP:
+                jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Sends %d tones from %d Hz  ", SWEEP_NUM_STEPS, SWEEP_START_FREQ);
+                jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Enter the code sgex-sweep gives");
+                break;
+
+            default:
+                jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Sends %d bytes of %s ", PRBS_TEST_SIZE, TEST_PATTERN_NAMES[g_Game.testPattern]);
+                jo_printf(OPTIONS_X, OPTIONS_Y + y++, "Measure it with sgex-ber        ");
+                break;
+        }
+
+        if(g_TestStatus != NULL)
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + y - 1, "%-31s", g_TestStatus);
+        }
+
+        jo_printf(g_Game.cursorPosX, g_Game.cursorPosY + g_Game.cursorOffset, ">>");
+    }
+
+    if(g_Game.redraw || drawnRunning != g_Game.isTransmissionRunning)
+    {
+        y = 12;
+
+        if(g_Game.isTransmissionRunning == false)
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + y, "Press C to play the test        ");
+            jo_printf(OPTIONS_X, OPTIONS_Y + y + 1, "                          ");
+        }
+        else
+        {
+            jo_printf(OPTIONS_X, OPTIONS_Y + y, "Press B to stop playing the test");
+        }
+        drawnRunning = g_Game.isTransmissionRunning;
+    }
+
+    if(g_Game.isTransmissionRunning && transferStatusDue() &&
+       SaturnMinimodem_transferStatus(&bytesSent, &bytesTotal) == 0)
+    {
+        jo_printf(OPTIONS_X, OPTIONS_Y + 13, "Sent: %d/%d %s", bytesSent, bytesTotal,
+                  g_Game.testPattern == TEST_PATTERN_SWEEP ? "tones" : "bytes");
+    }
+
     return;
 }
 
-// handles input on the credits screen
-// Any button press returns back to title screen
-void test_input(void)
+// changes the selected test setting by one step
+static void testChangeOption(int step)
 {
-    if(g_Game.state != STATE_TEST)
+    MODEM_CONFIG config = {0};
+    unsigned int index = 0;
+
+    SaturnMinimodem_getConfig(&config);
+    g_TestStatus = NULL;
+
+    switch(g_Game.cursorOffset)
     {
-        return;
+        case TEST_OPTION_PATTERN:
+            g_Game.testPattern = (g_Game.testPattern + TEST_NUM_PATTERNS + step) % TEST_NUM_PATTERNS;
+            return;
+
+        case TEST_OPTION_RATE:
+            index = (testRateIndex(&config) + TONE_PLAN_NUM_RATES + step) % TONE_PLAN_NUM_RATES;
+            config.dataRate = TONE_PLAN_RATES[index];
+            config.markFreq = 0;
+            config.spaceFreq = 0;
+            break;
+
+        case TEST_OPTION_FRAMING:
+            index = (testFramingIndex(&config) + TEST_NUM_FRAMINGS + step) % TEST_NUM_FRAMINGS;
+            config.numStartBits = TEST_FRAMINGS[index][0];
+            config.numStopBits = TEST_FRAMINGS[index][1];
+            break;
+
+        case TEST_OPTION_SHAPING:
+            index = (testShapingIndex(&config) + TEST_NUM_SHAPINGS + step) % TEST_NUM_SHAPINGS;
+            config.transitionBits = TEST_SHAPINGS[index];
+            break;
+
+        case TEST_OPTION_OUTPUT:
+            config.output = (config.output + MODEM_OUTPUT_PITCH + 1 + step) % (MODEM_OUTPUT_PITCH + 1);
+            break;
+
+        case TEST_OPTION_CODE:
+            g_TestCode[g_TestCodeDigit] = (g_TestCode[g_TestCodeDigit] + 10 + step) % 10;
+            return;
+
+        default:
+            return;
     }
 
+    reopenModem(&config);
+}
+
+// handles input on the test screen
+// Up/Down and Left/Right pick the test, C plays it and B returns to the title screen
+// On the code row L/R pick the digit and C switches to its tone plan
+void test_input(void)
+{
     // did the player hit start
     if(jo_is_pad1_key_pressed(JO_KEY_START) ||
        jo_is_pad1_key_pressed(JO_KEY_A) ||
@@ -1019,11 +1791,37 @@ void test_input(void)
         {
             g_Game.input.pressedStartAC = true;
 
+            if(g_Game.isTransmissionRunning == false && g_Game.cursorOffset == TEST_OPTION_CODE)
+            {
+                testApplyCode();
+                return;
+            }
+
             // the test is not currently running, start the test
             if(g_Game.isTransmissionRunning == false)
             {
-                SaturnMinimodem_initTransfer((unsigned char*)TEST_MESSAGE, strlen(TEST_MESSAGE));
-                g_Game.isTransmissionRunning = true;
+                unsigned char* data = (unsigned char*)TEST_MESSAGE;
+                unsigned int size = strlen(TEST_MESSAGE);
+
+                profileReset();
+
+                if(g_Game.testPattern == TEST_PATTERN_SWEEP)
+                {
+                    g_Game.isTransmissionRunning = SaturnMinimodem_initSweep(SWEEP_START_FREQ, SWEEP_STEP_FREQ, SWEEP_NUM_STEPS,
+                                                                             SWEEP_STEP_MS, SWEEP_GAP_MS) == 0;
+                    return;
+                }
+
+                if(g_Game.testPattern != TEST_PATTERN_MESSAGE)
+                {
+                    data = testPrbsData(g_Game.testPattern == TEST_PATTERN_PRBS15 ? PRBS_15 : PRBS_23);
+                    size = PRBS_TEST_SIZE;
+                }
+
+                if(data != NULL && SaturnMinimodem_initTransfer(data, size) == 0)
+                {
+                    g_Game.isTransmissionRunning = true;
+                }
             }
             return;
         }
@@ -1039,6 +1837,15 @@ void test_input(void)
         if(g_Game.input.pressedB == false)
         {
             g_Game.input.pressedB = true;
+
+            if(g_Game.isTransmissionRunning)
+            {
+                SaturnMinimodem_cancelTransfer();
+                g_Game.isTransmissionRunning = false;
+                return;
+            }
+
+            test_leave();
             transitionToState(STATE_MAIN);
             return;
         }
@@ -1047,6 +1854,34 @@ void test_input(void)
     {
         g_Game.input.pressedB = false;
     }
+
+    // the settings can't change under a running test
+    if(g_Game.isTransmissionRunning)
+    {
+        return;
+    }
+
+    if(keyPressedOnce(JO_KEY_LEFT, &g_Game.input.pressedLeft))
+    {
+        testChangeOption(-1);
+    }
+
+    if(keyPressedOnce(JO_KEY_RIGHT, &g_Game.input.pressedRight))
+    {
+        testChangeOption(1);
+    }
+
+    if(keyPressedOnce(JO_KEY_L, &g_Game.input.pressedLT) && g_TestCodeDigit > 0)
+    {
+        g_TestCodeDigit--;
+    }
+
+    if(keyPressedOnce(JO_KEY_R, &g_Game.input.pressedRT) && g_TestCodeDigit + 1 < TONE_PLAN_CODE_DIGITS)
+    {
+        g_TestCodeDigit++;
+    }
+
+    moveCursor(false);
     return;
 }
 
@@ -1055,11 +1890,6 @@ void collect_draw(void)
 {
     unsigned int y = 0;
 
-    if(g_Game.state != STATE_COLLECT)
-    {
-        return;
-    }
-
     // heading
     jo_printf(HEADING_X, HEADING_Y + y++, "Save Game Collect Project");
     jo_printf(HEADING_X, HEADING_Y + y++, HEADING_UNDERSCORE);
@@ -1083,11 +1913,6 @@ void collect_draw(void)
 // Any button press returns back to title screen
 void collect_input(void)
 {
-    if(g_Game.state != STATE_COLLECT)
-    {
-        return;
-    }
-
     // did the player hit start
     if(jo_is_pad1_key_pressed(JO_KEY_START) ||
        jo_is_pad1_key_pressed(JO_KEY_A) ||
@@ -1116,11 +1941,6 @@ void credits_draw(void)
 {
     unsigned int y = 0;
 
-    if(g_Game.state != STATE_CREDITS)
-    {
-        return;
-    }
-
     // heading
     jo_printf(HEADING_X, HEADING_Y + y++, "Credits");
     jo_printf(HEADING_X, HEADING_Y + y++, HEADING_UNDERSCORE);
@@ -1159,11 +1979,6 @@ void credits_draw(void)
 // Any button press returns back to title screen
 void credits_input(void)
 {
-    if(g_Game.state != STATE_CREDITS)
-    {
-        return;
-    }
-
     // did the player hit start
     if(jo_is_pad1_key_pressed(JO_KEY_START) ||
        jo_is_pad1_key_pressed(JO_KEY_A) ||
@@ -1187,56 +2002,189 @@ void credits_input(void)
     return;
 }
 
-// copies the specified BIOS segment to the saveFileData buffer
+#if USE_BENCHMARKS
+// draws the encode benchmark screen
+// runs one benchmark per frame so the results fill in as they finish
+void benchmark_draw(void)
+{
+    unsigned int y = 0;
+    unsigned int numSteps = BENCHMARK_NUM_INPUTS * BENCHMARK_NUM_STAGES;
+
+    // heading
+    jo_printf(HEADING_X, HEADING_Y + y++, "Encode Benchmark");
+    jo_printf(HEADING_X, HEADING_Y + y++, HEADING_UNDERSCORE);
+
+    y = 0;
+
+    // cycles per byte, then KB/s
+    for(unsigned int table = 0; table < 2; table++)
+    {
+        jo_printf(HEADING_X, OPTIONS_Y + y++, "%-7s%5s%5s%5s%5s%5s%7s", table == 0 ? "cyc/B" : "KB/s",
+                  "md5", "crc", "defl", "rs", "esc", "tone");
+
+        for(unsigned int input = 0; input < BENCHMARK_NUM_INPUTS; input++)
+        {
+            PBENCHMARK_RESULT results = g_BenchmarkResults[input];
+            unsigned int values[BENCHMARK_NUM_STAGES] = {0};
+
+            if(g_BenchmarkStep < (input + 1) * BENCHMARK_NUM_STAGES)
+            {
+                jo_printf(HEADING_X, OPTIONS_Y + y++, "%-7s%32s", benchmarkInputName(input), "");
+                continue;
+            }
+
+            for(unsigned int stage = 0; stage < BENCHMARK_NUM_STAGES; stage++)
+            {
+                values[stage] = (table == 0) ? benchmarkCyclesPerByte(&results[stage]) : benchmarkKBytesPerSecond(&results[stage]);
+            }
+
+            jo_printf(HEADING_X, OPTIONS_Y + y++, "%-7s%5d%5d%5d%5d%5d%7d", benchmarkInputName(input),
+                      values[BENCHMARK_STAGE_MD5], values[BENCHMARK_STAGE_CRC32], values[BENCHMARK_STAGE_COMPRESS],
+                      values[BENCHMARK_STAGE_RS], values[BENCHMARK_STAGE_ESCAPE], values[BENCHMARK_STAGE_TONE]);
+        }
+        y++;
+    }
+
+    if(g_BenchmarkStep >= numSteps)
+    {
+        jo_printf(HEADING_X, OPTIONS_Y + y++, "Done. Press B to return          ");
+        return;
+    }
+
+    jo_printf(HEADING_X, OPTIONS_Y + y++, "Running %-6s %-7s...         ",
+              benchmarkInputName(g_BenchmarkStep / BENCHMARK_NUM_STAGES),
+              benchmarkStageName(g_BenchmarkStep % BENCHMARK_NUM_STAGES));
+
+    // blocks for the length of the benchmark, the BIOS segment is read straight from the ROM
+    benchmarkRun(g_BenchmarkStep / BENCHMARK_NUM_STAGES, g_BenchmarkStep % BENCHMARK_NUM_STAGES, 1,
+                 (unsigned char*)BIOS_START_ADDR,
+                 &g_BenchmarkResults[g_BenchmarkStep / BENCHMARK_NUM_STAGES][g_BenchmarkStep % BENCHMARK_NUM_STAGES]);
+    g_BenchmarkStep++;
+
+    return;
+}
+
+// handles input on the benchmark screen
+// B returns to the title screen
+void benchmark_input(void)
+{
+    // did the player hit b
+    if(jo_is_pad1_key_pressed(JO_KEY_B))
+    {
+        if(g_Game.input.pressedB == false)
+        {
+            g_Game.input.pressedB = true;
+            transitionToState(STATE_MAIN);
+            return;
+        }
+    }
+    else
+    {
+        g_Game.input.pressedB = false;
+    }
+    return;
+}
+#endif
+
+// points saveFileData at the specified BIOS segment
 int copyBIOS(unsigned int segment)
 {
-    if(segment > BIO_NUM_SEGMENTS)
+    if(segment >= BIO_NUM_SEGMENTS)
     {
         jo_core_error("Invalid BIOS segment specified (%d)!!", segment);
         return -1;
     }
 
-    if(g_Game.saveFileData == NULL)
+    // the BIOS is memory mapped, compress it straight from ROM
+    freeSaveFile();
+    releaseSaveArena();
+    g_Game.saveFileData = (unsigned char*)BIOS_START_ADDR + (segment * BIOS_SEGMENT_SIZE);
+    g_Game.saveFileSize = BIOS_SEGMENT_SIZE;
+    g_Game.integrity = BIOS_INTEGRITY;
+    g_Game.numCheckpoints = 0;
+    g_Game.knownImage = 0;
+
+    jo_memset(g_Game.saveFilename, 0, sizeof(g_Game.saveFilename));
+    strncpy(g_Game.saveFilename, BIOS_FILENAMES[segment], sizeof(g_Game.saveFilename) - 1);
+    return 0;
+}
+
+// points saveFileData at the next piece of the whole BIOS stream, see TRANSMISSION_HEADER.checkpoint
+// checkpoints have to be copied in order for INTEGRITY_IMAGE_MD5
+int copyBIOSCheckpoint(unsigned int checkpoint)
+{
+    if(checkpoint >= BIOS_NUM_CHECKPOINTS)
     {
-        jo_core_error("Save file data buffer is NULL!!");
-        return -2;
+        jo_core_error("Invalid BIOS checkpoint specified (%d)!!", checkpoint);
+        return -1;
     }
 
-    if(BIOS_SEGMENT_SIZE > MAX_SAVE_SIZE)
+    freeSaveFile();
+    releaseSaveArena();
+    g_Game.imageOffset = checkpoint * BIOS_CHECKPOINT_SIZE;
+    g_Game.saveFileData = (unsigned char*)BIOS_START_ADDR + g_Game.imageOffset;
+    g_Game.saveFileSize = BIOS_CHECKPOINT_SIZE;
+    g_Game.integrity = BIOS_STREAM_INTEGRITY;
+    g_Game.checkpoint = checkpoint;
+    g_Game.numCheckpoints = BIOS_NUM_CHECKPOINTS;
+    g_Game.knownImage = 0;
+
+    jo_memset(g_Game.saveFilename, 0, sizeof(g_Game.saveFilename));
+    strncpy(g_Game.saveFilename, BIOS_FILENAME, sizeof(g_Game.saveFilename) - 1);
+    return 0;
+}
+
+// the whole BIOS, streamed in checkpoints unless it is a known image
+// a known BIOS is sent as a single checkpoint with only its record
+int copyBIOSImage(void)
+{
+    int result = 0;
+
+    result = copyBIOSCheckpoint(0);
+    if(result != 0)
     {
-        jo_core_error("Save file data is too big!!");
-        return -3;
+        return result;
+    }
+
+    if(g_Game.md5BiosCalculated && g_Game.sendInFull == false)
+    {
+        g_Game.knownImage = g_Game.knownBios;
+    }
+
+    if(g_Game.knownImage != 0)
+    {
+        g_Game.saveFileSize = BIOS_SIZE;
+        g_Game.numCheckpoints = 1;
     }
 
-    memcpy(g_Game.saveFileData, (unsigned char*)BIOS_START_ADDR + (segment * BIOS_SEGMENT_SIZE), BIOS_SEGMENT_SIZE);
     return 0;
 }
 
-// copies the specified save gane to the saveFileData buffer
+// reads the specified save game to the bottom of g_Arena and points saveFileData at it
 int copySaveFile(void)
 {
     unsigned char* saveData = NULL;
+    unsigned char* arenaData = NULL;
     unsigned int saveDataSize = 0;
 
-    if(g_Game.saveFileData == NULL)
-    {
-        jo_core_error("Save file data buffer is NULL!!");
-        return -1;
-    }
+    freeSaveFile();
+    releaseSaveArena();
 
-    if(g_Game.saveFileSize == 0 || g_Game.saveFileSize > MAX_SAVE_SIZE)
+    if(g_Game.saveFileSize == 0)
     {
         jo_core_error("Save file size is invalid %d!!", g_Game.saveFileSize);
         return -2;
     }
 
     // read the file from the backup device
-    // jo engine mallocs a buffer for us
+    // jo engine mallocs a buffer for us on its HWRAM heap. The save is moved
+    // to LWRAM right away so the heap only has to hold it for the read, the
+    // encoded copy follows it in g_Arena
     saveDataSize = g_Game.saveFileSize;
     saveData = jo_backup_load_file_contents(g_Game.backupDevice, g_Game.saveFilename, &saveDataSize);
     if(saveData == NULL)
     {
-        jo_core_error("Failed to read save file!!");
+        jo_core_error("Failed to read the %d byte save, it may not fit in memory!!", g_Game.saveFileSize);
         return -3;
     }
 
@@ -1247,9 +2195,59 @@ int copySaveFile(void)
         return -4;
     }
 
-    // copy the save game data and free the jo engine buffer
-    memcpy(g_Game.saveFileData, saveData, g_Game.saveFileSize);
-    jo_free(saveData);
+    // keep jo engine's buffer when the arena can't hold the save
+    if(saveDataSize <= g_Arena.size - g_Arena.used)
+    {
+        arenaData = arenaAlloc(&g_Arena, saveDataSize);
+        memcpy(arenaData, saveData, saveDataSize);
+        jo_free(saveData);
+
+        saveData = arenaData;
+        g_Game.transferArenaMark = arenaMark(&g_Arena);
+    }
+    else
+    {
+        g_Game.saveFileDataAllocated = true;
+    }
+
+    g_Game.saveFileData = saveData;
+    g_Game.integrity = SAVE_INTEGRITY;
+    g_Game.numCheckpoints = 0;
+    g_Game.knownImage = 0;
+
+    // a stock save only needs its record sent
+    if(g_Game.sendInFull == false && knownImageHasSize(saveDataSize))
+    {
+        unsigned char md5Hash[MD5_HASH_SIZE] = {0};
+
+        if(calculateMD5Hash(saveData, saveDataSize, md5Hash) == 0)
+        {
+            g_Game.knownImage = knownImageFind(md5Hash, saveDataSize);
+        }
+    }
 
     return 0;
 }
+
+// releases the save read by copySaveFile()
+void freeSaveFile(void)
+{
+    if(g_Game.saveFileDataAllocated && g_Game.saveFileData != NULL)
+    {
+        jo_free(g_Game.saveFileData);
+    }
+
+    g_Game.saveFileData = NULL;
+    g_Game.saveFileDataAllocated = false;
+}
+
+// gives back the part of g_Arena copySaveFile() read a save to, along with
+// whatever was encoded after it
+void releaseSaveArena(void)
+{
+    arenaRelease(&g_Arena, g_Game.saveArenaMark);
+    g_Game.transferArenaMark = g_Game.saveArenaMark;
+    g_Game.encodedTransmissionData = NULL;
+    g_Game.encodedTransmissionSize = 0;
+    g_Game.resumeData = NULL;
+}
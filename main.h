@@ -41,6 +41,8 @@
 #define STATE_TEST               5
 #define STATE_COLLECT            6
 #define STATE_CREDITS            7
+#define STATE_BENCHMARK          8
+#define NUM_STATES               9
 
 // option selected on the main screen
 #define MAIN_OPTION_INTERNAL     0
@@ -48,8 +50,10 @@
 #define MAIN_OPTION_EXTERNAL     2
 #define MAIN_OPTION_BIOS         3
 #define MAIN_OPTION_TEST         4
-#define MAIN_OPTION_COLLECT      5
-#define MAIN_OPTION_CREDITS      6
+#define MAIN_OPTION_SPEED        5 // Left/Right pick a speed profile, see speed.h
+#define MAIN_OPTION_COLLECT      6
+#define MAIN_OPTION_CREDITS      7
+#define MAIN_OPTION_BENCHMARK    8 // only with USE_BENCHMARKS
 
 // position of the heading text
 #define HEADING_X                2
@@ -60,31 +64,61 @@
 
 #define CURSOR_X                 HEADING_X
 
-#define MAIN_NUM_OPTIONS         7
-#define BIOS_NUM_OPTIONS         4
+// profiler overlay, the last lines of the screen
+#define PROFILER_X               1
+#define PROFILER_Y               24
+#define PROFILER_NUM_LINES       4
+
+#if USE_BENCHMARKS
+#define MAIN_NUM_OPTIONS         9
+#else
+#define MAIN_NUM_OPTIONS         8
+#endif
+#define BIOS_NUM_OPTIONS         5 // the whole BIOS stream and its four segments
+#define TEST_NUM_OPTIONS         6
+
+// option selected on the test screen
+#define TEST_OPTION_PATTERN      0
+#define TEST_OPTION_RATE         1
+#define TEST_OPTION_FRAMING      2
+#define TEST_OPTION_SHAPING      3 // tone transitions, see MODEM_CONFIG.transitionBits
+#define TEST_OPTION_OUTPUT       4
+#define TEST_OPTION_CODE         5 // tone plan code from sgex-sweep
+
+// what the test screen sends
+#define TEST_PATTERN_MESSAGE     0 // TEST_MESSAGE
+#define TEST_PATTERN_PRBS15      1 // PRBS_TEST_SIZE bytes of PRBS_15, see prbs.h
+#define TEST_PATTERN_PRBS23      2
+#define TEST_PATTERN_SWEEP       3 // SWEEP_NUM_STEPS tones for sgex-sweep, see toneplan.h
+#define TEST_NUM_PATTERNS        4
 
 #define BIOS_FILENAME           "bios.bin"
 #define BIOS_START_ADDR         524288
 #define BIOS_SIZE               512 * 1024
 #define BIO_NUM_SEGMENTS        4 // how many segments to split the bios into
 #define BIOS_SEGMENT_SIZE       BIOS_SIZE / BIO_NUM_SEGMENTS
+#define BIOS_CHECKPOINT_SIZE    (32 * 1024) // the whole BIOS is streamed in pieces this big
+#define BIOS_NUM_CHECKPOINTS    (BIOS_SIZE / BIOS_CHECKPOINT_SIZE)
 
-// BUGBUG: adjust this as necessary
-#define MAX_SAVE_SIZE           (256 * 1024)
 #define MAX_SAVE_FILENAME       12
 #define MAX_SAVE_COMMENT        11
-#define MAX_SAVES               50
 #define MAX_SAVES_PER_PAGE      8 // saves per page to list
 
+// integrity checks sent with saves and BIOS segments, see INTEGRITY_ in encode.h
+#define SAVE_INTEGRITY          INTEGRITY_MD5 // saves get archived, keep the MD5
+#define BIOS_INTEGRITY          INTEGRITY_CRC32 // the BIOS screen already shows the whole BIOS MD5
+#define BIOS_STREAM_INTEGRITY   (INTEGRITY_CRC32 | INTEGRITY_IMAGE_MD5) // the last checkpoint has the whole BIOS MD5
+
 #define HEADING_UNDERSCORE     "___________________________________"
 
+// frames between refreshes of the transfer status while the modem is running, ~4 a second
+#define TRANSFER_UI_FRAMES     15
+
 // the test audio message
 #define TEST_MESSAGE "This\n  is\n  COOL\n"
 
 #define MD5_HASH_SIZE                   16
 
-#define ESTIMATED_TRANSFER_SPEED        70
-
 // records whether or not an input has been pressed that frame
 typedef struct _INPUTCACHE
 {
@@ -96,6 +130,9 @@ typedef struct _INPUTCACHE
     bool pressedStartAC;
     bool pressedLT;
     bool pressedRT;
+    bool pressedZ;
+    bool pressedX;
+    bool pressedY;
 } INPUTCACHE, *PINPUTCACHE;
 
 typedef struct _GAME
@@ -115,35 +152,58 @@ typedef struct _GAME
     int cursorOffset;
 
     jo_backup_device backupDevice; // JoInternalMemoryBackup, JoCartridgeMemoryBackup, JoExternalDeviceBackup
-    bool listedSaves; // set to true if we already queried the saves from the backup device
 
     char saveFilename[MAX_SAVE_FILENAME]; // selected save file name
     char saveComment[MAX_SAVE_COMMENT]; // selected save comment
     unsigned char saveLanguage; // selected save language
     unsigned int saveDate; // selected save date;
     unsigned int saveFileSize; // selected save file size
-    unsigned char* saveFileData; // the raw data, points at transmissonFileData + TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE
-    unsigned char* transmissionData; // consists of TRANSMISSION_HEADER + BUP_HEADER + variable length saveFileData
-                                     // not encoded or escaped in any form
+    unsigned char* saveFileData; // the raw data, read in place from the backup device buffer or the BIOS
+    bool saveFileDataAllocated; // saveFileData is jo_backup_load_file_contents()'s buffer, it didn't fit in g_Arena
+    unsigned char* transmissionData; // consists of TRANSMISSION_HEADER + BUP_HEADER, saveFileData follows them
+                                     // in the compressed stream. Not encoded or escaped in any form
 
     unsigned int compressedSize; // size after compression
 
+    unsigned int checkpoint; // piece of the image being sent, see TRANSMISSION_HEADER.checkpoint
+    unsigned int numCheckpoints; // 0 unless an image is being streamed
+    unsigned int imageOffset; // where saveFileData starts in the image
+    bool autoStart; // set by nextCheckpoint(), the checkpoint goes out as soon as it is encoded
+    unsigned int knownImage; // knownImageFind() index of identical data, only its record is sent. 0 sends the data
+    bool sendInFull; // send known images in full anyway, X on the play screen
+
+    unsigned int testPattern; // TEST_PATTERN_ sent by the test screen
+
+    unsigned int resumeCodeword; // Reed Solomon codeword to start sending from, 0 for all of it
+    unsigned char* resumeData; // the transmission from resumeCodeword on, see encodeResume()
+    unsigned int resumeSize;
+
     unsigned char* encodedTransmissionData; // transmission data encoded with Reed Solomon and later escaped
     unsigned int encodedTransmissionSize;  // number of bytes of encodedTransmissionata
 
-
+    unsigned int saveArenaMark; // g_Arena position the save is read to, see copySaveFile()
+    unsigned int transferArenaMark; // g_Arena position to release back to between transfers, after the save
 
     bool isTransmissionRunning;
 
     bool md5Calculated; // set to true if we have calculated the md5 MD5_HASH_SIZE
+    unsigned char integrity; // INTEGRITY_ checks to send with the save
     unsigned char md5Hash[MD5_HASH_SIZE];
+    unsigned int crc; // CRC-32 of the save, INTEGRITY_CRC32
 
 	bool md5BiosCalculated; // set to true if we have calculated the md5 MD5_HASH_SIZE
     unsigned char md5BiosHash[MD5_HASH_SIZE];
+    unsigned int knownBios; // knownImageFind() index of the BIOS, found along with md5BiosHash
 
     // hack to cache controller inputs
     INPUTCACHE input;
 
+    bool showProfiler; // Z toggles the profiler overlay
+    int peakMemoryUsage; // highest jo_memory_usage_percent() seen
+
+    bool redraw; // the screen was cleared, draw everything again
+    unsigned int frame; // frames since the program started
+
 } GAME, *PGAME;
 
 // meta data related to save files
@@ -154,8 +214,16 @@ typedef  struct  _SAVES {
     unsigned int date;
     unsigned int datasize;
     unsigned short blocksize;
+    bool infoLoaded; // comment, date and sizes have been queried, see savedir.c
 } SAVES, *PSAVES;
 
+// per frame handlers of a screen, only the current state's are called
+typedef struct _SCREEN
+{
+    void (*draw)(void);
+    void (*input)(void);
+} SCREEN, *PSCREEN;
+
 extern GAME g_Game;
 
 // common functions
@@ -164,8 +232,16 @@ void transitionToState(int newState);
 void abcStartHandler(void);
 void clearScreen(void);
 int copyBIOS(unsigned int segment);
+int copyBIOSCheckpoint(unsigned int checkpoint);
+int copyBIOSImage(void);
 int copySaveFile(void);
+void freeSaveFile(void);
+void releaseSaveArena(void);
+void loadDefaultSpeed(void);
+int saveDefaultSpeed(void);
 void moveCursor(bool savesPage);
+void screenDispatch(void);
+bool transferStatusDue(void);
 
 // main screen
 void main_draw(void);
@@ -184,6 +260,7 @@ void dumpBios_draw(void);
 void dumpBios_input(void);
 
 // test screen
+void test_enter(void);
 void test_draw(void);
 void test_input(void);
 
@@ -195,9 +272,18 @@ void collect_input(void);
 void credits_draw(void);
 void credits_input(void);
 
+// encode benchmark screen
+void benchmark_draw(void);
+void benchmark_input(void);
+
 // debug output
 void debugOutput_draw(void);
+void debugOutput_input(void);
 
+#ifndef SGEX_HOST
 // function prototypes to suppress compiler warnings
 void *memcpy(void *dest, const void *src, unsigned int n);
+void *memmove(void *dest, const void *src, unsigned int n);
+int memcmp(const void *s1, const void *s2, unsigned int n);
 char *strncpy(char *dest, const char *src, unsigned int n);
+#endif
@@ -77,32 +77,54 @@
  * link-time optimizations.  For the time being, keeping these MD5 routines in
  * their own translation unit avoids the problem.
  */
-#if defined(__i386__) || defined(__x86_64__) || defined(__vax__)
+#if (defined(__i386__) || defined(__x86_64__) || defined(__vax__)) && \
+	!defined(MD5_PORTABLE)
 #define SET(n) \
 	(*(MD5_u32plus *)&ptr[(n) * 4])
 #define GET(n) \
 	SET(n)
 #else
+/*
+ * When the data is 32-bit aligned each word is read with a single load and
+ * byte swapped on big-endian CPUs.  On the SH-2 __builtin_bswap32() is
+ * swap.b/swap.w/swap.b, much cheaper than four byte loads and three shifts.
+ * MD5_PORTABLE selects this path on x86 too so the host build runs the
+ * same code as the Saturn.
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define LOAD_LE32(p) \
+	__builtin_bswap32(*(const MD5_u32plus *)(p))
+#else
+#define LOAD_LE32(p) \
+	(*(const MD5_u32plus *)(p))
+#endif
 #define SET(n) \
-	(ctx->block[(n)] = \
+	(ctx->block[(n)] = aligned ? \
+	LOAD_LE32(&ptr[(n) * 4]) : \
 	(MD5_u32plus)ptr[(n) * 4] | \
 	((MD5_u32plus)ptr[(n) * 4 + 1] << 8) | \
 	((MD5_u32plus)ptr[(n) * 4 + 2] << 16) | \
 	((MD5_u32plus)ptr[(n) * 4 + 3] << 24))
 #define GET(n) \
 	(ctx->block[(n)])
+#define MD5_ALIGNED_BODY
 #endif
 
 /*
  * This processes one or more 64-byte data blocks, but does NOT update the bit
- * counters.  There are no alignment requirements.
+ * counters.  data must be 32-bit aligned if aligned is set, there are no
+ * alignment requirements otherwise.  Always inlined into body() and
+ * body_aligned() so the aligned checks are resolved at compile time.
  */
-static const void *body(MD5_CTX *ctx, const void *data, unsigned long size)
+static inline __attribute__((always_inline)) const void *body_common(MD5_CTX *ctx,
+	const void *data, unsigned long size, int aligned)
 {
 	const unsigned char *ptr;
 	MD5_u32plus a, b, c, d;
 	MD5_u32plus saved_a, saved_b, saved_c, saved_d;
 
+	(void)aligned;
+
 	ptr = (const unsigned char *)data;
 
 	a = ctx->a;
@@ -204,6 +226,25 @@ static const void *body(MD5_CTX *ctx, const void *data, unsigned long size)
 	return ptr;
 }
 
+static const void *body(MD5_CTX *ctx, const void *data, unsigned long size)
+{
+	return body_common(ctx, data, size, 0);
+}
+
+#ifdef MD5_ALIGNED_BODY
+static const void *body_aligned(MD5_CTX *ctx, const void *data,
+	unsigned long size)
+{
+	return body_common(ctx, data, size, 1);
+}
+
+#define ALIGNED(p) \
+	(((unsigned long)(p) & 3) == 0)
+#else
+#define body_aligned body
+#define ALIGNED(p) 1
+#endif
+
 void MD5_Init(MD5_CTX *ctx)
 {
 	ctx->a = 0x67452301;
@@ -238,11 +279,14 @@ void MD5_Update(MD5_CTX *ctx, const void *data, unsigned long size)
 		memcpy(&ctx->buffer[used], data, available);
 		data = (const unsigned char *)data + available;
 		size -= available;
-		body(ctx, ctx->buffer, 64);
+		body_aligned(ctx, ctx->buffer, 64);
 	}
 
 	if (size >= 64) {
-		data = body(ctx, data, size & ~(unsigned long)0x3f);
+		if (ALIGNED(data))
+			data = body_aligned(ctx, data, size & ~(unsigned long)0x3f);
+		else
+			data = body(ctx, data, size & ~(unsigned long)0x3f);
 		size &= 0x3f;
 	}
 
@@ -267,7 +311,7 @@ void MD5_Final(unsigned char *result, MD5_CTX *ctx)
 
 	if (available < 8) {
 		memset(&ctx->buffer[used], 0, available);
-		body(ctx, ctx->buffer, 64);
+		body_aligned(ctx, ctx->buffer, 64);
 		used = 0;
 		available = 64;
 	}
@@ -278,7 +322,7 @@ void MD5_Final(unsigned char *result, MD5_CTX *ctx)
 	OUT(&ctx->buffer[56], ctx->lo)
 	OUT(&ctx->buffer[60], ctx->hi)
 
-	body(ctx, ctx->buffer, 64);
+	body_aligned(ctx, ctx->buffer, 64);
 
 	OUT(&result[0], ctx->a)
 	OUT(&result[4], ctx->b)
@@ -42,8 +42,12 @@ extern void MD5_Init(MD5_CTX *ctx);
 extern void MD5_Update(MD5_CTX *ctx, const void *data, unsigned long size);
 extern void MD5_Final(unsigned char *result, MD5_CTX *ctx);
 
+#ifdef SGEX_HOST
+#include <string.h>
+#else
 // missing function prototypes needed by Jo Engine
 void *memcpy(void *dest, const void *src, unsigned int n);
 void *memset(void *s, int c, unsigned int n);
+#endif
 
 #endif
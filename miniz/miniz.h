@@ -117,9 +117,11 @@
 #define MINIZ_NO_STDIO 1
 //#define MINIZ_NO_MALLOC 1
 
+#ifndef SGEX_HOST
 // missing function prototypes needed by Jo Engine
 void *memcpy(void *dest, const void *src, unsigned int n);
 //void *memset(void *s, int c, unsigned int n);
+#endif
 
 
 /* Defines to completely disable specific portions of miniz.c: 
@@ -0,0 +1,56 @@
+#include <jo/jo.h>
+#include "prbs.h"
+
+int prbsInit(PPRBS prbs, unsigned int order)
+{
+    if(prbs == NULL)
+    {
+        return -1;
+    }
+
+    switch(order)
+    {
+        case PRBS_15:
+            prbs->tap = 14;
+            break;
+
+        case PRBS_23:
+            prbs->tap = 18;
+            break;
+
+        default:
+            jo_core_error("Invalid PRBS order %d!!", order);
+            return -1;
+    }
+
+    prbs->order = order;
+    prbs->state = (1u << order) - 1;
+
+    return 0;
+}
+
+// Fibonacci LFSR, the new bit is the xor of the two tapped old ones
+unsigned int prbsNextBit(PPRBS prbs)
+{
+    unsigned int bit = ((prbs->state >> (prbs->order - 1)) ^ (prbs->state >> (prbs->tap - 1))) & 1;
+
+    prbsSeedBit(prbs, bit);
+    return bit;
+}
+
+void prbsSeedBit(PPRBS prbs, unsigned int bit)
+{
+    prbs->state = ((prbs->state << 1) | (bit & 1)) & ((1u << prbs->order) - 1);
+}
+
+unsigned char prbsNextByte(PPRBS prbs)
+{
+    unsigned char byte = 0;
+
+    for(unsigned int i = 0; i < PRBS_BITS_PER_BYTE; i++)
+    {
+        byte |= prbsNextBit(prbs) << i;
+    }
+
+    return byte;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <jo/jo.h>
+
+/*
+ * Pseudo-random bit sequences for qualifying the audio link. The test screen
+ * sends one and sgex-ber synchronizes to it on the PC to count bit errors.
+ *
+ * Bits are sent 7 to a byte, least significant first, with the top bit clear
+ * so the sequence never contains SYNC_BYTE. The receiver can seed its own
+ * generator from any ORDER received bits and predict the rest.
+ */
+
+#define PRBS_15                 15 // x^15 + x^14 + 1, repeats every 32767 bits
+#define PRBS_23                 23 // x^23 + x^18 + 1, repeats every 8388607 bits
+
+#define PRBS_BITS_PER_BYTE      7
+#define PRBS_TEST_SIZE          (8 * 1024) // bytes sent by the test screen, ~2 minutes at 1200 baud 4+4
+
+typedef struct _PRBS
+{
+    unsigned int order; // PRBS_15 or PRBS_23
+    unsigned int tap;
+    unsigned int state; // the last order bits, newest in bit 0
+} PRBS, *PPRBS;
+
+// starts the sequence from all ones
+int prbsInit(PPRBS prbs, unsigned int order);
+
+// returns the next bit of the sequence
+unsigned int prbsNextBit(PPRBS prbs);
+
+// replaces the state with a received bit, after order of them the generator
+// predicts what follows them
+void prbsSeedBit(PPRBS prbs, unsigned int bit);
+
+// returns the next PRBS_BITS_PER_BYTE bits packed into a byte
+unsigned char prbsNextByte(PPRBS prbs);
@@ -0,0 +1,188 @@
+#include <jo/jo.h>
+#include "profile.h"
+#include "util.h"
+
+static unsigned int g_ProfileStageTicks[PROFILE_NUM_STAGES] = {0};
+static unsigned int g_ProfileStageStart[PROFILE_NUM_STAGES] = {0};
+
+#ifdef SGEX_HOST
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+
+// keep the TSC in 32 bits for about a minute at 3 GHz
+#define PROFILE_TSC_SHIFT   6
+#endif
+
+static unsigned int g_ProfileTicksPerSecond = 1000000;
+
+static unsigned long long profileNanoseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+// measures the TSC rate against the monotonic clock
+int profileInit(void)
+{
+#ifdef PROFILE_TSC_SHIFT
+    unsigned long long startNs = profileNanoseconds();
+    unsigned long long startTsc = __rdtsc();
+    unsigned long long elapsedNs = 0;
+
+    do
+    {
+        elapsedNs = profileNanoseconds() - startNs;
+    } while(elapsedNs < 50000000);
+
+    g_ProfileTicksPerSecond = (unsigned int)(((__rdtsc() - startTsc) >> PROFILE_TSC_SHIFT) * 1000000000ull / elapsedNs);
+#endif
+
+    return 0;
+}
+
+unsigned int profileTicks(void)
+{
+#ifdef PROFILE_TSC_SHIFT
+    return (unsigned int)(__rdtsc() >> PROFILE_TSC_SHIFT);
+#else
+    return (unsigned int)(profileNanoseconds() / 1000);
+#endif
+}
+
+unsigned int profileCyclesPerTick(void)
+{
+#ifdef PROFILE_TSC_SHIFT
+    return 1 << PROFILE_TSC_SHIFT;
+#else
+    return 0;
+#endif
+}
+
+#else
+
+// SH-2 on-chip free-running timer
+#define FRT_FRCH    (*(volatile unsigned char*)0xFFFFFE12)
+#define FRT_FRCL    (*(volatile unsigned char*)0xFFFFFE13)
+#define FRT_TCR     (*(volatile unsigned char*)0xFFFFFE16)
+
+#define FRT_TCR_CKS_MASK    0x03
+#define FRT_TCR_CKS_128     0x02
+#define FRT_DIVISOR         128
+
+static unsigned int g_ProfileHigh = 0; // upper 16 bits of the extended counter
+static unsigned short g_ProfileLast = 0; // last FRC value seen
+
+// the high byte must be read first, that latches the low byte
+static inline unsigned short readFRC(void)
+{
+    unsigned short high = FRT_FRCH;
+    return (high << 8) | FRT_FRCL;
+}
+
+// the FRT wraps every ~300ms, looking at it once a frame keeps the high bits right
+static void profileVblank(void)
+{
+    profileTicks();
+}
+
+// the clock select stays at /128 until the Saturn is reset, jo_core_run()
+// never returns. It is only put back if the profiler fails to start
+int profileInit(void)
+{
+    unsigned char tcr = FRT_TCR;
+
+    FRT_TCR = (tcr & ~FRT_TCR_CKS_MASK) | FRT_TCR_CKS_128;
+
+    g_ProfileHigh = 0;
+    g_ProfileLast = readFRC();
+
+    if(jo_core_add_vblank_callback(profileVblank) < 0)
+    {
+        FRT_TCR = tcr;
+        jo_core_error("Failed to add profiler vblank callback!!");
+        return -1;
+    }
+
+    return 0;
+}
+
+unsigned int profileTicks(void)
+{
+    // masked so the vblank callback can't extend the counter underneath us
+    unsigned int sr = disableInterrupts();
+    unsigned short frc = readFRC();
+    unsigned int ticks = 0;
+
+    if(frc < g_ProfileLast)
+    {
+        g_ProfileHigh++;
+    }
+    g_ProfileLast = frc;
+
+    ticks = (g_ProfileHigh << 16) | frc;
+
+    restoreInterrupts(sr);
+    return ticks;
+}
+
+unsigned int profileCyclesPerTick(void)
+{
+    return FRT_DIVISOR;
+}
+
+#endif
+
+unsigned int profileTicksPerSecond(void)
+{
+#ifdef SGEX_HOST
+    return g_ProfileTicksPerSecond;
+#else
+    return PROFILE_CPU_CLOCK / FRT_DIVISOR;
+#endif
+}
+
+unsigned int profileTicksToMicroseconds(unsigned int ticks)
+{
+    return (unsigned int)((unsigned long long)ticks * 1000000 / profileTicksPerSecond());
+}
+
+unsigned int profileTicksToMilliseconds(unsigned int ticks)
+{
+    return (unsigned int)((unsigned long long)ticks * 1000 / profileTicksPerSecond());
+}
+
+void profileReset(void)
+{
+    jo_memset(g_ProfileStageTicks, 0, sizeof(g_ProfileStageTicks));
+}
+
+void profileBegin(unsigned int stage)
+{
+    if(stage < PROFILE_NUM_STAGES)
+    {
+        g_ProfileStageStart[stage] = profileTicks();
+    }
+}
+
+void profileEnd(unsigned int stage)
+{
+    if(stage < PROFILE_NUM_STAGES)
+    {
+        g_ProfileStageTicks[stage] += profileTicks() - g_ProfileStageStart[stage];
+    }
+}
+
+unsigned int profileStageMilliseconds(unsigned int stage)
+{
+    if(stage >= PROFILE_NUM_STAGES)
+    {
+        return 0;
+    }
+
+    return profileTicksToMilliseconds(g_ProfileStageTicks[stage]);
+}
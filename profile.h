@@ -0,0 +1,40 @@
+#pragma once
+
+/*
+ * Cycle counting for profiling the encode pipeline and the transmitter.
+ *
+ * On the Saturn the ticks come from the SH-2 free-running timer (FRT)
+ * clocked at CPU clock / 128. A vblank callback extends the 16-bit counter
+ * to 32 bits. profileInit() switches the FRT to /128 for the rest of the
+ * run. jo_core_run() never returns, so nothing switches it back before a
+ * reset. On the host they come from the CPU's time stamp counter, or
+ * microseconds where there isn't one.
+ *
+ * Tick values wrap, always compare them by subtracting.
+ */
+
+// SH-2 clock for the 320 pixel wide NTSC mode Jo Engine uses
+#define PROFILE_CPU_CLOCK   26846587
+
+// stages timed for the profiler overlay
+#define PROFILE_STAGE_MD5           0
+#define PROFILE_STAGE_DEFLATE       1
+#define PROFILE_STAGE_RS            2
+#define PROFILE_STAGE_ESCAPE        3
+#define PROFILE_STAGE_TONE          4 // simpleaudio_tone()
+#define PROFILE_STAGE_PCM_WAIT      5 // waiting on the PCM to finish playing a block
+#define PROFILE_STAGE_CRC32         6
+#define PROFILE_NUM_STAGES          7
+
+int profileInit(void);
+unsigned int profileTicks(void);
+unsigned int profileTicksPerSecond(void);
+unsigned int profileCyclesPerTick(void); // 0 if the CPU clock isn't known
+unsigned int profileTicksToMicroseconds(unsigned int ticks);
+unsigned int profileTicksToMilliseconds(unsigned int ticks);
+
+// per stage time accumulated since the last profileReset()
+void profileReset(void);
+void profileBegin(unsigned int stage);
+void profileEnd(unsigned int stage);
+unsigned int profileStageMilliseconds(unsigned int stage);
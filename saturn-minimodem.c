@@ -1,6 +1,9 @@
 #include <jo/jo.h>
 
 #include "saturn-minimodem.h"
+#include "profile.h"
+#include "util.h"
+#include "scsp.h"
 
 #include "simpleaudio.h"
 #include "databits.h"
@@ -13,8 +16,15 @@
 #define NUM_SYNC_BYTES 2
 #define SYNC_BYTE 0xAB
 
+// the defaults above, SaturnMinimodem_setConfig() can override them
+MODEM_CONFIG g_ModemConfig = {DATA_RATE, SAMPLE_RATE, 0, 0, NUM_START_BITS, NUM_STOP_BITS, NUM_SYNC_BYTES, MODEM_OUTPUT_SAMPLES, 0};
+bool g_ToneInitialized = false;
+
 simpleaudio* tx_sa_out;
 float tx_bfsk_mark_f;
+float tx_bfsk_space_f;
+int tx_bfsk_nstartbits;
+float tx_bfsk_nstopbits;
 unsigned int tx_bit_nsamples;
 unsigned int tx_flush_nsamples;
 
@@ -23,9 +33,6 @@ int tx_print_eot = 0;
 int tx_leader_bits_len = 2;
 int tx_trailer_bits_len = 2;
 
-extern PCM g_PcmChannel;
-extern unsigned int g_AudioBufferSize;
-
 // locals moved to globals to try and make a library out of minimodem
 int g_tx_interactive = 0;
 simpleaudio *g_sa_out;
@@ -42,11 +49,61 @@ unsigned long long g_bfsk_sync_byte = -1;
 int g_txcarrier = 0;
 databits_encoder *g_bfsk_databits_encode = databits_encode_ascii8;
 
+char* g_OutputFilename = NULL;
+
 unsigned char* g_TransferBuffer = NULL;
 unsigned int g_TransferBufferSize = 0;
 unsigned int g_TransferProgress = 0;
+unsigned int g_TransferStartTicks = 0; // profileTicks() when the transfer started
 
-int g_isRunning = 0;
+// progress timestamped every time a block of audio is flushed
+// the moving average rate is computed over the last RATE_WINDOW_SECONDS of these
+typedef struct _RATE_SAMPLE
+{
+    unsigned int ticks;
+    unsigned int bytes;
+} RATE_SAMPLE, *PRATE_SAMPLE;
+
+RATE_SAMPLE g_RateSamples[RATE_NUM_SAMPLES] = {0};
+unsigned int g_NumRateSamples = 0;
+unsigned int g_NextRateSample = 0;
+bool g_PcmWaiting = false; // PCM wait is being timed
+
+// transfer engine, refills the audio in the background until the buffer is sent
+#define ENGINE_IDLE                 0
+#define ENGINE_RUNNING              1 // bytes left to send
+#define ENGINE_DRAINING             2 // every byte sent, waiting for the audio to play out
+#define ENGINE_COMPLETE             3
+#define ENGINE_ERROR                4
+
+#define TRANSFER_BLOCK_SIZE         128 // bytes between a leader and trailer
+#define TRANSFER_TICK_SAMPLES       1024 // ~23ms between refills
+#define TRANSFER_MAX_TICKS          4 // most ticks made up in one vblank, the rest wait for the next
+#define TRANSFER_INTERRUPT_LEVEL    5 // refills are masked below the sound and DMA interrupts
+
+static volatile unsigned int g_EngineState = ENGINE_IDLE;
+#ifndef SGEX_HOST
+static volatile unsigned int g_ServiceTicks = 0; // timer ticks since the engine last ran
+static int g_ServiceCallback = -1; // vblank callback running the engine
+static volatile bool g_ServiceRunning = false; // a long refill can outlast the frame
+#endif
+static unsigned int g_BlockBytes = 0; // bytes sent in the current block, 0 before its leader
+static unsigned int g_ServiceBytes = 0; // most bytes sent per tick
+
+// calibration sweep, sent instead of g_TransferBuffer when g_SweepStepSamples is set
+// g_TransferProgress and g_TransferBufferSize then count steps
+static float g_SweepStartFreq = 0;
+static float g_SweepStepFreq = 0;
+static unsigned int g_SweepStepSamples = 0;
+static unsigned int g_SweepGapSamples = 0;
+static unsigned int g_SweepPendingSamples = 0; // played since the last flush
+
+// sent ahead of the transfer at the default settings, see SaturnMinimodem_setAnnouncement()
+static unsigned char* g_AnnounceBuffer = NULL;
+static unsigned int g_AnnounceSize = 0;
+static unsigned int g_AnnounceProgress = 0;
+static unsigned char* g_NextAnnounceBuffer = NULL; // for the next SaturnMinimodem_initTransfer()
+static unsigned int g_NextAnnounceSize = 0;
 
 // Computes the sine of arg (measured in radians).
 float sinf(float x)
@@ -287,159 +344,342 @@ void tx_stop_transmit_sighandler(int sig)
     tx_transmitting = 0;
 }
 
-// modified version of fsk_transmit_stdin to transmit a buffer of up to 128 bytes
-// the buffer is passed in via a global
-static void fsk_transmit_buffer(
-	simpleaudio *sa_out,
-	int tx_interactive,
-	float data_rate,
-	float bfsk_mark_f,
-	float bfsk_space_f,
-	int n_data_bits,
-	float bfsk_nstartbits,
-	float bfsk_nstopbits,
-	int invert_start_stop,
-	int bfsk_msb_first,
-	unsigned int bfsk_do_tx_sync_bytes,
-	unsigned int bfsk_sync_byte,
-	databits_encoder encode,
-	int txcarrier,
-    bool flushBufferOnly
-	)
+// remembers how far along the transfer was at this point in time
+static void recordRateSample(void)
 {
-    UNUSED(txcarrier);
+    g_RateSamples[g_NextRateSample].ticks = profileTicks();
+    g_RateSamples[g_NextRateSample].bytes = g_TransferProgress;
 
-    size_t sample_rate = simpleaudio_get_rate(sa_out);
-    size_t bit_nsamples = sample_rate / data_rate + 0.5f;
+    g_NextRateSample = (g_NextRateSample + 1) % RATE_NUM_SAMPLES;
+    if(g_NumRateSamples < RATE_NUM_SAMPLES)
+    {
+        g_NumRateSamples++;
+    }
+}
 
-    int counter = 0;
+// starts a block with the leader tone and the sync bytes
+static void fsk_transmit_block_begin(void)
+{
+    unsigned int j;
 
-    tx_sa_out = sa_out;
-    tx_bfsk_mark_f = bfsk_mark_f;
-    tx_bit_nsamples = bit_nsamples;
-    if ( tx_interactive )
-        tx_flush_nsamples = 1;// sample_rate/2; // 0.5 sec of zero samples to flush
-    else
-        tx_flush_nsamples = 0;
+    tx_transmitting = 1;
+
+    // emit leader tone (mark)
+    for ( j=0; j<(unsigned int)tx_leader_bits_len; j++ )
+        simpleaudio_tone(g_sa_out, g_invert_start_stop ? tx_bfsk_space_f : tx_bfsk_mark_f, tx_bit_nsamples);
 
-    // arbitrary chosen timeout value: 1/25 of a second
-    unsigned int idle_carrier_usec = (1000000/25);
+    tx_transmitting = 2;
 
-    if(flushBufferOnly)
+    // emit "preamble" of sync bytes
+    for ( j=0; j<g_bfsk_do_tx_sync_bytes; j++ )
+        fsk_transmit_frame(g_sa_out, g_bfsk_sync_byte, g_bfsk_n_data_bits,
+            tx_bit_nsamples, tx_bfsk_mark_f, tx_bfsk_space_f,
+            tx_bfsk_nstartbits, tx_bfsk_nstopbits, g_invert_start_stop, 0);
+}
+
+// ends a block with the trailer tone and hands its audio to the backend
+static void fsk_transmit_block_end(void)
+{
+    tx_stop_transmit_sighandler(0);
+    simpleaudio_flush(g_sa_out);
+
+    g_BlockBytes = 0;
+
+    // the block was flushed to the audio hardware
+    recordRateSample();
+}
+
+// transmits a byte, starting or ending its block as needed
+// modified version of fsk_transmit_stdin
+static int fsk_transmit_byte(unsigned char buf)
+{
+    unsigned int nwords;
+    unsigned int bits[2];
+    unsigned int j;
+
+    // escaping keeps it out, the engine reports the error
+    if(buf == SYNC_BYTE)
     {
-        jo_core_error("in flush only code path should never get here");
-        return;
+        return -1;
     }
 
-    g_isRunning = 0;
+    if(g_BlockBytes == 0)
+    {
+        fsk_transmit_block_begin();
+    }
 
-    tx_transmitting = 0;
+    // emit data bits
+    nwords = g_bfsk_databits_encode(bits, buf);
+    for ( j=0; j<nwords; j++ )
+    {
+        fsk_transmit_frame(g_sa_out, bits[j], g_bfsk_n_data_bits,
+                tx_bit_nsamples, tx_bfsk_mark_f, tx_bfsk_space_f,
+                tx_bfsk_nstartbits, tx_bfsk_nstopbits, g_invert_start_stop, g_bfsk_msb_first);
+    }
+
+    g_BlockBytes++;
+    if(g_BlockBytes >= TRANSFER_BLOCK_SIZE)
+    {
+        fsk_transmit_block_end();
+    }
+
+    return 0;
+}
 
-    int end_of_file = 0;
-    unsigned char buf;
-    int idle = 0;
-    while ( !end_of_file )
+// the bit length, tones, framing and tone transitions the next blocks are sent with
+static void txUseLine(float dataRate, float markFreq, float spaceFreq, int numStartBits, float numStopBits, float transitionBits)
+{
+    tx_bit_nsamples = simpleaudio_get_rate(g_sa_out) / dataRate + 0.5f;
+    tx_bfsk_mark_f = markFreq;
+    tx_bfsk_space_f = spaceFreq;
+    tx_bfsk_nstartbits = numStartBits;
+    tx_bfsk_nstopbits = numStopBits;
+    simpleaudio_tone_shaping(tx_bit_nsamples * transitionBits + 0.5f);
+}
+
+// the settings SaturnMinimodem_init() was configured with
+static void txUseConfiguredLine(void)
+{
+    txUseLine(g_bfsk_data_rate, g_bfsk_mark_f, g_bfsk_space_f, g_bfsk_nstartbits, g_bfsk_nstopbits, g_ModemConfig.transitionBits);
+}
+
+// the announcement first, at the default settings in a block of its own so a
+// receiver left on them can read it, then the buffer at the configured ones
+static int transmitNextByte(void)
+{
+    int result = 0;
+
+    if(g_AnnounceProgress < g_AnnounceSize)
     {
-        if(g_isRunning == 1)
+        result = fsk_transmit_byte(g_AnnounceBuffer[g_AnnounceProgress++]);
+
+        if(g_AnnounceProgress == g_AnnounceSize)
         {
-            //jo_core_error("breaking out of loop because is running = 1");
-            end_of_file = 1;
-            continue;
+            fsk_transmit_block_end();
+            txUseConfiguredLine();
         }
 
-        counter++;
+        return result;
+    }
+
+    return fsk_transmit_byte(g_TransferBuffer[g_TransferProgress++]);
+}
+
+// plays the next step of the sweep followed by its gap of silence
+static int transmitSweepStep(void)
+{
+    float freq = g_SweepStartFreq + g_TransferProgress * g_SweepStepFreq;
 
-        if(1==1)
+    g_TransferProgress++;
+
+    simpleaudio_tone(g_sa_out, freq, g_SweepStepSamples);
+    simpleaudio_tone(g_sa_out, 0, g_SweepGapSamples);
+
+    // short flushes get padded with silence, hand over half a second at a
+    // time so the steps keep their spacing. Draining flushes the rest
+    g_SweepPendingSamples += g_SweepStepSamples + g_SweepGapSamples;
+    if(g_SweepPendingSamples >= simpleaudio_get_rate(g_sa_out) / 2)
+    {
+        simpleaudio_flush(g_sa_out);
+        g_SweepPendingSamples = 0;
+    }
+
+    recordRateSample();
+    return 0;
+}
+
+// refills the audio until the backend is above its watermark or budget
+// bytes are sent, then checks if the last of it has played
+// On the Saturn this runs from the vblank interrupt once the timer has ticked, on the host from SaturnMinimodem_transfer()
+static void transferService(unsigned int budget)
+{
+    while(g_EngineState == ENGINE_RUNNING)
+    {
+        if(simpleaudio_is_busy(g_sa_out))
         {
-            // check if the user pressed B
-            if(jo_is_pad1_key_pressed(JO_KEY_B))
+            if(g_PcmWaiting == false)
             {
-                end_of_file = 1;
-                continue; //Do nothing else
+                profileBegin(PROFILE_STAGE_PCM_WAIT);
+                g_PcmWaiting = true;
             }
+            break;
+        }
 
-             // check if the transfer is complete
-            if(g_TransferProgress >= g_TransferBufferSize)
-            {
-               end_of_file = 1;
-               continue; //Do nothing else
-            }
-            else
+        if(g_PcmWaiting == true)
+        {
+            profileEnd(PROFILE_STAGE_PCM_WAIT);
+            g_PcmWaiting = false;
+        }
+
+        // check if the transfer is complete
+        if(g_TransferProgress >= g_TransferBufferSize && g_AnnounceProgress >= g_AnnounceSize)
+        {
+            if(g_BlockBytes != 0)
             {
-                // grab the next byte for transfer
-                buf = g_TransferBuffer[g_TransferProgress];
-                g_TransferProgress++;
-
-                if(buf == SYNC_BYTE)
-                {
-                    jo_core_error("uh oh found sync byte in our transmission");
-                    return;
-                }
+                fsk_transmit_block_end();
             }
+            g_EngineState = ENGINE_DRAINING;
+            break;
+        }
 
-            idle = 0;
+        if(budget == 0)
+        {
+            break;
         }
-        else
-            idle = 1;
+        budget--;
 
-        if( !idle )
+        if((g_SweepStepSamples ? transmitSweepStep() : transmitNextByte()) != 0)
         {
-            // fprintf(stderr, "<c=%d>", c);
-            unsigned int nwords;
-            unsigned int bits[2];
-            unsigned int j;
-            nwords = encode(bits, buf);
+            g_EngineState = ENGINE_ERROR;
+        }
+    }
 
-            if ( !tx_transmitting )
-            {
-                tx_transmitting = 1;
-                    // emit leader tone (mark)
-                    for ( j=0; j<(unsigned int)tx_leader_bits_len; j++ )
-                        simpleaudio_tone(sa_out, invert_start_stop ? bfsk_space_f : bfsk_mark_f, bit_nsamples);
-            }
-            if ( tx_transmitting < 2)
-            {
-                tx_transmitting = 2;
-                // emit "preamble" of sync bytes
-                for ( j=0; j<(unsigned int)bfsk_do_tx_sync_bytes; j++ )
-                    fsk_transmit_frame(sa_out, bfsk_sync_byte, n_data_bits,
-                        bit_nsamples, bfsk_mark_f, bfsk_space_f,
-                        bfsk_nstartbits, bfsk_nstopbits, invert_start_stop, 0);
-            }
+    if(g_EngineState == ENGINE_DRAINING)
+    {
+        if(simpleaudio_is_flushed(g_sa_out))
+        {
+            // sent all bytes and audio is flushed
+            g_TransferProgress = 0;
+            g_EngineState = ENGINE_COMPLETE;
+        }
+        else
+        {
+            // bytes sent but the last blocks are still being played
+            simpleaudio_flush(g_sa_out);
+        }
+    }
+}
 
-            // emit data bits
-            for ( j=0; j<nwords; j++ )
-            {
-                fsk_transmit_frame(sa_out, bits[j], n_data_bits,
-                        bit_nsamples, bfsk_mark_f, bfsk_space_f,
-                        bfsk_nstartbits, bfsk_nstopbits, invert_start_stop, bfsk_msb_first);
-            }
+#ifndef SGEX_HOST
+// SCSP timer B keeps counting samples whatever the video mode is. Synthesis
+// is too slow for the sound interrupt, so this only counts the ticks for the vblank
+static void transferTimerInterrupt(void)
+{
+    SCSP_TIMER_B = scspTimerValue(TRANSFER_TICK_SAMPLES);
+
+    if(g_EngineState == ENGINE_RUNNING || g_EngineState == ENGINE_DRAINING)
+    {
+        g_ServiceTicks++;
+    }
+}
+
+// runs at every vblank, however long the main loop takes over its frame,
+// with a budget for every tick since the last one. The backend's watermark
+// and TRANSFER_MAX_TICKS bound the time spent in the interrupt
+static void transferPoll(void)
+{
+    unsigned int sr = 0;
+    unsigned int ticks = 0;
+
+    if(g_ServiceRunning)
+    {
+        return;
+    }
+
+    sr = disableInterrupts();
+    ticks = g_ServiceTicks < TRANSFER_MAX_TICKS ? g_ServiceTicks : TRANSFER_MAX_TICKS;
+    g_ServiceTicks -= ticks;
+    restoreInterrupts(sr);
+
+    if(ticks == 0)
+    {
+        return;
+    }
+
+    // synthesis takes a while, let the pitch timer, sound DMA and the next vblank in
+    g_ServiceRunning = true;
+    sr = setInterruptLevel(TRANSFER_INTERRUPT_LEVEL);
+    transferService(g_ServiceBytes * ticks);
+    restoreInterrupts(sr);
+    g_ServiceRunning = false;
+}
+#endif
 
-            if(counter > 127)
+// starts or stops calling transferService() in the background
+static int transferEngineTimer(bool enable)
+{
+#ifndef SGEX_HOST
+    if(enable)
+    {
+        g_ServiceTicks = 0;
+        SCSP_TIMER_B = scspTimerValue(TRANSFER_TICK_SAMPLES);
+
+        if(g_ServiceCallback < 0)
+        {
+            g_ServiceCallback = jo_core_add_vblank_callback(transferPoll);
+            if(g_ServiceCallback < 0)
             {
-                end_of_file = 1;
+                return -1;
             }
         }
-        else
-        {
-            tx_transmitting = 1;
-            // emit idle tone (mark)
-            simpleaudio_tone(sa_out,
-                invert_start_stop ? bfsk_space_f : bfsk_mark_f,
-                idle_carrier_usec * sample_rate / 1000000);
-        }
+    }
+    else if(g_ServiceCallback >= 0)
+    {
+        // masked so the main loop never stops the engine halfway through a vblank
+        unsigned int sr = disableInterrupts();
 
+        jo_core_remove_vblank_callback(g_ServiceCallback);
+        g_ServiceCallback = -1;
+        restoreInterrupts(sr);
     }
 
-    tx_stop_transmit_sighandler(0);
-    sa_saturn_flush_buffer();
+    return scspSetInterruptHandler(SCSP_INT_TIMER_B, enable ? transferTimerInterrupt : NULL);
+#else
+    UNUSED(enable);
+
+    return 0;
+#endif
+}
+
+// resets the progress and starts the transfer engine on size bytes or sweep steps
+static int startTransfer(unsigned int size)
+{
+    float bytesPerSecond = 0;
+
+    g_TransferBufferSize = size;
+    g_TransferProgress = 0;
+    g_TransferStartTicks = profileTicks();
+    g_PcmWaiting = false;
 
+    g_NumRateSamples = 0;
+    g_NextRateSample = 0;
+    recordRateSample();
+
+    tx_sa_out = g_sa_out;
+    if(g_AnnounceSize != 0)
+    {
+        // the tones SaturnMinimodem_init() picks for the default rate
+        txUseLine(DATA_RATE, DATA_RATE / 2 + 600, DATA_RATE / 2 + 600 + DATA_RATE * 5 / 6, NUM_START_BITS, NUM_STOP_BITS, 0);
+    }
+    else
+    {
+        txUseConfiguredLine();
+    }
+    if ( g_tx_interactive )
+        tx_flush_nsamples = 1;// sample_rate/2; // 0.5 sec of zero samples to flush
+    else
+        tx_flush_nsamples = 0;
     tx_transmitting = 0;
 
-    if ( !tx_transmitting )
-        return;
+    // a few ticks worth of bytes at the on-air rate, so a tick can catch up after a slow one
+    // a sweep step is longer than a tick
+    bytesPerSecond = g_bfsk_data_rate / (g_bfsk_nstartbits + g_bfsk_n_data_bits + g_bfsk_nstopbits);
+    g_ServiceBytes = g_SweepStepSamples ? 1 : (unsigned int)(bytesPerSecond * TRANSFER_TICK_SAMPLES / SCSP_FREQUENCY) * 4 + 1;
+
+    g_BlockBytes = 0;
+    g_EngineState = ENGINE_RUNNING;
+
+    if(transferEngineTimer(true) != 0)
+    {
+        g_EngineState = ENGINE_IDLE;
+        return -1;
+    }
+
+    return 0;
 }
 
+// starts sending data in the background, refilled whenever the audio backend
+// has room. Any transfer already running is cancelled
 int SaturnMinimodem_initTransfer(unsigned char* data, unsigned int size)
 {
     if(data == NULL)
@@ -452,13 +692,101 @@ int SaturnMinimodem_initTransfer(unsigned char* data, unsigned int size)
         return -1;
     }
 
+    if(g_sa_out == NULL)
+    {
+        jo_core_error("Call init first!!\n");
+        return -1;
+    }
+
+    SaturnMinimodem_cancelTransfer();
+
     g_TransferBuffer = data;
-    g_TransferBufferSize = size;
-    g_TransferProgress = 0;
+    g_SweepStepSamples = 0;
+
+    // only this transfer is announced
+    g_AnnounceBuffer = g_NextAnnounceBuffer;
+    g_AnnounceSize = g_NextAnnounceSize;
+    g_AnnounceProgress = 0;
+    g_NextAnnounceBuffer = NULL;
+    g_NextAnnounceSize = 0;
 
+    return startTransfer(size);
+}
+
+// sends size bytes of data ahead of the next SaturnMinimodem_initTransfer(),
+// at the default settings whatever the modem is configured with. A receiver
+// left on the defaults can read what the transfer is sent with from it.
+// data must stay valid until that transfer is done, NULL sends nothing
+int SaturnMinimodem_setAnnouncement(unsigned char* data, unsigned int size)
+{
+    if(data == NULL && size != 0)
+    {
+        return -1;
+    }
+
+    g_NextAnnounceBuffer = data;
+    g_NextAnnounceSize = size;
     return 0;
 }
 
+// plays numSteps tones in the background, each stepMs long and followed by
+// gapMs of silence, rising from startFreq by stepFreq. Runs like a transfer
+// of numSteps bytes. Any transfer already running is cancelled
+int SaturnMinimodem_initSweep(float startFreq, float stepFreq, unsigned int numSteps, unsigned int stepMs, unsigned int gapMs)
+{
+    if(startFreq <= 0 || numSteps == 0 || stepMs == 0)
+    {
+        return -1;
+    }
+
+    if(g_sa_out == NULL)
+    {
+        jo_core_error("Call init first!!\n");
+        return -1;
+    }
+
+    SaturnMinimodem_cancelTransfer();
+
+    g_TransferBuffer = NULL;
+    g_AnnounceSize = 0;
+    g_AnnounceProgress = 0;
+    g_SweepStartFreq = startFreq;
+    g_SweepStepFreq = stepFreq;
+    g_SweepStepSamples = simpleaudio_get_rate(g_sa_out) * stepMs / 1000;
+    g_SweepGapSamples = simpleaudio_get_rate(g_sa_out) * gapMs / 1000;
+    g_SweepPendingSamples = 0;
+
+    return startTransfer(numSteps);
+}
+
+// stops the background transfer and drops the audio already queued so it
+// goes quiet straight away. The .wav backend keeps what was written, ending
+// the block being sent so the receiver sees its trailer
+void SaturnMinimodem_cancelTransfer(void)
+{
+    if(g_EngineState == ENGINE_IDLE)
+    {
+        return;
+    }
+
+    // the engine only runs from the vblank callback, this stops it coming back
+    transferEngineTimer(false);
+
+    if(g_EngineState == ENGINE_RUNNING && g_BlockBytes != 0)
+    {
+        fsk_transmit_block_end();
+    }
+    simpleaudio_stop(g_sa_out);
+
+    if(g_PcmWaiting == true)
+    {
+        profileEnd(PROFILE_STAGE_PCM_WAIT);
+        g_PcmWaiting = false;
+    }
+
+    g_EngineState = ENGINE_IDLE;
+}
+
 int SaturnMinimodem_transferStatus(unsigned int* bytesTransferred, unsigned int* totalBytes)
 {
     if(bytesTransferred == NULL || totalBytes == NULL)
@@ -466,7 +794,7 @@ int SaturnMinimodem_transferStatus(unsigned int* bytesTransferred, unsigned int*
         return -1;
     }
 
-    if(g_TransferBuffer == NULL || g_TransferBufferSize == 0)
+    if(g_TransferBufferSize == 0)
     {
         return -1;
     }
@@ -477,61 +805,192 @@ int SaturnMinimodem_transferStatus(unsigned int* bytesTransferred, unsigned int*
     return 0;
 }
 
-// wrapper function to transfer up to 128 more bytes of the buffer
-// SaturnMinimode_initTransfer() must be called first
-int SaturnMinimodem_transfer(void)
+// average data rate since SaturnMinimodem_initTransfer() in bits per second
+int SaturnMinimodem_transferRate(unsigned int* bitsPerSecond)
 {
-    bool flushBufferOnly = false;
+    unsigned int elapsedMs = 0;
 
-    if(g_TransferBuffer == NULL || g_TransferBufferSize == 0)
+    if(bitsPerSecond == NULL)
+    {
+        return -1;
+    }
+
+    if(g_TransferBufferSize == 0)
+    {
+        return -1;
+    }
+
+    elapsedMs = profileTicksToMilliseconds(profileTicks() - g_TransferStartTicks);
+    if(elapsedMs == 0)
+    {
+        *bitsPerSecond = 0;
+        return 0;
+    }
+
+    *bitsPerSecond = (unsigned int)((unsigned long long)g_TransferProgress * 8 * 1000 / elapsedMs);
+    return 0;
+}
+
+// reports where the transfer started by SaturnMinimodem_initTransfer() is
+// On the Saturn the refilling happens at each vblank as the timer ticks, on the host
+// each call refills up to a tick's worth of audio
+int SaturnMinimodem_transfer(void)
+{
+    if(g_TransferBufferSize == 0)
     {
         jo_core_error("Call initTransfer first!!\n");
         return TRANSFER_ERROR;
     }
 
-    if (slPCMStat(&g_PcmChannel))
+#ifdef SGEX_HOST
+    transferService(g_ServiceBytes);
+#endif
+
+    switch(g_EngineState)
+    {
+        case ENGINE_RUNNING:
+            // waiting on the audio backend to drop below its watermark
+            return g_PcmWaiting ? TRANSFER_BUSY : TRANSFER_PROGRESS;
+
+        case ENGINE_DRAINING:
+            // bytes sent but the last blocks are still being played
+            return TRANSFER_BUSY;
+
+        case ENGINE_COMPLETE:
+            transferEngineTimer(false);
+            return TRANSFER_COMPLETE;
+
+        case ENGINE_ERROR:
+            transferEngineTimer(false);
+            return TRANSFER_ERROR;
+    }
+
+    // cancelled
+    return TRANSFER_ERROR;
+}
+
+// moving average of the transfer rate over the last RATE_WINDOW_SECONDS and
+// the seconds left at that rate. Includes the gaps between flushed blocks
+// Until two blocks have been flushed the rate is computed from the modem settings
+int SaturnMinimodem_transferEstimate(unsigned int* bytesPerSecond, unsigned int* secondsLeft)
+{
+    unsigned int rate = 0;
+
+    if(bytesPerSecond == NULL || secondsLeft == NULL)
     {
-        return TRANSFER_BUSY;
+        return -1;
     }
 
-    // check if the transfer is complete
-    if(g_TransferProgress >= g_TransferBufferSize)
+    if(g_TransferBufferSize == 0)
     {
-        if(sa_saturn_is_buffer_flushed() == true)
+        return -1;
+    }
+
+    if(g_NumRateSamples >= 2)
+    {
+        unsigned int window = RATE_WINDOW_SECONDS * profileTicksPerSecond();
+        PRATE_SAMPLE newest = &g_RateSamples[(g_NextRateSample + RATE_NUM_SAMPLES - 1) % RATE_NUM_SAMPLES];
+        PRATE_SAMPLE oldest = NULL;
+
+        // oldest sample still inside the window, always at least the one before newest
+        for(unsigned int i = 2; i <= g_NumRateSamples; i++)
         {
-            // sent all bytes and audio is flushed
-            g_TransferProgress = 0;
-            return TRANSFER_COMPLETE;
+            PRATE_SAMPLE sample = &g_RateSamples[(g_NextRateSample + RATE_NUM_SAMPLES - i) % RATE_NUM_SAMPLES];
+
+            if(oldest != NULL && newest->ticks - sample->ticks > window)
+            {
+                break;
+            }
+            oldest = sample;
         }
 
-        // bytes sent but audio is not flushed
-        // try to flush the audio
-        flushBufferOnly = true;
+        if(newest->ticks != oldest->ticks && newest->bytes > oldest->bytes)
+        {
+            rate = (unsigned int)((unsigned long long)(newest->bytes - oldest->bytes) * profileTicksPerSecond() /
+                                  (newest->ticks - oldest->ticks));
+        }
     }
-    else
+
+    // nothing measured yet, use the on-air rate
+    if(rate == 0)
     {
-        // transfer is not complete, call fsk_transmit_buffer()
-        flushBufferOnly = false;
+        rate = g_bfsk_data_rate / (g_bfsk_nstartbits + g_bfsk_n_data_bits + g_bfsk_nstopbits);
     }
 
-    fsk_transmit_buffer(g_sa_out,
-                    g_tx_interactive,
-                    g_bfsk_data_rate,
-                    g_bfsk_mark_f,
-                    g_bfsk_space_f,
-                    g_bfsk_n_data_bits,
-                    g_bfsk_nstartbits,
-                    g_bfsk_nstopbits,
-                    g_invert_start_stop,
-                    g_bfsk_msb_first,
-                    g_bfsk_do_tx_sync_bytes,
-                    g_bfsk_sync_byte,
-                    g_bfsk_databits_encode,
-                    g_txcarrier,
-                    flushBufferOnly);
+    if(rate == 0)
+    {
+        return -1;
+    }
+
+    *bytesPerSecond = rate;
+    *secondsLeft = (g_TransferBufferSize - g_TransferProgress + rate - 1) / rate;
+    return 0;
+}
 
-    // we called fsk_transmit_buffer but we are not necessarily complete
-    return TRANSFER_PROGRESS;
+// redirects the audio to a .wav file, must be called before SaturnMinimodem_init()
+int SaturnMinimodem_setOutputFile(char* filename)
+{
+    if(g_sa_out != NULL)
+    {
+        jo_core_error("Call setOutputFile before init!!\n");
+        return -1;
+    }
+
+    g_OutputFilename = filename;
+    return 0;
+}
+
+// overrides the modem settings, must be called before SaturnMinimodem_init()
+// mark and space frequencies of 0 are picked from the data rate like minimodem does
+int SaturnMinimodem_setConfig(PMODEM_CONFIG config)
+{
+    if(config == NULL || config->dataRate <= 0 || config->sampleRate == 0 || config->output > MODEM_OUTPUT_PITCH ||
+       config->transitionBits < 0 || config->transitionBits > 1)
+    {
+        return -1;
+    }
+
+    if(g_sa_out != NULL)
+    {
+        jo_core_error("Call setConfig before init!!\n");
+        return -1;
+    }
+
+    g_ModemConfig = *config;
+    return 0;
+}
+
+// returns the modem settings in use, including the computed mark and space frequencies
+int SaturnMinimodem_getConfig(PMODEM_CONFIG config)
+{
+    if(config == NULL)
+    {
+        return -1;
+    }
+
+    *config = g_ModemConfig;
+
+    if(g_sa_out != NULL)
+    {
+        config->markFreq = g_bfsk_mark_f;
+        config->spaceFreq = g_bfsk_space_f;
+    }
+
+    return 0;
+}
+
+// closes the audio stream. For the .wav backend this finalizes the file
+void SaturnMinimodem_close(void)
+{
+    if(g_sa_out == NULL)
+    {
+        return;
+    }
+
+    SaturnMinimodem_cancelTransfer();
+
+    simpleaudio_close(g_sa_out);
+    g_sa_out = NULL;
 }
 
 // initializes the state for calling the minimodem functions
@@ -541,7 +1000,7 @@ int SaturnMinimodem_init(void)
     float band_width = 0;
     unsigned int bfsk_inverted_freqs = 0;
     int autodetect_shift;
-    char *filename = NULL;
+    char *filename = g_OutputFilename;
 
     // fsk_confidence_threshold : signal-to-noise squelch control
     //
@@ -557,10 +1016,23 @@ int SaturnMinimodem_init(void)
     // or skewed rates).
     float fsk_confidence_search_limit = 2.3f;
 
+#ifdef SGEX_HOST
+    sa_backend_t sa_backend = SA_BACKEND_FILE;
+#else
     sa_backend_t sa_backend = SA_BACKEND_SEGASATURN;
+
+    if(g_ModemConfig.output == MODEM_OUTPUT_68K)
+    {
+        sa_backend = SA_BACKEND_SEGASATURN_68K;
+    }
+    else if(g_ModemConfig.output == MODEM_OUTPUT_PITCH)
+    {
+        sa_backend = SA_BACKEND_SEGASATURN_PITCH;
+    }
+#endif
     char *sa_backend_device = NULL;
     sa_format_t sample_format = SA_SAMPLE_FORMAT_S16;
-    unsigned int sample_rate = SAMPLE_RATE;
+    unsigned int sample_rate = g_ModemConfig.sampleRate;
     unsigned int nchannels = 1; // FIXME: only works with one channel
 
     float tx_amplitude = 1.0;
@@ -588,6 +1060,19 @@ int SaturnMinimodem_init(void)
 
     TX_mode = 1;
 
+    if(g_sa_out != NULL)
+    {
+        jo_core_error("Minimodem is already initialized!!\n");
+        return -1;
+    }
+
+    // start from a clean slate so init can run again after close with a new config
+    g_bfsk_mark_f = g_ModemConfig.markFreq;
+    g_bfsk_space_f = g_ModemConfig.spaceFreq;
+    g_bfsk_nstartbits = -1;
+    g_bfsk_nstopbits = -1;
+    tx_leader_bits_len = 2;
+
     if ( TX_mode == -1 )
         TX_mode = 0;
 
@@ -595,7 +1080,7 @@ int SaturnMinimodem_init(void)
     if ( TX_mode == 0 )
         sample_format = SA_SAMPLE_FORMAT_FLOAT;
 
-    g_bfsk_data_rate = DATA_RATE;
+    g_bfsk_data_rate = g_ModemConfig.dataRate;
     g_bfsk_n_data_bits = 8;
 
     //if ( bfsk_data_rate == 0.0f )
@@ -666,14 +1151,21 @@ int SaturnMinimodem_init(void)
     char *stream_name = NULL;
 
     if ( filename ) {
+        // the stream is still treated as interactive so the audio written
+        // to the file is identical to what the Saturn plays
         sa_backend = SA_BACKEND_FILE;
-        stream_name = filename;
+        sa_backend_device = filename;
     }
 
     // transmit
     if ( TX_mode ) {
 
-        simpleaudio_tone_init(tx_sin_table_len, tx_amplitude);
+        if(g_ToneInitialized == false)
+        {
+            simpleaudio_tone_init(tx_sin_table_len, tx_amplitude);
+            g_ToneInitialized = true;
+        }
+        simpleaudio_tone_reset();
 
         g_tx_interactive = 0;
         if ( ! stream_name ) {
@@ -685,17 +1177,30 @@ int SaturnMinimodem_init(void)
                         SA_STREAM_PLAYBACK,
                         sample_format, sample_rate, nchannels,
                         "test", stream_name);
+        if ( !g_sa_out && sa_backend != SA_BACKEND_SEGASATURN && sa_backend != SA_BACKEND_FILE )
+        {
+            // the 68000 driver isn't on the disc or there's no sound RAM for the sine,
+            // synthesize the samples instead
+            g_sa_out = simpleaudio_open_stream(SA_BACKEND_SEGASATURN, sa_backend_device,
+                            SA_STREAM_PLAYBACK,
+                            sample_format, sample_rate, nchannels,
+                            "test", stream_name);
+            if ( g_sa_out )
+            {
+                g_ModemConfig.output = MODEM_OUTPUT_SAMPLES;
+            }
+        }
         if ( !g_sa_out )
         {
             jo_core_error("sa_out is null");
             return 1;
         }
 
-        g_bfsk_nstartbits = NUM_START_BITS;
-        g_bfsk_nstopbits = NUM_STOP_BITS;
+        g_bfsk_nstartbits = g_ModemConfig.numStartBits;
+        g_bfsk_nstopbits = g_ModemConfig.numStopBits;
 
 
-        g_bfsk_do_tx_sync_bytes = NUM_SYNC_BYTES;
+        g_bfsk_do_tx_sync_bytes = g_ModemConfig.numSyncBytes;
         g_bfsk_sync_byte = SYNC_BYTE;
 
         return 0;
@@ -10,19 +10,53 @@
 #define TRANSFER_COMPLETE 2
 #define TRANSFER_BUSY     3
 
+// moving average window for SaturnMinimodem_transferEstimate()
+#define RATE_WINDOW_SECONDS 20
+#define RATE_NUM_SAMPLES    32 // flushed blocks remembered, more than fit in the window at 1200 baud
+
+// how the tones reach the SCSP on the Saturn, the host always writes samples
+#define MODEM_OUTPUT_SAMPLES        0 // synthesized on the SH-2 and streamed to sound RAM
+#define MODEM_OUTPUT_68K            1 // queued to the 68000 sound driver, falls back to samples without it
+#define MODEM_OUTPUT_PITCH          2 // one SCSP slot's pitch switched from a timer interrupt on the SH-2
+
+// modem settings that can be changed at runtime
+typedef struct _MODEM_CONFIG
+{
+    float dataRate; // bits per second. This is the -r parameter in minimodem
+    unsigned int sampleRate; // This is the -R parameter in minimodem
+    float markFreq; // 0 to compute from the data rate
+    float spaceFreq; // 0 to compute from the data rate
+    unsigned int numStartBits;
+    unsigned int numStopBits;
+    unsigned int numSyncBytes;
+    unsigned int output; // MODEM_OUTPUT_
+    float transitionBits; // 0 switches tones at once like minimodem, up to 1 sweeps them over that much of a bit
+} MODEM_CONFIG, *PMODEM_CONFIG;
+
 // Saturn minimodem API
 int SaturnMinimodem_init(void);
 int SaturnMinimodem_initTransfer(unsigned char* data, unsigned int size);
+int SaturnMinimodem_setAnnouncement(unsigned char* data, unsigned int size);
+int SaturnMinimodem_initSweep(float startFreq, float stepFreq, unsigned int numSteps, unsigned int stepMs, unsigned int gapMs);
 int SaturnMinimodem_transfer(void);
+void SaturnMinimodem_cancelTransfer(void);
 int SaturnMinimodem_transferStatus(unsigned int* bytesTransmitted, unsigned int* bytesTotal);
+int SaturnMinimodem_transferRate(unsigned int* bitsPerSecond);
+int SaturnMinimodem_transferEstimate(unsigned int* bytesPerSecond, unsigned int* secondsLeft);
 
-// BUGBUG: move this prototype somewhere else;
-bool sa_saturn_is_buffer_flushed(void);
+// when set before SaturnMinimodem_init() the audio is written to a .wav file
+// instead of the sound hardware. Only the host build has a .wav backend
+int SaturnMinimodem_setOutputFile(char* filename);
+int SaturnMinimodem_setConfig(PMODEM_CONFIG config);
+int SaturnMinimodem_getConfig(PMODEM_CONFIG config);
+void SaturnMinimodem_close(void);
 
+#ifndef SGEX_HOST
 // missing function prototypes
 void bzero(void *s, unsigned int n); // bugbug get rid of this
 void *memcpy(void *dest, const void *src, unsigned int n);
 int strlen(const char *s);
+#endif
 
 // reimplemented floating point functions
 float sinf(float x);
@@ -30,6 +64,3 @@ long int lroundf(float x);
 float fmodf(float x, float y);
 
 void* my_realloc(void* buffer, unsigned int oldSize, unsigned int newSize);
-
-// bugbug put this prototype somewhere else
-bool sa_saturn_flush_buffer();
@@ -0,0 +1,258 @@
+#include <jo/jo.h>
+#include "main.h"
+#include "util.h"
+#include "savedir.h"
+
+#define SAVE_DIRECTORY_MIN_CAPACITY 32
+
+static SAVE_DIRECTORY g_SaveDirectories[SAVE_NUM_DEVICES] = {0};
+
+static const char* SAVE_SORT_NAMES[SAVE_NUM_SORTS] = {"Name", "Size", "Date"};
+
+static PSAVE_DIRECTORY getDirectory(jo_backup_device device)
+{
+    if((unsigned int)device >= SAVE_NUM_DEVICES)
+    {
+        jo_core_error("Invalid backup device specified!! %d\n", device);
+        return NULL;
+    }
+
+    return &g_SaveDirectories[device];
+}
+
+// doubles the capacity until count more saves fit
+static int growDirectory(PSAVE_DIRECTORY directory, unsigned int count)
+{
+    unsigned int capacity = directory->capacity ? directory->capacity : SAVE_DIRECTORY_MIN_CAPACITY;
+    PSAVES saves = NULL;
+
+    while(capacity < count)
+    {
+        capacity *= 2;
+    }
+
+    if(capacity == directory->capacity)
+    {
+        return 0;
+    }
+
+    saves = jo_malloc(capacity * sizeof(SAVES));
+    if(saves == NULL)
+    {
+        jo_core_error("Failed to allocate the save directory!!");
+        return -1;
+    }
+
+    if(directory->saves != NULL)
+    {
+        memcpy(saves, directory->saves, directory->count * sizeof(SAVES));
+        jo_free(directory->saves);
+    }
+
+    directory->saves = saves;
+    directory->capacity = capacity;
+    return 0;
+}
+
+// queries the comment, date and size of a save once
+static int loadInfo(jo_backup_device device, PSAVES save)
+{
+    char comment[MAX_SAVE_COMMENT] = {0};
+    unsigned char language = 0;
+    unsigned int date = 0;
+    unsigned int numBytes = 0;
+    unsigned int numBlocks = 0;
+    bool result = false;
+
+    if(save->infoLoaded)
+    {
+        return 0;
+    }
+
+    result = jo_backup_get_file_info(device, save->filename, comment, &language, &date, &numBytes, &numBlocks);
+    if(result == false)
+    {
+        jo_core_error("Failed to read file size!!");
+        return -1;
+    }
+
+    strncpy((char*)save->comment, comment, MAX_SAVE_COMMENT);
+    save->language = language;
+    save->date = date;
+    save->datasize = numBytes;
+    save->blocksize = numBlocks;
+    save->infoLoaded = true;
+
+    return 0;
+}
+
+// returns true if a belongs after b
+static bool sortsAfter(PSAVES a, PSAVES b, unsigned int sort)
+{
+    switch(sort)
+    {
+        case SAVE_SORT_SIZE:
+            if(a->datasize != b->datasize)
+            {
+                return a->datasize < b->datasize;
+            }
+            break;
+
+        case SAVE_SORT_DATE:
+            if(a->date != b->date)
+            {
+                return a->date < b->date;
+            }
+            break;
+    }
+
+    return strncmp(a->filename, b->filename, MAX_SAVE_FILENAME) > 0;
+}
+
+// insertion sort, directories are a few hundred saves at most and often already sorted
+static void sortDirectory(PSAVE_DIRECTORY directory)
+{
+    for(unsigned int i = 1; i < directory->count; i++)
+    {
+        SAVES save = directory->saves[i];
+        unsigned int j = i;
+
+        while(j > 0 && sortsAfter(&directory->saves[j - 1], &save, directory->sort))
+        {
+            directory->saves[j] = directory->saves[j - 1];
+            j--;
+        }
+        directory->saves[j] = save;
+    }
+}
+
+int saveDirectoryRead(jo_backup_device device)
+{
+    PSAVE_DIRECTORY directory = getDirectory(device);
+    jo_list saveFilenames = {0};
+    bool result = false;
+
+    if(directory == NULL)
+    {
+        return -1;
+    }
+
+    if(directory->listed)
+    {
+        return directory->count;
+    }
+
+    result = jo_backup_mount(device);
+    if(result == false)
+    {
+        return -1;
+    }
+
+    jo_list_init(&saveFilenames);
+
+    result = jo_backup_read_device(device, &saveFilenames);
+    if(result == false || growDirectory(directory, saveFilenames.count) != 0)
+    {
+        jo_list_free_and_clear(&saveFilenames);
+        return -1;
+    }
+
+    directory->count = 0;
+    for(unsigned int i = 0; i < (unsigned int)saveFilenames.count; i++)
+    {
+        PSAVES save = &directory->saves[directory->count];
+        char* filename = jo_list_at(&saveFilenames, i)->data.ch_arr;
+
+        if(filename == NULL)
+        {
+            jo_core_error("Save directory list is corrupt!!");
+            jo_list_free_and_clear(&saveFilenames);
+            return -1;
+        }
+
+        jo_memset(save, 0, sizeof(SAVES));
+        strncpy((char*)save->filename, filename, MAX_SAVE_FILENAME);
+        directory->count++;
+    }
+
+    jo_list_free_and_clear(&saveFilenames);
+
+    directory->listed = true;
+
+    if(saveDirectorySort(device, directory->sort) != 0)
+    {
+        return -1;
+    }
+
+    return directory->count;
+}
+
+PSAVES saveDirectoryGet(jo_backup_device device, unsigned int index)
+{
+    PSAVE_DIRECTORY directory = getDirectory(device);
+
+    if(directory == NULL || index >= directory->count)
+    {
+        return NULL;
+    }
+
+    if(loadInfo(device, &directory->saves[index]) != 0)
+    {
+        return NULL;
+    }
+
+    return &directory->saves[index];
+}
+
+int saveDirectorySort(jo_backup_device device, unsigned int sort)
+{
+    PSAVE_DIRECTORY directory = getDirectory(device);
+
+    if(directory == NULL || sort >= SAVE_NUM_SORTS)
+    {
+        return -1;
+    }
+
+    // names are all there is until the info is loaded
+    if(sort != SAVE_SORT_NAME)
+    {
+        for(unsigned int i = 0; i < directory->count; i++)
+        {
+            if(loadInfo(device, &directory->saves[i]) != 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    directory->sort = sort;
+    sortDirectory(directory);
+
+    return 0;
+}
+
+unsigned int saveDirectoryGetSort(jo_backup_device device)
+{
+    PSAVE_DIRECTORY directory = getDirectory(device);
+
+    return directory != NULL ? directory->sort : SAVE_SORT_NAME;
+}
+
+const char* saveDirectorySortName(unsigned int sort)
+{
+    return sort < SAVE_NUM_SORTS ? SAVE_SORT_NAMES[sort] : "?";
+}
+
+void saveDirectoryRefresh(jo_backup_device device)
+{
+    PSAVE_DIRECTORY directory = getDirectory(device);
+
+    if(directory == NULL)
+    {
+        return;
+    }
+
+    // the allocation is kept for the next read
+    directory->count = 0;
+    directory->listed = false;
+}
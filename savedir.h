@@ -0,0 +1,42 @@
+#pragma once
+#include <jo/jo.h>
+#include "main.h"
+
+/*
+ * Cache of the saves on each backup device. The filenames are read once per
+ * device and kept until saveDirectoryRefresh(). The comment, date and size
+ * come from a jo_backup_get_file_info() call per save, which is slow on big
+ * external devices, so they are only fetched for the saves being shown or
+ * when a sort needs them.
+ */
+
+#define SAVE_SORT_NAME      0
+#define SAVE_SORT_SIZE      1 // largest first
+#define SAVE_SORT_DATE      2 // newest first
+#define SAVE_NUM_SORTS      3
+
+#define SAVE_NUM_DEVICES    3 // JoInternalMemoryBackup, JoCartridgeMemoryBackup, JoExternalDeviceBackup
+
+typedef struct _SAVE_DIRECTORY
+{
+    PSAVES saves; // grows as needed
+    unsigned int count;
+    unsigned int capacity;
+    unsigned int sort; // SAVE_SORT_
+    bool listed; // filenames have been read from the device
+} SAVE_DIRECTORY, *PSAVE_DIRECTORY;
+
+// mounts the device and reads its filenames unless they are already cached
+// returns the number of saves or -1 on error
+int saveDirectoryRead(jo_backup_device device);
+
+// the save at index in the current sort order with its info loaded, NULL on error
+PSAVES saveDirectoryGet(jo_backup_device device, unsigned int index);
+
+// sorts by SAVE_SORT_, loading the info of every save if the sort needs it
+int saveDirectorySort(jo_backup_device device, unsigned int sort);
+unsigned int saveDirectoryGetSort(jo_backup_device device);
+const char* saveDirectorySortName(unsigned int sort);
+
+// forgets the cached saves, for when the device was changed
+void saveDirectoryRefresh(jo_backup_device device);
@@ -0,0 +1,169 @@
+#include <jo/jo.h>
+#include "scsp.h"
+#include "saturn-minimodem.h"
+#include "util.h"
+
+#define SMPC_COMREG     (*(volatile unsigned char*)0x2010001F)
+#define SMPC_SF         (*(volatile unsigned char*)0x20100063)
+
+#define SMPC_SNDON      0x06
+#define SMPC_SNDOFF     0x07
+
+#define SCU_VECTOR_SOUND_REQUEST    0x46
+#define SCU_MASK_SOUND_REQUEST      (1 << 6)
+
+#define SCSP_TIMER_MAX_PRESCALE     7 // counts every 2^7 samples
+#define SCSP_NUM_INTERRUPTS         11
+
+static SCSP_INTERRUPT_HANDLER g_ScspHandlers[SCSP_NUM_INTERRUPTS] = {0};
+static bool g_ScspInterruptInstalled = false;
+
+// OCT shifts the 44.1KHz base rate by -8 to +7 octaves and FNS adds a fraction
+// of an octave on top in 1/1024 steps
+unsigned short scspPitchWord(unsigned int rate)
+{
+    int oct = 0;
+    unsigned int base = SCSP_FREQUENCY;
+    unsigned int fns = 0;
+
+    while(rate >= base * 2 && oct < 7)
+    {
+        base <<= 1;
+        oct++;
+    }
+
+    while(rate < base && oct > -8)
+    {
+        base >>= 1;
+        oct--;
+    }
+
+    if(rate > base)
+    {
+        fns = ((rate - base) << 10) / base;
+    }
+
+    return ((oct & 0x0F) << 11) | (fns & 0x03FF);
+}
+
+unsigned short scspSinePitch(float freq)
+{
+    if(freq == 0)
+    {
+        return SCSP_PITCH_SILENCE;
+    }
+
+    return scspPitchWord((unsigned int)(freq * SCSP_SINE_SAMPLES + 0.5f));
+}
+
+unsigned int scspSamples(unsigned int nsamples, unsigned int rate)
+{
+    return (unsigned int)(((unsigned long long)nsamples * SCSP_FREQUENCY + rate / 2) / rate);
+}
+
+// sound RAM only takes 16-bit writes
+void scspWriteSine(volatile unsigned short* dst)
+{
+    for(unsigned int i = 0; i < SCSP_SINE_SAMPLES; i++)
+    {
+        dst[i] = (unsigned short)(short)lroundf(32767.0f * sinf((float)M_PI * 2 * i / SCSP_SINE_SAMPLES));
+    }
+}
+
+unsigned short scspTimerValue(unsigned int samples)
+{
+    unsigned int prescale = 0;
+
+    while((samples >> prescale) > SCSP_MAX_TIMER_SAMPLES && prescale < SCSP_TIMER_MAX_PRESCALE)
+    {
+        prescale++;
+    }
+
+    samples >>= prescale;
+    samples = samples > SCSP_MAX_TIMER_SAMPLES ? SCSP_MAX_TIMER_SAMPLES : samples;
+
+    // counts up and interrupts on the way past 0xFF
+    return (prescale << 8) | ((256 - samples) & 0xFF);
+}
+
+// one SCU vector for every SCSP interrupt, each pending bit goes to its handler
+static void scspInterrupt(void)
+{
+    unsigned short pending = 0;
+
+    SCU_IST = ~SCU_MASK_SOUND_REQUEST;
+
+    pending = SCSP_MCIPD & SCSP_MCIEB;
+    for(unsigned int i = 0; i < SCSP_NUM_INTERRUPTS; i++)
+    {
+        if(pending & (1 << i))
+        {
+            SCSP_MCIRE = 1 << i;
+
+            if(g_ScspHandlers[i] != NULL)
+            {
+                g_ScspHandlers[i]();
+            }
+        }
+    }
+}
+
+int scspSetInterruptHandler(unsigned int interrupt, SCSP_INTERRUPT_HANDLER handler)
+{
+    unsigned int bit = 0;
+    unsigned int sr = 0;
+
+    while(bit < SCSP_NUM_INTERRUPTS && interrupt != (1u << bit))
+    {
+        bit++;
+    }
+
+    if(bit >= SCSP_NUM_INTERRUPTS)
+    {
+        jo_core_error("Invalid SCSP interrupt 0x%x!!", interrupt);
+        return -1;
+    }
+
+    if(g_ScspInterruptInstalled == false)
+    {
+        BIOS_SET_SCU_INTERRUPT(SCU_VECTOR_SOUND_REQUEST, scspInterrupt);
+        BIOS_CHANGE_SCU_MASK(~SCU_MASK_SOUND_REQUEST, 0);
+        g_ScspInterruptInstalled = true;
+    }
+
+    sr = disableInterrupts();
+    g_ScspHandlers[bit] = handler;
+    if(handler != NULL)
+    {
+        SCSP_MCIRE = interrupt;
+        SCSP_MCIEB |= interrupt;
+    }
+    else
+    {
+        SCSP_MCIEB &= ~interrupt;
+    }
+    restoreInterrupts(sr);
+
+    return 0;
+}
+
+static void smpcCommand(unsigned char command)
+{
+    while(SMPC_SF & 1);
+
+    SMPC_SF = 1;
+    SMPC_COMREG = command;
+
+    while(SMPC_SF & 1);
+}
+
+void scspSoundCpuOff(void)
+{
+    smpcCommand(SMPC_SNDOFF);
+}
+
+// the 68000 starts from the reset vectors at the bottom of sound RAM
+void scspSoundCpuOn(void)
+{
+    smpcCommand(SMPC_SNDON);
+}
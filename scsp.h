@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+ * SCSP sound chip registers as seen from the SH-2, and the SMPC commands
+ * that hold and release the 68000 sound CPU.
+ */
+
+#define SCSP_BASE                   0x25B00000
+#define SCSP_NUM_SLOTS              32
+#define SCSP_SLOT_REG(slot, offset) (*(volatile unsigned short*)(SCSP_BASE + (slot) * 0x20 + (offset)))
+#define SCSP_MONITOR                (*(volatile unsigned short*)(SCSP_BASE + 0x408))
+
+// slot register offsets
+#define SCSP_SLOT_CONTROL           0x00 // KYONEX, KYONB, LPCTL, PCM8B and SA[19:16]
+#define SCSP_SLOT_SA                0x02 // start address [15:0]
+#define SCSP_SLOT_LSA               0x04 // loop start, in samples
+#define SCSP_SLOT_LEA               0x06 // loop end, in samples
+#define SCSP_SLOT_ENV1              0x08 // D2R, D1R, EGHOLD, AR
+#define SCSP_SLOT_ENV2              0x0A // LPSLNK, KRS, DL, RR
+#define SCSP_SLOT_LEVEL             0x0C // STWINH, SDIR, TL
+#define SCSP_SLOT_MOD               0x0E
+#define SCSP_SLOT_PITCH             0x10 // OCT, FNS
+#define SCSP_SLOT_LFO               0x12
+#define SCSP_SLOT_INPUT             0x14
+#define SCSP_SLOT_OUTPUT            0x16 // DISDL, DIPAN, EFSDL, EFPAN
+
+#define SCSP_KYONEX                 0x1000 // execute the key on/off of every slot
+#define SCSP_KYONB                  0x0800 // key on
+#define SCSP_LPCTL_NORMAL           0x0020 // loop from LSA to LEA forever
+#define SCSP_AR_MAX                 0x001F // no attack
+#define SCSP_KRS_OFF_RR_MAX         0x3C1F // no key rate scaling, immediate release
+#define SCSP_TL_MUTE                0x00FF
+#define SCSP_DISDL_MAX              0xE000 // full direct send level, panned center
+
+// the monitor returns the upper 4 bits of the slot's 16-bit sample offset
+#define SCSP_MONITOR_SLOT(slot)     ((slot) << 11)
+#define SCSP_MONITOR_CA(value)      (((value) >> 7) & 0x0F)
+#define SCSP_CA_SAMPLES             0x1000
+
+// the rate every slot is mixed at
+#define SCSP_FREQUENCY              44100
+
+// queued in place of a pitch word by the tone backends to mute the slot
+#define SCSP_PITCH_SILENCE          0x8000
+
+// single cycle sine the tone backends loop over
+#define SCSP_SINE_SAMPLES           32
+
+// SCSP timer A counts 8 bits of samples
+#define SCSP_MAX_TIMER_SAMPLES      255
+
+// SCSP timers count output samples and interrupt the main CPU through the
+// SCU sound request interrupt
+#define SCSP_TIMER_A                (*(volatile unsigned short*)(SCSP_BASE + 0x418))
+#define SCSP_TIMER_B                (*(volatile unsigned short*)(SCSP_BASE + 0x41A))
+#define SCSP_MCIEB                  (*(volatile unsigned short*)(SCSP_BASE + 0x42A)) // enable
+#define SCSP_MCIPD                  (*(volatile unsigned short*)(SCSP_BASE + 0x42C)) // pending
+#define SCSP_MCIRE                  (*(volatile unsigned short*)(SCSP_BASE + 0x42E)) // reset
+#define SCSP_INT_TIMER_A            (1 << 6)
+#define SCSP_INT_TIMER_B            (1 << 7)
+
+typedef void (*SCSP_INTERRUPT_HANDLER)(void);
+
+// OCT/FNS pitch word that plays a sample at rate samples per second
+unsigned short scspPitchWord(unsigned int rate);
+
+// pitch word that loops the sine at freq Hz, SCSP_PITCH_SILENCE for 0
+unsigned short scspSinePitch(float freq);
+
+// nsamples at rate converted to samples at SCSP_FREQUENCY
+unsigned int scspSamples(unsigned int nsamples, unsigned int rate);
+
+// writes SCSP_SINE_SAMPLES of a full scale sine into sound RAM
+void scspWriteSine(volatile unsigned short* dst);
+
+// timer register value that overflows after samples, prescaled for up to 255 * 128
+unsigned short scspTimerValue(unsigned int samples);
+
+// calls handler from the sound request interrupt whenever the SCSP raises the
+// SCSP_INT_ bit in interrupt, NULL disables it. The bit is acknowledged first
+int scspSetInterruptHandler(unsigned int interrupt, SCSP_INTERRUPT_HANDLER handler);
+
+// holds the 68000 in reset so sound RAM can be loaded, and releases it
+void scspSoundCpuOff(void);
+void scspSoundCpuOn(void);
@@ -6,10 +6,33 @@
 # and writes it out to disk.
 #
 # The transmission consists of a TRANSMISSION_HEADER and a BUP_HEADER followed
-# by a variable number of bytes of data. The transmission is zipped, Reed
+# by a variable number of bytes of data and a TRANSMISSION_TRAILER holding the
+# MD5 hash and/or CRC-32. The transmission is zipped, Reed
 # Solomon encoded, and then escaped. This Python script undoes all of that.
 #
+# The whole BIOS is streamed as a run of checkpoints, each a transmission of
+# the next piece of the image preceded by ESCAPE_BYTE CHECKPOINT_BYTE. Every
+# piece is checked on its own and the image is put back together and checked
+# against the MD5 in the last checkpoint.
+#
+# Data the Saturn knows to be a stock image (see known.c) is not sent, only
+# its headers and trailer. The data is taken from the reference files in the
+# library directory that match the trailer's size and MD5.
+#
+# When a transmission can't be decoded the script prints the Reed Solomon
+# codeword to resume it from. The Saturn then sends the rest preceded by
+# ESCAPE_BYTE RESUME_BYTE, the checkpoint and the codeword. Pass the earlier
+# captures before the resumed one and the codewords are joined together.
+#
+# A transmission sent with a speed profile other than the default (see
+# speed.h) is preceded by ESCAPE_BYTE ANNOUNCE_BYTE and its settings, sent at
+# the default settings. Given the recording instead of minimodem's output the
+# script runs minimodem itself, reads the announcement and decodes the
+# recording again with the announced settings and Reed Solomon parity.
+#
 
+import os
+import subprocess
 import sys
 import binascii
 import hashlib
@@ -17,32 +40,123 @@ import reedsolo
 import zlib
 
 '''
-Taken from main.h
+Taken from encode.h
 typedef struct _TRANSMISSION_HEADER
 {
     char magic[TRANSMISSION_MAGIC_SIZE]; // magic bytes be SGEX
-    unsigned char md5Hash[MD5_HASH_SIZE];
+    unsigned char version; // TRANSMISSION_VERSION
+    unsigned char integrity; // INTEGRITY_ mask of the checks in the trailer
+    unsigned char checkpoint; // index of this piece of a streamed image
+    unsigned char numCheckpoints; // pieces in the stream, 0 when not streamed
+    unsigned int imageOffset; // where this piece goes in the image
+    unsigned char knownImage; // the data wasn't sent, it is this known image. 0 when it was sent
+    unsigned char reserved[MD5_HASH_SIZE - 9]; // zero, bytes 4 to 20 held the MD5 hash in version 1
     char saveFilename[MAX_SAVE_FILENAME]; // save filename
     unsigned int saveFileSize;  // size of the file in bytes
     unsigned char saveFileData[0]; // saveFileSize number of bytes of save data
 } TRANSMISSION_HEADER, *PTRANSMISSION_HEADER;
 
+// checks that weren't selected are zero
+typedef struct _TRANSMISSION_TRAILER
+{
+    unsigned char md5Hash[MD5_HASH_SIZE]; // MD5 of the save file data, or of the image so far with INTEGRITY_IMAGE_MD5
+    unsigned int crc; // CRC-32 of the save file data
+} TRANSMISSION_TRAILER, *PTRANSMISSION_TRAILER;
+
+Version 1 transmissions have the MD5 hash in the header and no trailer.
+
 Taken from bup_header.h
 '''
 
 MAGIC = "SGEX"
 TRANSMISSION_HEADER_SIZE = 36
+TRANSMISSION_TRAILER_SIZE = 20
 BUP_HEADER_SIZE = 64
 
+INTEGRITY_MD5 = 0x01
+INTEGRITY_CRC32 = 0x02
+INTEGRITY_IMAGE_MD5 = 0x04
+
 ESCAPE_BYTE = 0x54
 SYNC_REPLACE = 0x9F
 SYNC_BYTE = 0xAB
+CHECKPOINT_BYTE = 0xC5
+RESUME_BYTE = 0xC6
+RESUME_MARKER_SIZE = 5
+ANNOUNCE_BYTE = 0xC7
+SPEED_RECORD_SIZE = 10
+
+CODEWORD_SIZE = 255
+PARITY_BYTES = 32
+
+# the modem's defaults, the settings announcements are sent with
+DEFAULT_SPEED = {"rate": 1200, "mark": 1200, "space": 2200, "startBits": 4, "stopBits": 4, "parity": PARITY_BYTES}
+
+# Reed Solomon parity bytes per codeword, changed by an announcement or -p
+reedSolomonParity = PARITY_BYTES
+
+# reference files for known images, next to this script unless given
+LIBRARY_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "known")
+
+# Finds the reference file for a known image by size and MD5
+def findKnownImage(libraryDir, size, md5Hash):
+
+    try:
+        names = sorted(os.listdir(libraryDir))
+    except:
+        return None
+
+    for name in names:
+        path = os.path.join(libraryDir, name)
+
+        if not os.path.isfile(path) or os.path.getsize(path) != size:
+            continue
+
+        with open(path, "rb") as f:
+            data = f.read()
+
+        if hashlib.md5(data).hexdigest() == md5Hash:
+            print("Known Image: " + path)
+            return data
+
+    return None
+
+# Split a stream on the ESCAPE_BYTE CHECKPOINT_BYTE markers
+# A transmission without any markers comes back as the only piece
+def splitCheckpoints(message):
+
+    pieces = []
+    start = 0
+    i = 0
+
+    while(i < len(message)):
+
+        if message[i] == ESCAPE_BYTE and i + 1 < len(message):
+
+            if message[i + 1] == CHECKPOINT_BYTE:
+
+                if i > start:
+                    pieces.append(message[start:i])
+
+                start = i + 2
+
+            # skip the escaped byte, it can't start a marker
+            i += 2
+
+        else:
+            i += 1
+
+    if start < len(message):
+        pieces.append(message[start:])
+
+    return pieces
 
 # Change two ESCAPE_BYTEs in a row to a single ESCAPE_BYTE
 # Change an ESCAPE_BYTE followed by SYNC_REPLACE byte to a single SYNC_BYTE
+# Returns the unescaped data and False if it stopped at an invalid escape
 def unescape(message):
 
-    escapedMessage = b''
+    escapedMessage = bytearray()
 
     i = 0
 
@@ -50,135 +164,502 @@ def unescape(message):
 
         if message[i] == ESCAPE_BYTE:
 
-            if message[i + 1] == ESCAPE_BYTE:
+            if i + 1 < len(message) and message[i + 1] == ESCAPE_BYTE:
 
                 # two ESCAPE_BYTES, replace with a single ESCAPE_BYTE
-                escapedMessage = escapedMessage + ESCAPE_BYTE.to_bytes(1, 'big')
+                escapedMessage.append(ESCAPE_BYTE)
                 i = i + 1
 
-            elif message[i + 1] == SYNC_REPLACE:
+            elif i + 1 < len(message) and message[i + 1] == SYNC_REPLACE:
 
                 # ESCAPE_BYTE followed by a SYNC_REPLACE
                 # replace with a SYNC_BYTE
-                escapedMessage = escapedMessage + SYNC_BYTE.to_bytes(1, 'big')
+                escapedMessage.append(SYNC_BYTE)
                 i = i + 1
 
             else:
 
                 # invalid escape sequence data, the data is corrupted
-                return ""
+                # what came before it can still be resumed from
+                return bytes(escapedMessage), False
         else:
 
             # not an escape byte, continue as normal
-            escapedMessage = escapedMessage + message[i].to_bytes(1, 'big')
+            escapedMessage.append(message[i])
 
         i += 1
 
-    return escapedMessage
+    return bytes(escapedMessage), True
 
-def main():
+# Reed Solomon parameters must match settings used by libcorrect
+def newCodec():
+    return reedsolo.RSCodec(nsym=reedSolomonParity, nsize=CODEWORD_SIZE, fcr=1, prim=0x187)
 
-    print("Save Game Extractor");
-    print("(github.com/slinga-homebrew/Save-Game-Extractor)\n")
+# Same check byte as speedCheck() in speed.c
+def speedCheck(record):
 
-    if len(sys.argv) != 2:
-        print("Error: Input filename required")
-        return -1
+    check = 0x5A
+    for byte in record[:SPEED_RECORD_SIZE - 1]:
+        check = (((check << 1) | (check >> 7)) & 0xFF) ^ byte
+
+    return check
+
+# Finds the first intact ESCAPE_BYTE ANNOUNCE_BYTE record of speed settings
+# Returns the settings and the message with the announcements cut out, or
+# None and the message as it was
+def parseAnnouncement(message):
+
+    speed = None
+    start = message.find(bytes([ESCAPE_BYTE, ANNOUNCE_BYTE]))
+    end = start
+
+    while start != -1 and end + 1 < len(message) and message[end] == ESCAPE_BYTE and message[end + 1] == ANNOUNCE_BYTE:
+
+        # the record is escaped like the data
+        i = end + 2
+        record = bytearray()
+        while len(record) < SPEED_RECORD_SIZE and i < len(message):
+            if message[i] == ESCAPE_BYTE and i + 1 < len(message):
+                record.append(ESCAPE_BYTE if message[i + 1] == ESCAPE_BYTE else SYNC_BYTE)
+                i += 2
+            else:
+                record.append(message[i])
+                i += 1
+        end = i
+
+        if speed is None and len(record) == SPEED_RECORD_SIZE and record[9] == speedCheck(record):
+            speed = {"rate": (record[0] << 8) | record[1], "mark": (record[2] << 8) | record[3],
+                     "space": (record[4] << 8) | record[5], "startBits": record[6],
+                     "stopBits": record[7], "parity": record[8]}
+
+    if speed is None:
+        return None, message
+
+    return speed, message[:start] + message[end:]
 
-    filename = sys.argv[1]
+def speedName(speed):
+    return (str(speed["rate"]) + " baud " + str(speed["startBits"]) + "+" + str(speed["stopBits"]) +
+            ", tones " + str(speed["mark"]) + "/" + str(speed["space"]) + " Hz, RS(255," +
+            str(CODEWORD_SIZE - speed["parity"]) + ")")
+
+def minimodemCommand(speed):
+    return ["minimodem", "--rx", "-q", "-M", str(speed["mark"]), "-S", str(speed["space"]),
+            "--startbits", str(speed["startBits"]), "--stopbits", str(speed["stopBits"]),
+            "--sync", "0xAB", str(speed["rate"])]
+
+# Decodes a recording with minimodem, again with the announced settings if
+# there are any. Returns what minimodem received and the announced settings
+def receiveRecording(filename):
 
     try:
-        inFile = open(filename, "rb")
+        message = subprocess.run(minimodemCommand(DEFAULT_SPEED) + ["-f", filename], stdout=subprocess.PIPE, check=True).stdout
     except:
-        print("Error: Could not open " + filename + " for reading")
-        return -1
+        print("Error: Could not run minimodem on " + filename)
+        return None, None
 
-    #
-    # Unescape the buffer
-    #
+    speed, message = parseAnnouncement(message)
+    if speed is None or speed == DEFAULT_SPEED:
+        return message, speed
 
-    escapedBuf = inFile.read()
+    print("Announced Speed: " + speedName(speed))
 
-    # unescape the buffer
-    unescapedBuf = unescape(escapedBuf)
-    if unescapedBuf == "":
-        print("Failed to unescape data, something is corrupt.");
-        return -1
+    try:
+        message = subprocess.run(minimodemCommand(speed) + ["-f", filename], stdout=subprocess.PIPE, check=True).stdout
+    except:
+        print("Error: Could not run minimodem on " + filename)
+        return None, None
+
+    # it can pick up the end of the announcement, there's nothing to lose in it
+    return parseAnnouncement(message)[1], speed
+
+# Splits ESCAPE_BYTE RESUME_BYTE checkpoint codeword off the start of a piece
+# Returns the checkpoint, the codeword and the rest of the piece or None
+def parseResume(piece):
+
+    if len(piece) < 2 or piece[0] != ESCAPE_BYTE or piece[1] != RESUME_BYTE:
+        return None
+
+    # the numbers are escaped like the data
+    i = 2
+    numbers = bytearray()
+    while len(numbers) < RESUME_MARKER_SIZE - 2 and i < len(piece):
+        if piece[i] == ESCAPE_BYTE and i + 1 < len(piece):
+            numbers.append(ESCAPE_BYTE if piece[i + 1] == ESCAPE_BYTE else SYNC_BYTE)
+            i += 2
+        else:
+            numbers.append(piece[i])
+            i += 1
+
+    if len(numbers) < RESUME_MARKER_SIZE - 2:
+        return None
+
+    return numbers[0], (numbers[1] << 8) | numbers[2], piece[i:]
+
+# Reads the checkpoint from the header in the first codeword, so a damaged
+# transmission can still be matched with its resumed rest. None if unreadable
+def peekCheckpoint(unescapedBuf):
+
+    try:
+        firstCodeword = newCodec().decode(unescapedBuf[:CODEWORD_SIZE])[0]
+        header = zlib.decompressobj().decompress(bytes(firstCodeword))
+    except:
+        return None
+
+    if len(header) < 8 or header[0:4] != MAGIC.encode("utf-8"):
+        return None
+
+    # zero when it isn't part of a stream
+    return header[6]
+
+# The first codeword Reed Solomon can't correct, where a resend has to start
+def firstBadCodeword(unescapedBuf):
+
+    rsc = newCodec()
+
+    for i in range(0, len(unescapedBuf), CODEWORD_SIZE):
+        try:
+            rsc.decode(unescapedBuf[i:i + CODEWORD_SIZE])
+        except:
+            return i // CODEWORD_SIZE
+
+    # everything that arrived is fine, the rest is missing
+    return len(unescapedBuf) // CODEWORD_SIZE
+
+# Tells the user where to restart the transmission from on the Saturn
+def printResume(unescapedBuf, checkpoint):
+
+    codeword = firstBadCodeword(unescapedBuf)
+
+    if checkpoint:
+        print("Resume checkpoint " + str(checkpoint + 1) + " from codeword " + str(codeword))
+    else:
+        print("Resume from codeword " + str(codeword))
+
+# Undoes the Reed Solomon and compression of a single unescaped transmission
+# and checks it. Returns a dictionary describing it or None if it is corrupt
+def decodeTransmission(unescapedBuf, complete, checkpoint, libraryDir):
 
     #
     # Reed Solomon decode
     #
 
-    # Reed Solomon parameters must match settings used by libcorrect
-    rsc = reedsolo.RSCodec(nsym=32, nsize=255, fcr=1, prim=0x187)
+    rsc = newCodec()
 
     try:
+        if not complete:
+            raise ValueError("invalid escape sequence")
+
         decodedBuf = rsc.decode(unescapedBuf)
+        compressedBuf = decodedBuf[0]
     except:
         print("Reed Solomon couldn't decode buffer, too many errors.")
         print(sys.exc_info()[0])
-        return -1
-
-    print("Errors Corrected: " + str(len(decodedBuf[2])))
-
-    compressedBuf = decodedBuf[0]
+        printResume(unescapedBuf, checkpoint)
+        return None
 
     #
     # Decompress the data
     #
-    decompressedBuf = zlib.decompress(compressedBuf);
+    try:
+        decompressedBuf = zlib.decompress(compressedBuf);
+    except:
+        print("Error: Failed to decompress the data")
+        printResume(unescapedBuf, checkpoint)
+        return None
+
+    print("Errors Corrected: " + str(len(decodedBuf[2])))
 
     #
-    # TRANSMISSION_HEADER + variable length save data
+    # TRANSMISSION_HEADER + BUP_HEADER + variable length save data + TRANSMISSION_TRAILER
     #
 
     # sanity check the buffer
     if len(decompressedBuf) < TRANSMISSION_HEADER_SIZE:
-        print("Error: " + filename + " is too small. Must be at least TRANSMISSION_HEADER_SIZE")
-        return -1
+        print("Error: The transmission is too small. Must be at least TRANSMISSION_HEADER_SIZE")
+        return None
 
     # SGEX magic bytes
-    magic = decompressedBuf[0:4].decode("utf-8")
+    magic = decompressedBuf[0:4].decode("utf-8", "replace")
     if magic != MAGIC:
         print("Error: The magic bytes are invalid")
-        return -1
+        return None
 
     saveSize = binascii.b2a_hex(decompressedBuf[32:36])
     saveSize = int(saveSize, 16)
-
+    saveStart = TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE
+    saveEnd = saveStart + saveSize
+    checkpoint = 0
+    numCheckpoints = 0
+    imageOffset = 0
+    md5Hash = ""
+    crc32 = 0
+    knownImage = 0
+
+    # version 2 and later send the integrity checks in a trailer after the save
     # validate length, shouldn't fail here because of the Reed Solomon check
-    if TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + saveSize != len(decompressedBuf):
-        print("Error: Received incorrect number of bytes. Expected " + str(TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + saveSize) + ", got " + str(len(decompressedBuf)))
-        return -1
+    version = decompressedBuf[4]
+    if version >= 2 and len(decompressedBuf) >= TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE + TRANSMISSION_TRAILER_SIZE and decompressedBuf[12] != 0:
+        # a known image record, the trailer follows the headers
+        integrity = decompressedBuf[5]
+        checkpoint = decompressedBuf[6]
+        numCheckpoints = decompressedBuf[7]
+        imageOffset = int(binascii.b2a_hex(decompressedBuf[8:12]), 16)
+        knownImage = decompressedBuf[12]
+        md5Hash = binascii.b2a_hex(decompressedBuf[saveStart:saveStart + 16]).decode("utf-8")
+        crc32 = int(binascii.b2a_hex(decompressedBuf[saveStart + 16:saveStart + 20]), 16)
+    elif version >= 2 and saveEnd + TRANSMISSION_TRAILER_SIZE == len(decompressedBuf):
+        integrity = decompressedBuf[5]
+        checkpoint = decompressedBuf[6]
+        numCheckpoints = decompressedBuf[7]
+        imageOffset = int(binascii.b2a_hex(decompressedBuf[8:12]), 16)
+        md5Hash = binascii.b2a_hex(decompressedBuf[saveEnd:saveEnd + 16]).decode("utf-8")
+        crc32 = int(binascii.b2a_hex(decompressedBuf[saveEnd + 16:saveEnd + 20]), 16)
+    elif saveEnd == len(decompressedBuf):
+        version = 1
+        integrity = INTEGRITY_MD5
+        md5Hash = binascii.b2a_hex(decompressedBuf[4:20]).decode("utf-8")
+    else:
+        print("Error: Received incorrect number of bytes. Expected " + str(saveEnd + TRANSMISSION_TRAILER_SIZE) + ", got " + str(len(decompressedBuf)))
+        return None
+
+    if integrity & (INTEGRITY_MD5 | INTEGRITY_CRC32) == 0:
+        print("Error: The transmission has no integrity checks")
+        return None
 
-    saveName = decompressedBuf[20:31].decode("utf-8")
-    md5Hash = binascii.b2a_hex(decompressedBuf[4:20]).decode("utf-8")
+    saveName = decompressedBuf[20:31].decode("utf-8", "replace").rstrip("\0")
 
-    # verify the MD5 hash. Again shouldn't ever fail here due to the Reed Solomon check
-    computedHashResult = hashlib.md5(decompressedBuf[TRANSMISSION_HEADER_SIZE + BUP_HEADER_SIZE:])
-    computedHash = computedHashResult.hexdigest()
+    if knownImage != 0:
+        print("Transmitted Filename: " + saveName)
+        print("Identical to known image " + str(knownImage) + " with MD5 " + md5Hash)
+
+        saveData = findKnownImage(libraryDir, saveSize, md5Hash)
+        if saveData is None:
+            print("Error: No file in " + libraryDir + " matches it. Add one or send it in full with X on the Saturn.")
+            return None
+    else:
+        saveData = decompressedBuf[saveStart:saveEnd]
 
+    print("Transmission Version: " + str(version))
     print("Transmitted Filename: " + saveName)
     print("Transmitted Save Size: " + str(saveSize))
-    print("Transmitted MD5: " + str(md5Hash))
-    print("Computed MD5: " + computedHash)
+    if numCheckpoints != 0:
+        print("Checkpoint: " + str(checkpoint + 1) + "/" + str(numCheckpoints) + " at offset " + str(imageOffset))
+
+    # verify the checks that were sent. Again shouldn't ever fail here due to the Reed Solomon check
+    valid = True
+
+    if integrity & INTEGRITY_MD5:
+        computedHash = hashlib.md5(saveData).hexdigest()
+
+        print("Transmitted MD5: " + str(md5Hash))
+        print("Computed MD5: " + computedHash)
+
+        if md5Hash != computedHash:
+            valid = False
+
+    if integrity & INTEGRITY_CRC32:
+        computedCrc32 = zlib.crc32(saveData)
+
+        print("Transmitted CRC32: " + format(crc32, "08x"))
+        print("Computed CRC32: " + format(computedCrc32, "08x"))
+
+        if crc32 != computedCrc32:
+            valid = False
+
+    # checked once the image is put back together
+    if integrity & INTEGRITY_IMAGE_MD5:
+        print("Transmitted Image MD5: " + str(md5Hash))
+
+    return {"valid": valid, "name": saveName, "data": saveData,
+            "bup": decompressedBuf[TRANSMISSION_HEADER_SIZE:saveStart] + saveData,
+            "integrity": integrity, "md5": md5Hash, "checkpoint": checkpoint,
+            "numCheckpoints": numCheckpoints, "offset": imageOffset}
+
+# writes a single save out as a .BUP file
+def writeSave(transmission):
+
     print("")
 
-    if md5Hash != computedHash:
-        print("MD5 hashes don't match, save is corrupt.")
+    if transmission["valid"] == False:
+        print("Integrity checks don't match, save is corrupt.")
     else:
-        print("MD5 hashes validate, save is correct.")
+        print("Integrity checks validate, save is correct.")
+
+    saveName = transmission["name"]
 
     # create the output .BUP file
     try:
         outFile = open(saveName + ".BUP", "wb")
-        outFile.write(decompressedBuf[TRANSMISSION_HEADER_SIZE:])
+        outFile.write(transmission["bup"])
         outFile.close()
     except:
         print("Error writing save " + saveName + ".BUP to disk")
         return -1
 
     print("Wrote save game " + saveName + ".BUP to disk")
+    return 0
+
+# puts a streamed image back together from its checkpoints and writes it out
+def writeImage(transmissions):
+
+    checkpoints = {}
+    numCheckpoints = 0
+
+    for transmission in transmissions:
+        if transmission is None or transmission["numCheckpoints"] == 0 or transmission["valid"] == False:
+            continue
+
+        numCheckpoints = transmission["numCheckpoints"]
+        checkpoints[transmission["checkpoint"]] = transmission
+
+    print("")
+
+    if numCheckpoints == 0:
+        print("Error: No checkpoints were received intact")
+        return -1
+
+    missing = [str(i + 1) for i in range(numCheckpoints) if i not in checkpoints]
+    if len(missing) != 0:
+        print("Checkpoints missing or corrupt: " + ", ".join(missing) + " of " + str(numCheckpoints))
+        print("Resume them on the Saturn and pass the new capture after this one.")
+        return -1
+
+    image = b''
+    for i in range(numCheckpoints):
+        if checkpoints[i]["offset"] != len(image):
+            print("Error: Checkpoint " + str(i + 1) + " is at offset " + str(checkpoints[i]["offset"]) + ", expected " + str(len(image)))
+            return -1
+        image = image + checkpoints[i]["data"]
+
+    last = checkpoints[numCheckpoints - 1]
+    imageName = last["name"]
+
+    print("Image Size: " + str(len(image)))
+    if last["integrity"] & INTEGRITY_IMAGE_MD5:
+        computedHash = hashlib.md5(image).hexdigest()
+
+        print("Transmitted Image MD5: " + last["md5"])
+        print("Computed Image MD5: " + computedHash)
+
+        if last["md5"] != computedHash:
+            print("Image MD5 doesn't match, image is corrupt.")
+            return -1
+
+        print("Image MD5 validates, image is correct.")
+
+    try:
+        outFile = open(imageName, "wb")
+        outFile.write(image)
+        outFile.close()
+    except:
+        print("Error writing image " + imageName + " to disk")
+        return -1
+
+    print("Wrote image " + imageName + " to disk")
+    return 0
+
+def main():
+
+    global reedSolomonParity
+
+    print("Save Game Extractor");
+    print("(github.com/slinga-homebrew/Save-Game-Extractor)\n")
+
+    filenames = []
+    libraryDir = LIBRARY_DIR
+
+    args = sys.argv[1:]
+    while len(args) != 0:
+        arg = args.pop(0)
+        if arg == "-l" and len(args) != 0:
+            libraryDir = args.pop(0)
+        elif arg == "-p" and len(args) != 0:
+            reedSolomonParity = int(args.pop(0))
+        else:
+            filenames.append(arg)
+
+    if len(filenames) == 0:
+        print("Error: Input filename required")
+        print("Usage: sgex.py [-l known image library directory] [-p parity bytes] received.bin|recording.wav [resumed.bin ...]")
+        return -1
+
+    # a save is a single transmission, a streamed image is one per checkpoint
+    pieces = []
+    for filename in filenames:
+
+        if filename.lower().endswith(".wav"):
+            message, speed = receiveRecording(filename)
+            if message is None:
+                return -1
+        else:
+            try:
+                inFile = open(filename, "rb")
+            except:
+                print("Error: Could not open " + filename + " for reading")
+                return -1
+
+            message = inFile.read()
+            inFile.close()
+
+            # minimodem was on the default settings, what follows was sent with others
+            speed, message = parseAnnouncement(message)
+            if speed is not None and speed != DEFAULT_SPEED:
+                print("Announced Speed: " + speedName(speed))
+                print("Receive with: " + " ".join(minimodemCommand(speed)) + " > received.bin")
+                print("or pass the recording to sgex.py instead.")
+                print("")
+
+        if speed is not None:
+            reedSolomonParity = speed["parity"]
+
+        pieces = pieces + splitCheckpoints(message)
+
+    if len(pieces) == 0:
+        print("Error: Nothing was received")
+        return -1
+
+    # unescape and join resumed pieces to the earlier piece they continue
+    candidates = []
+    for piece in pieces:
+        resume = parseResume(piece)
+
+        if resume is None:
+            unescapedBuf, complete = unescape(piece)
+            candidates.append({"checkpoint": peekCheckpoint(unescapedBuf), "buf": unescapedBuf, "complete": complete})
+            continue
+
+        checkpoint, codeword, rest = resume
+        unescapedBuf, complete = unescape(rest)
+
+        earlier = None
+        for candidate in reversed(candidates):
+            if candidate["checkpoint"] == checkpoint:
+                earlier = candidate
+                break
+
+        if earlier is None or len(earlier["buf"]) < codeword * CODEWORD_SIZE:
+            print("Error: No earlier capture has the codewords before " + str(codeword) + " of checkpoint " + str(checkpoint + 1))
+            print("")
+            continue
+
+        print("Joined codewords " + str(codeword) + " on to checkpoint " + str(checkpoint + 1))
+        print("")
+
+        candidates.remove(earlier)
+        candidates.append({"checkpoint": checkpoint, "buf": earlier["buf"][:codeword * CODEWORD_SIZE] + unescapedBuf, "complete": complete})
+
+    transmissions = []
+    for candidate in candidates:
+        transmissions.append(decodeTransmission(candidate["buf"], candidate["complete"], candidate["checkpoint"], libraryDir))
+        print("")
+
+    if len(transmissions) == 1 and transmissions[0] is not None and transmissions[0]["numCheckpoints"] == 0:
+        return writeSave(transmissions[0])
+
+    if len(transmissions) == 1 and transmissions[0] is None:
+        return -1
+
+    return writeImage(transmissions)
 
 if __name__ == "__main__":
 
@@ -27,6 +27,8 @@
 
 #include "saturn-minimodem.h"
 #include "simpleaudio.h"
+#include "simpleaudio_internal.h"
+#include "profile.h"
 
 static float tone_mag = 1.0;
 
@@ -118,89 +120,196 @@ sin_lu_float( float turns )
 /* "current" phase state of the tone generator */
 static float sa_tone_cphase = 0.0;
 
+/* frequency changes are swept over this many samples, 0 switches at once */
+static size_t sa_tone_shape_nsamples = 0;
+static float sa_tone_last_freq = 0.0;
+
 void
 simpleaudio_tone_reset()
 {
     sa_tone_cphase = 0.0;
+    sa_tone_last_freq = 0.0;
 }
 
+/*
+* the start of a tone that differs from the last one sweeps from the last
+* frequency with a raised cosine instead of jumping, see simpleaudio_tone()
+*/
 void
-simpleaudio_tone(simpleaudio *sa_out, float tone_freq, size_t nsamples_dur)
+simpleaudio_tone_shaping( size_t nsamples )
+{
+    sa_tone_shape_nsamples = nsamples;
+}
+
+static int
+tone_mag_short(simpleaudio *sa_out, unsigned short *mag_s)
+{
+    switch ( simpleaudio_get_format(sa_out) ) {
+
+        case SA_SAMPLE_FORMAT_S16:
+            *mag_s = 32767.0f * tone_mag + 0.5f;
+            if ( tone_mag > 1.0f ) // clamp to 1.0 to avoid overflow
+                *mag_s = 32767;
+            if ( *mag_s < 1 ) // "short epsilon"
+                *mag_s = 1;
+            return 0;
+
+        /* SA_SAMPLE_FORMAT_FLOAT is never used */
+        default:
+            jo_core_error("Invalid format");
+            return -1;
+    }
+}
+
+/*
+* scratch for the samples, in .bss so it sits in HWRAM instead of the LWRAM
+* transfer arena. Longer tones are written out in chunks
+*/
+#define TONE_CHUNK_BYTES 4096
+static short tone_buf[TONE_CHUNK_BYTES / sizeof(short)];
+
+static void
+simpleaudio_tone_synth(simpleaudio *sa_out, float tone_freq, size_t nsamples_dur)
 {
     unsigned int framesize = simpleaudio_get_framesize(sa_out);
+    size_t chunk_frames = framesize ? TONE_CHUNK_BYTES / framesize : 0;
+    float wave_nsamples = 0;
+    unsigned short mag_s = 0;
+    size_t start;
+    size_t i;
 
-    void *buf = jo_malloc(nsamples_dur * framesize);
-    if(buf == NULL)
+    if ( chunk_frames == 0 )
     {
-        jo_core_error("simpleaudio_tone: jo_malloc fail");
+        jo_core_error("simpleaudio_tone: invalid frame size %d", framesize);
         return;
     }
 
     if ( tone_freq != 0 ) {
 
-        float wave_nsamples = simpleaudio_get_rate(sa_out) / tone_freq;
-        size_t i;
+        wave_nsamples = simpleaudio_get_rate(sa_out) / tone_freq;
+
+        if ( tone_mag_short(sa_out, &mag_s) != 0 )
+            return;
+    }
 
 #define TURNS_TO_RADIANS(t)	( (float)M_PI*2 * (t) )
 #define SINE_PHASE_TURNS	( (float)i/wave_nsamples + sa_tone_cphase )
 #define SINE_PHASE_RADIANS	TURNS_TO_RADIANS(SINE_PHASE_TURNS)
 
-        switch ( simpleaudio_get_format(sa_out) ) {
-
-            /*
-            case SA_SAMPLE_FORMAT_FLOAT:
-            {
-                float *float_buf = buf;
-                if ( sin_table_float ) {
-                for ( i=0; i<nsamples_dur; i++ )
-                    float_buf[i] = sin_lu_float(SINE_PHASE_TURNS);
-                } else {
-                for ( i=0; i<nsamples_dur; i++ )
-                    float_buf[i] = tone_mag * sinf(SINE_PHASE_RADIANS);
-                }
+    /* i counts from the start of the tone so the phase matches one big buffer */
+    for ( start=0; start<nsamples_dur; start+=chunk_frames )
+    {
+        size_t n = nsamples_dur - start < chunk_frames ? nsamples_dur - start : chunk_frames;
+
+        if ( tone_freq != 0 ) {
+            if ( sin_table_short ) {
+            for ( i=start; i<start+n; i++ )
+                tone_buf[i-start] = sin_lu_short(SINE_PHASE_TURNS);
+            } else {
+            for ( i=start; i<start+n; i++ )
+                tone_buf[i-start] = lroundf( mag_s * sinf(SINE_PHASE_RADIANS) );
             }
-            break;
-            */
+        } else {
+            bzero(tone_buf, n * framesize);
+        }
 
-            case SA_SAMPLE_FORMAT_S16:
-            {
-                short *short_buf = buf;
-                if ( sin_table_short ) {
-                for ( i=0; i<nsamples_dur; i++ )
-                    short_buf[i] = sin_lu_short(SINE_PHASE_TURNS);
-                } else {
-                unsigned short mag_s = 32767.0f * tone_mag + 0.5f;
-                if ( tone_mag > 1.0f ) // clamp to 1.0 to avoid overflow
-                    mag_s = 32767;
-                if ( mag_s < 1 ) // "short epsilon"
-                    mag_s = 1;
-                for ( i=0; i<nsamples_dur; i++ )
-                    short_buf[i] = lroundf( mag_s * sinf(SINE_PHASE_RADIANS) );
-                }
-                break;
-            }
+        int result = simpleaudio_write(sa_out, tone_buf, n);
+        if( result <= 0 )
+        {
+            jo_core_error("simpleaudio_write failed!! %d", result);
+            return;
+        }
+    }
 
-            default:
-                jo_core_error("Invalid format");
-                return;
-                break;
-            }
-            sa_tone_cphase = fmodf(sa_tone_cphase + (float)nsamples_dur/wave_nsamples, 1.0);
+    /*
+    * shaped tones carry their phase over the silence between blocks too,
+    * the step left there otherwise is the kind of click shaping avoids
+    */
+    if ( tone_freq != 0 )
+        sa_tone_cphase = fmodf(sa_tone_cphase + (float)nsamples_dur/wave_nsamples, 1.0);
+    else if ( sa_tone_shape_nsamples == 0 )
+        sa_tone_cphase = 0.0;
+}
 
-        } else {
+/*
+* sweeps from_freq to to_freq, the instantaneous frequency following half a
+* raised cosine. The phase is summed sample by sample so it carries on from
+* the last tone and into the next without a step
+*/
+static void
+simpleaudio_tone_ramp(simpleaudio *sa_out, float from_freq, float to_freq, size_t nsamples_dur)
+{
+    unsigned int framesize = simpleaudio_get_framesize(sa_out);
+    size_t chunk_frames = framesize ? TONE_CHUNK_BYTES / framesize : 0;
+    float rate = simpleaudio_get_rate(sa_out);
+    float turns = sa_tone_cphase;
+    unsigned short mag_s = 0;
+    size_t i;
 
-            bzero(buf, nsamples_dur * framesize);
-            sa_tone_cphase = 0.0;
+    if ( chunk_frames == 0 || nsamples_dur > chunk_frames )
+    {
+        jo_core_error("simpleaudio_tone: invalid ramp %d", nsamples_dur);
+        return;
+    }
 
-        }
+    if ( tone_mag_short(sa_out, &mag_s) != 0 )
+        return;
+
+    for ( i=0; i<nsamples_dur; i++ )
+    {
+        /* sin^2 is the raised cosine (1 - cos)/2 without a cosf */
+        float x = sinf((float)M_PI/2 * (i + 0.5f) / nsamples_dur);
+        float freq = from_freq + (to_freq - from_freq) * x * x;
+
+        if ( sin_table_short )
+            tone_buf[i] = sin_lu_short(turns);
+        else
+            tone_buf[i] = lroundf( mag_s * sinf(TURNS_TO_RADIANS(turns)) );
+
+        /* less than a turn a sample, and fmodf() won't take 0 */
+        turns += freq / rate;
+        if ( turns >= 1.0f )
+            turns -= 1.0f;
+    }
 
-    int result = simpleaudio_write(sa_out, buf, nsamples_dur);
+    int result = simpleaudio_write(sa_out, tone_buf, nsamples_dur);
     if( result <= 0 )
     {
         jo_core_error("simpleaudio_write failed!! %d", result);
-        jo_free(buf);
         return;
     }
 
-    jo_free(buf);
+    sa_tone_cphase = turns;
+}
+
+/* timed for the profiler overlay */
+void
+simpleaudio_tone(simpleaudio *sa_out, float tone_freq, size_t nsamples_dur)
+{
+    size_t ramp = 0;
+
+    profileBegin(PROFILE_STAGE_TONE);
+
+    /* only changes between two tones are shaped, not the edges of silence */
+    if ( sa_tone_shape_nsamples && tone_freq != 0 && sa_tone_last_freq != 0 && tone_freq != sa_tone_last_freq )
+        ramp = sa_tone_shape_nsamples < nsamples_dur ? sa_tone_shape_nsamples : nsamples_dur;
+
+    if ( sa_out->backend->simpleaudio_tone ) {
+        /*
+        * one step at the middle frequency stands in for the ramp, the SCSP
+        * keeps the phase across pitch changes and every step is a queue entry
+        */
+        if ( ramp )
+            sa_out->backend->simpleaudio_tone(sa_out, (sa_tone_last_freq + tone_freq) / 2, ramp);
+        if ( ramp == 0 || nsamples_dur > ramp )
+            sa_out->backend->simpleaudio_tone(sa_out, tone_freq, nsamples_dur - ramp);
+    } else {
+        if ( ramp )
+            simpleaudio_tone_ramp(sa_out, sa_tone_last_freq, tone_freq, ramp);
+        if ( ramp == 0 || nsamples_dur > ramp )
+            simpleaudio_tone_synth(sa_out, tone_freq, nsamples_dur - ramp);
+    }
+
+    sa_tone_last_freq = tone_freq;
+    profileEnd(PROFILE_STAGE_TONE);
 }
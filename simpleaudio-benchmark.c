@@ -0,0 +1,121 @@
+/*
+* simpleaudio-benchmark.c
+*
+* Copyright (C) 2011-2012 Kamal Mostafa <kamal@whence.com>
+*
+*  This program is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <jo/jo.h>
+#include "saturn-minimodem.h"
+
+#include "simpleaudio.h"
+#include "simpleaudio_internal.h"
+
+#if USE_BENCHMARKS
+
+/*
+ * benchmark backend, discards the audio so only the synthesis is timed
+ */
+
+static ssize_t
+sa_benchmark_read( simpleaudio *sa, void *buf, size_t nframes )
+{
+    UNUSED(sa);
+    UNUSED(buf);
+    UNUSED(nframes);
+
+    // reading not supported
+    return -1;
+}
+
+static ssize_t
+sa_benchmark_write( simpleaudio *sa, void *buf, size_t nframes )
+{
+    UNUSED(sa);
+    UNUSED(buf);
+
+    return nframes;
+}
+
+static int
+sa_benchmark_flush( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    return true;
+}
+
+static int
+sa_benchmark_is_flushed( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    return true;
+}
+
+static int
+sa_benchmark_is_busy( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    return false;
+}
+
+static void
+sa_benchmark_close( simpleaudio *sa )
+{
+    UNUSED(sa);
+}
+
+static int
+sa_benchmark_open_stream(
+        simpleaudio *sa,
+        const char *backend_device,
+        sa_direction_t sa_stream_direction,
+        sa_format_t sa_format,
+        unsigned int rate, unsigned int channels,
+        char *app_name, char *stream_name )
+{
+    UNUSED(backend_device);
+    UNUSED(sa_format);
+    UNUSED(rate);
+    UNUSED(channels);
+    UNUSED(app_name);
+    UNUSED(stream_name);
+
+    if(sa_stream_direction != SA_STREAM_PLAYBACK)
+    {
+        return 0;
+    }
+
+    sa->backend_handle = NULL;
+    sa->backend_framesize = sa->channels * sa->samplesize;
+
+    return 1;
+}
+
+const struct simpleaudio_backend simpleaudio_backend_benchmark = {
+    sa_benchmark_open_stream,
+    sa_benchmark_read,
+    sa_benchmark_write,
+    sa_benchmark_close,
+    sa_benchmark_flush,
+    sa_benchmark_is_flushed,
+    sa_benchmark_is_busy,
+    NULL,
+    NULL,
+};
+
+#endif
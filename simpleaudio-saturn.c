@@ -26,67 +26,86 @@
 
 #include "simpleaudio.h"
 #include "simpleaudio_internal.h"
+#include "arena.h"
+#include "util.h"
+#include "scsp.h"
 
 #define UNUSED(x) (void)(x)
-#define FLUSH_BUFFER_MIN 26000
-
-extern int g_isRunning;
-
-PCM g_PcmChannel = {(_Mono | _PCM16Bit),
-                0,
-                127,
-                0,
-                0x0,
-                0,
-                0,
-                0,
-                0 };
-
-// typedef struct
-// {
-//     Uint8	mode ;		/* Mode */
-//     Uint8	channel ;	/* PCM Channel Number */
-//     Uint8	level ;		/* 0 ~ 127 */
-//     Sint8	pan ;		/* -128 ~ +127 */
-//     Uint16	pitch ;
-//     Uint8	eflevelR ;	/* Effect level for Right(mono) 0 ~ 7 */
-//     Uint8	efselectR ;	/* Effect select for Right(mono) 0 ~ 15 */
-//     Uint8	eflevelL ;	/* Effect level for Left 0 ~ 7 */
-//     Uint8	efselectL ;	/* Effect select for Left 0 ~ 15 */
-// } PCM ;
-
-bool sa_saturn_flush_buffer();
-
-// copied from jo engine
-// I needed to modify this because Jo Engine does not let you adjust the channel frequency
-void jo_audio_play_sound_on_channel2(jo_sound * const sound, const unsigned char channel)
-{
-    int result = 0;
-
-#ifdef JO_DEBUG
-    if (sound == JO_NULL)
-    {
-        jo_core_error("sound is null");
-        return;
-    }
-    if (channel >= JO_SOUND_MAX_CHANNEL)
-    {
-        jo_core_error("channel (%d) is too high (max=%d)", channel, JO_SOUND_MAX_CHANNEL);
-        return;
-    }
-#endif
 
-    if (slPCMStat(&g_PcmChannel))
-        return;
-    //slSndFlush();
-    sound->current_playing_channel = channel;
-    //__jo_internal_pcm2[(int)channel].mode = (Uint8)sound->mode;
-    result = slPCMOn(&g_PcmChannel, sound->data, sound->data_length);
-    if(result < 0)
-    {
-        jo_core_error("slPCMon fail: %d", result);
-    }
-}
+/*
+ * Samples are written to a few staging segments in HWRAM. Each one that
+ * fills up is copied by SCU DMA into a ring in sound RAM that an SCSP slot
+ * loops over, a flush pads the block with silence to whole segments. The
+ * DMA end interrupt chains the copies and a vblank callback follows the
+ * slot around the ring, so the block drains while the rest of it is
+ * synthesized. Played segments are overwritten with silence.
+ */
+
+// SCSP slot that loops over the ring. Nothing else is played so SGL leaves it alone
+#define RING_SLOT                   31
+
+// SCU DMA level 2, levels 0 and 1 are left to SGL
+#define SCU_D2R                     (*(volatile unsigned int*)0x25FE0040) // read address
+#define SCU_D2W                     (*(volatile unsigned int*)0x25FE0044) // write address
+#define SCU_D2C                     (*(volatile unsigned int*)0x25FE0048) // byte count
+#define SCU_D2AD                    (*(volatile unsigned int*)0x25FE004C) // address add values
+#define SCU_D2EN                    (*(volatile unsigned int*)0x25FE0050)
+#define SCU_D2MD                    (*(volatile unsigned int*)0x25FE0054)
+
+#define SCU_DMA_MAX_BYTES           4096 // most levels 1 and 2 move at once
+#define SCU_DxAD_READ_ADD           0x100 // step the read address by 4, otherwise repeat the same word
+#define SCU_DxAD_WRITE_ADD_2        0x001 // sound RAM is on the 16-bit B-bus
+#define SCU_DxEN_ENABLE_GO          0x101
+#define SCU_DxMD_START_GO           0x007 // started by writing DxEN
+#define SCU_VECTOR_LEVEL2_DMA_END   0x49
+#define SCU_MASK_LEVEL2_DMA_END     (1 << 9)
+
+#define RING_SEGMENTS               4
+#define RING_SEGMENT_BYTES          0x4000 // ~186ms of 16-bit samples at 44.1KHz
+#define RING_SEGMENT_SAMPLES        (RING_SEGMENT_BYTES / 2)
+#define RING_BYTES                  (RING_SEGMENTS * RING_SEGMENT_BYTES)
+
+// staging segments in HWRAM, ~1.1s of samples. A byte, a sweep step or the
+// padding of a flush fills at most two, so writes stop while fewer than
+// STAGING_HEADROOM are free
+#define STAGING_SEGMENTS            6
+#define STAGING_HEADROOM            3
+
+#define SEGMENT_SILENT              0 // holds silence
+#define SEGMENT_STALE               1 // already played, waiting to be silenced
+#define SEGMENT_DATA                2 // holds samples that haven't been played
+
+// the copy the DMA is working through, a segment long
+typedef struct _RING_COPY
+{
+    const unsigned char* src;
+    unsigned char* dst;
+    unsigned int remaining;
+    bool silence; // src is a single zero word
+} RING_COPY, *PRING_COPY;
+
+static unsigned char* g_Staging = NULL; // HWRAM, SCU DMA reads straight from it
+static unsigned int g_StagingFill = 0; // segment sa_saturn_write() is filling
+static unsigned int g_StagingFillBytes = 0;
+static unsigned int g_StagingBlockBytes = 0; // written since the last flush
+static volatile unsigned int g_StagingDrain = 0; // oldest full segment
+static volatile unsigned int g_StagingFull = 0; // full segments waiting for or being copied into the ring
+static volatile bool g_StagingCopying = false; // g_Copy is reading g_StagingDrain
+static volatile bool g_StagingPrimed = false; // enough is staged to start the ring on, see stagingNextSegment()
+
+static unsigned char* g_Ring = NULL; // sound RAM
+static volatile unsigned char g_SegmentState[RING_SEGMENTS] = {0};
+static volatile unsigned int g_RingHead = 0; // segment the slot was last seen playing
+static volatile unsigned int g_RingLastData = 0; // most recently filled segment
+static volatile unsigned int g_RingDataSegments = 0;
+
+static volatile RING_COPY g_Copy = {0};
+static volatile bool g_DmaBusy = false;
+static const unsigned int g_Silence = 0;
+
+static bool g_SlotPlaying = false;
+static bool g_InterruptsInstalled = false;
+static unsigned short g_SlotPitch = 0;
 
 /*
 * Sega Saturn backend for simpleaudio
@@ -103,174 +122,358 @@ sa_saturn_read( simpleaudio *sa, void *buf, size_t nframes )
     return -1;
 }
 
-unsigned char* g_AudioBuffer = NULL;
-unsigned int g_AudioBufferSize = 0;
-unsigned int g_MaxAudioBufferSize = FLUSH_BUFFER_MIN * 6;
+// segment of the ring the slot is playing
+static unsigned int ringPlayingSegment(void)
+{
+    unsigned int ca = SCSP_MONITOR_CA(SCSP_MONITOR);
 
-unsigned int totalBytes = 0;
+    return (ca * SCSP_CA_SAMPLES / RING_SEGMENT_SAMPLES) % RING_SEGMENTS;
+}
 
-// plays whatever is in the audio buffer
-bool sa_saturn_flush_buffer()
+// marks the segments the slot has moved past as stale
+static void ringTrackHead(void)
 {
-    jo_sound sound = {0};
+    unsigned int head = 0;
 
-    if(sa_saturn_is_buffer_flushed())
+    if(g_SlotPlaying == false)
     {
-        return true;
+        return;
     }
 
-    if (slPCMStat(&g_PcmChannel))
+    head = ringPlayingSegment();
+    while(g_RingHead != head)
     {
-        g_isRunning = 1;
-        jo_core_error("Found channel in flush buffer");
-        return false;
+        if(g_SegmentState[g_RingHead] == SEGMENT_DATA)
+        {
+            g_SegmentState[g_RingHead] = SEGMENT_STALE;
+            g_RingDataSegments--;
+        }
+        g_RingHead = (g_RingHead + 1) % RING_SEGMENTS;
+    }
+}
+
+// picks the next segment to copy, samples first then silence
+// returns false if there is nothing to do
+static bool ringNextCopy(void)
+{
+    unsigned int segment = 0;
+
+    if(g_StagingFull != 0 && g_StagingPrimed)
+    {
+        // right after the queued samples, or after the playing segment if there are none
+        segment = (g_RingDataSegments ? g_RingLastData : g_RingHead) + 1;
+        segment %= RING_SEGMENTS;
+
+        if(segment != g_RingHead && g_SegmentState[segment] != SEGMENT_DATA)
+        {
+            g_Copy.src = g_Staging + g_StagingDrain * RING_SEGMENT_BYTES;
+            g_Copy.dst = g_Ring + segment * RING_SEGMENT_BYTES;
+            g_Copy.remaining = RING_SEGMENT_BYTES;
+            g_Copy.silence = false;
+            g_StagingCopying = true;
+
+            // the DMA is well ahead of the slot, count it as queued right away
+            g_SegmentState[segment] = SEGMENT_DATA;
+            g_RingLastData = segment;
+            g_RingDataSegments++;
+            return true;
+        }
+    }
+
+    for(segment = 0; segment < RING_SEGMENTS; segment++)
+    {
+        if(g_SegmentState[segment] == SEGMENT_STALE)
+        {
+            g_Copy.src = (const unsigned char*)&g_Silence;
+            g_Copy.dst = g_Ring + segment * RING_SEGMENT_BYTES;
+            g_Copy.remaining = RING_SEGMENT_BYTES;
+            g_Copy.silence = true;
+
+            g_SegmentState[segment] = SEGMENT_SILENT;
+            return true;
+        }
     }
 
-    if(g_AudioBufferSize < 20000)
+    return false;
+}
+
+// starts the next DMA if it is idle. Runs with interrupts masked or from an interrupt
+static void ringService(void)
+{
+    unsigned int count = 0;
+
+    if(g_Ring == NULL || g_DmaBusy)
     {
-        jo_printf(2, 23, "Small buffer size, possible error: %d                       ", g_AudioBufferSize);
+        return;
     }
 
-    if(g_AudioBufferSize < FLUSH_BUFFER_MIN)
+    ringTrackHead();
+
+    // the last staging segment is in the ring, it can be written again
+    if(g_Copy.remaining == 0 && g_StagingCopying)
     {
-        jo_memset(g_AudioBuffer + g_AudioBufferSize, 0, FLUSH_BUFFER_MIN - g_AudioBufferSize);
-        g_AudioBufferSize = FLUSH_BUFFER_MIN;
+        g_StagingCopying = false;
+        g_StagingDrain = (g_StagingDrain + 1) % STAGING_SEGMENTS;
+        g_StagingFull--;
+        g_StagingPrimed = g_StagingFull != 0;
     }
-    else
+
+    if(g_Copy.remaining == 0 && ringNextCopy() == false)
     {
-        //jo_core_error("Buffer is big enough what the heck %x %x", g_AudioBufferSize, FLUSH_BUFFER_MIN);
+        return;
     }
 
-    sound.current_playing_channel = 0;
-    sound.data = (char*)g_AudioBuffer;
-    sound.data_length = g_AudioBufferSize;
-    sound.mode = JoSoundMono16Bit;
+    count = g_Copy.remaining < SCU_DMA_MAX_BYTES ? g_Copy.remaining : SCU_DMA_MAX_BYTES;
 
-    jo_audio_play_sound_on_channel2(&sound, 0);
+    g_DmaBusy = true;
+    SCU_D2EN = 0;
+    SCU_D2R = (unsigned int)g_Copy.src;
+    SCU_D2W = (unsigned int)g_Copy.dst;
+    SCU_D2C = count;
+    SCU_D2AD = (g_Copy.silence ? 0 : SCU_DxAD_READ_ADD) | SCU_DxAD_WRITE_ADD_2;
+    SCU_D2MD = SCU_DxMD_START_GO;
+    SCU_D2EN = SCU_DxEN_ENABLE_GO;
 
-    g_AudioBufferSize = 0;
+    if(g_Copy.silence == false)
+    {
+        g_Copy.src += count;
+    }
+    g_Copy.dst += count;
+    g_Copy.remaining -= count;
+}
 
-    return true;
+static void scuDmaEndInterrupt(void)
+{
+    SCU_IST = ~SCU_MASK_LEVEL2_DMA_END;
+    g_DmaBusy = false;
+    ringService();
 }
 
-// returns true if the saturn's audio buffer's have been flushed
-bool sa_saturn_is_buffer_flushed()
+// keeps up with the slot while the CPU is busy synthesizing
+static void ringVblank(void)
 {
-    if(g_AudioBufferSize == 0)
-    {
-        return true;
-    }
+    ringService();
+}
 
-    return false;
+static void ringServiceMasked(void)
+{
+    unsigned int sr = disableInterrupts();
+    ringService();
+    restoreInterrupts(sr);
 }
 
-// buffers the audio to play on the Saturn
-// When sa_saturn_flush_buffer() is called, these buffer is sent to the audio system
-static ssize_t sa_saturn_write(simpleaudio *sa, void *buf, size_t nframes)
+// fills the ring with silence and starts the slot looping over it
+static int ringStart(void)
 {
-    size_t nbytes = nframes * sa->backend_framesize;
+    unsigned int offset = (unsigned int)g_Ring - SOUND_RAM;
+    unsigned int timeout = 0;
 
-    totalBytes += nbytes;
+    for(unsigned int i = 0; i < RING_SEGMENTS; i++)
+    {
+        g_SegmentState[i] = SEGMENT_STALE;
+    }
+    g_RingHead = 0;
+    g_RingLastData = 0;
+    g_RingDataSegments = 0;
 
-    if(g_AudioBuffer == NULL)
+    ringServiceMasked();
+    while(g_DmaBusy || g_Copy.remaining != 0)
     {
-        g_AudioBufferSize = nbytes;
-        g_AudioBuffer = jo_malloc(g_MaxAudioBufferSize);
-        if(g_AudioBuffer == NULL)
+        if(++timeout > 0x100000)
         {
-            jo_core_error("Failed to jo_malloc");
+            jo_core_error("Timed out clearing the sound ring!!");
             return -1;
         }
-        jo_memset(g_AudioBuffer, 0, g_MaxAudioBufferSize);
-        memcpy(g_AudioBuffer, buf, nbytes);
     }
-    else
+
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_CONTROL) = SCSP_LPCTL_NORMAL | ((offset >> 16) & 0x0F);
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_SA) = offset & 0xFFFF;
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_LSA) = 0;
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_LEA) = RING_BYTES / 2; // in samples
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_ENV1) = SCSP_AR_MAX;
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_ENV2) = SCSP_KRS_OFF_RR_MAX;
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_LEVEL) = 0; // full volume
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_MOD) = 0;
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_PITCH) = g_SlotPitch;
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_LFO) = 0;
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_INPUT) = 0;
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_OUTPUT) = SCSP_DISDL_MAX;
+
+    SCSP_MONITOR = SCSP_MONITOR_SLOT(RING_SLOT);
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_CONTROL) |= SCSP_KYONEX | SCSP_KYONB;
+    g_SlotPlaying = true;
+
+    return 0;
+}
+
+static void ringStop(void)
+{
+    unsigned int sr = 0;
+
+    SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_CONTROL) = (SCSP_SLOT_REG(RING_SLOT, SCSP_SLOT_CONTROL) & ~SCSP_KYONB) | SCSP_KYONEX;
+
+    sr = disableInterrupts();
+    g_SlotPlaying = false;
+
+    // drop the copy in flight, a stale end interrupt would start the next one
+    SCU_D2EN = 0;
+    SCU_IST = ~SCU_MASK_LEVEL2_DMA_END;
+    g_Copy.src = NULL;
+    g_Copy.dst = NULL;
+    g_Copy.remaining = 0;
+    g_Copy.silence = false;
+    g_DmaBusy = false;
+
+    g_StagingFill = 0;
+    g_StagingFillBytes = 0;
+    g_StagingBlockBytes = 0;
+    g_StagingDrain = 0;
+    g_StagingFull = 0;
+    g_StagingCopying = false;
+    g_StagingPrimed = false;
+    restoreInterrupts(sr);
+}
+
+// hands the full staging segment over to be copied into the ring and moves on to the next
+static int stagingNextSegment(void)
+{
+    unsigned int sr = disableInterrupts();
+
+    // the next segment has to be free as well
+    if(g_StagingFull + 2 > STAGING_SEGMENTS)
+    {
+        restoreInterrupts(sr);
+        jo_core_error("Audio staging buffer is full!!");
+        return -1;
+    }
+
+    // a block only starts into the ring once a few segments are ready, so
+    // synthesis has that long to keep ahead of the slot
+    g_StagingFull++;
+    g_StagingFill = (g_StagingFill + 1) % STAGING_SEGMENTS;
+    g_StagingFillBytes = 0;
+    if(g_StagingFull >= STAGING_HEADROOM)
     {
-        if(g_AudioBufferSize + nbytes > g_MaxAudioBufferSize)
+        g_StagingPrimed = true;
+    }
+    ringService();
+    restoreInterrupts(sr);
+
+    return 0;
+}
+
+// copies size bytes into the staging segments, zeros if data is NULL
+static int stagingWrite(const unsigned char* data, unsigned int size)
+{
+    while(size > 0)
+    {
+        unsigned int count = RING_SEGMENT_BYTES - g_StagingFillBytes;
+        unsigned char* dst = g_Staging + g_StagingFill * RING_SEGMENT_BYTES + g_StagingFillBytes;
+
+        count = size < count ? size : count;
+        if(data != NULL)
         {
-            jo_core_error("Out of memory!! %d %d", g_MaxAudioBufferSize + nbytes, g_MaxAudioBufferSize);
-            return -1;
+            memcpy(dst, data, count);
+            data += count;
+        }
+        else
+        {
+            jo_memset(dst, 0, count);
         }
 
-        //g_AudioBuffer = my_realloc(g_AudioBuffer, g_AudioBufferSize, g_AudioBufferSize + nbytes);
-        if(g_AudioBuffer == NULL)
+        g_StagingFillBytes += count;
+        g_StagingBlockBytes += count;
+        size -= count;
+
+        if(g_StagingFillBytes == RING_SEGMENT_BYTES && stagingNextSegment() != 0)
         {
-            jo_core_error("Failed to realloc");
             return -1;
         }
+    }
+
+    return 0;
+}
+
+// pads the block with silence to whole segments so the last of it goes to the ring
+static int sa_saturn_flush(simpleaudio *sa)
+{
+    unsigned int pad = 0;
+    unsigned int sr = 0;
 
-        // BUGBUG: remove this
-        memcpy(g_AudioBuffer + g_AudioBufferSize, buf, nbytes);
-        g_AudioBufferSize = g_AudioBufferSize + nbytes;
+    UNUSED(sa);
+
+    if(g_StagingBlockBytes == 0)
+    {
+        return true;
     }
 
-    if (slPCMStat(&g_PcmChannel))
+    pad = g_StagingBlockBytes < FLUSH_BUFFER_MIN ? FLUSH_BUFFER_MIN - g_StagingBlockBytes : 0;
+    pad += (RING_SEGMENT_BYTES - (g_StagingFillBytes + pad) % RING_SEGMENT_BYTES) % RING_SEGMENT_BYTES;
+
+    if(stagingWrite(NULL, pad) != 0)
     {
-        g_isRunning = 1;
-        //jo_core_error("Found channel");
-        return 1;
+        return false;
     }
 
-    if(g_AudioBufferSize < FLUSH_BUFFER_MIN)
+    // the whole block is staged, no need to wait for more
+    sr = disableInterrupts();
+    g_StagingPrimed = g_StagingFull != 0;
+    ringService();
+    restoreInterrupts(sr);
+
+    g_StagingBlockBytes = 0;
+    return true;
+}
+
+// returns true once everything flushed has been played
+static int sa_saturn_is_flushed(simpleaudio *sa)
+{
+    UNUSED(sa);
+
+    ringServiceMasked();
+
+    return g_StagingFillBytes == 0 && g_StagingFull == 0 && g_RingDataSegments == 0;
+}
+
+// returns true while too few staging segments are free for the next write
+static int sa_saturn_is_busy(simpleaudio *sa)
+{
+    UNUSED(sa);
+
+    ringServiceMasked();
+
+    return STAGING_SEGMENTS - 1 - g_StagingFull < STAGING_HEADROOM;
+}
+
+// buffers the audio to play on the Saturn
+// Each staging segment is copied into the ring once it is full
+static ssize_t sa_saturn_write(simpleaudio *sa, void *buf, size_t nframes)
+{
+    if(stagingWrite(buf, nframes * sa->backend_framesize) != 0)
     {
-        return nframes;
+        return -1;
     }
 
     return nframes;
 }
 
+// drops the staged blocks and whatever is left in the ring
 static void
-sa_saturn_close( simpleaudio *sa )
+sa_saturn_stop( simpleaudio *sa )
 {
     UNUSED(sa);
 
-    // do I need to do anything here??
-    return;
+    ringStop();
+    ringStart();
 }
 
-// macros taken from https://github.com/ponut64/68k
-static const int logtbl[] = {
-/* 0 */		0,
-/* 1 */		1,
-/* 2 */		2, 2,
-/* 4 */		3, 3, 3, 3,
-/* 8 */		4, 4, 4, 4, 4, 4, 4, 4,
-/* 16 */	5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
-/* 32 */	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
-            6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
-/* 64 */	7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
-            7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
-            7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
-            7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
-/* 128 */	8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
-            8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
-            8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
-            8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
-            8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
-            8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
-            8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
-            8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8
-    };
-
-#define PCM_MSK1(a)				((a)&0x0001)
-#define PCM_MSK3(a)				((a)&0x0007)
-#define PCM_MSK4(a)				((a)&0x000F)
-#define PCM_MSK5(a)				((a)&0x001F)
-#define PCM_MSK10(a)			((a)&0x03FF)
-
-#define PCM_SCSP_FREQUENCY					(44100L)
-
-#define PCM_CALC_OCT(smpling_rate) 											\
-        ((int)logtbl[PCM_SCSP_FREQUENCY / ((smpling_rate) + 1)])
-
-#define PCM_CALC_SHIFT_FREQ(oct)											\
-        (PCM_SCSP_FREQUENCY >> (oct))
-
-#define PCM_CALC_FNS(smpling_rate, shift_freq)								\
-        ((((smpling_rate) - (shift_freq)) << 10) / (shift_freq))
-
-#define PCM_SET_PITCH_WORD(oct, fns)										\
-        ((int)((PCM_MSK4(-(oct)) << 11) | PCM_MSK10(fns)))
+static void
+sa_saturn_close( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    ringStop();
+}
 
 static int
 sa_saturn_open_stream(
@@ -300,16 +503,48 @@ sa_saturn_open_stream(
     sa->backend_handle = NULL;
     sa->backend_framesize = sa->channels * sa->samplesize;
 
-    // based on these values configure the PCM channel
-    int octr;
-    int shiftr;
-    int fnsr;
+    g_SlotPitch = scspPitchWord(sa->rate);
 
-    octr = PCM_CALC_OCT(sa->rate);
-    shiftr = PCM_CALC_SHIFT_FREQ(octr);
-    fnsr = PCM_CALC_FNS(sa->rate, shiftr);
+    // kept across close and open, the ring is never freed
+    if(g_Ring == NULL)
+    {
+        g_Ring = regionAlloc(MEMORY_REGION_SOUND, RING_BYTES);
+        if(g_Ring == NULL || (unsigned int)g_Ring < SOUND_RAM || (unsigned int)g_Ring >= SOUND_RAM + SOUND_RAM_SIZE)
+        {
+            jo_core_error("Failed to allocate the sound ring!!");
+            g_Ring = NULL;
+            return 0;
+        }
+    }
 
-    g_PcmChannel.pitch = PCM_SET_PITCH_WORD(octr, fnsr);
+    // staging segments the samples are DMAed from, keep them in HWRAM
+    if(g_Staging == NULL)
+    {
+        g_Staging = regionAlloc(MEMORY_REGION_HOT, STAGING_SEGMENTS * RING_SEGMENT_BYTES);
+        if(g_Staging == NULL)
+        {
+            jo_core_error("Failed to allocate the audio staging buffer!!");
+            return 0;
+        }
+    }
+
+    if(g_InterruptsInstalled == false)
+    {
+        BIOS_SET_SCU_INTERRUPT(SCU_VECTOR_LEVEL2_DMA_END, scuDmaEndInterrupt);
+        BIOS_CHANGE_SCU_MASK(~SCU_MASK_LEVEL2_DMA_END, 0);
+
+        if(jo_core_add_vblank_callback(ringVblank) < 0)
+        {
+            jo_core_error("Failed to add sound ring vblank callback!!");
+            return 0;
+        }
+        g_InterruptsInstalled = true;
+    }
+
+    if(ringStart() != 0)
+    {
+        return 0;
+    }
 
     return 1;
 }
@@ -319,4 +554,9 @@ const struct simpleaudio_backend simpleaudio_backend_segasaturn = {
     sa_saturn_read,
     sa_saturn_write,
     sa_saturn_close,
+    sa_saturn_flush,
+    sa_saturn_is_flushed,
+    sa_saturn_is_busy,
+    NULL,
+    sa_saturn_stop,
 };
@@ -0,0 +1,320 @@
+/*
+* simpleaudio-saturn68k.c
+*
+* Sega Saturn backend for simpleaudio that hands the tones to a driver on
+* the 68000 sound CPU instead of synthesizing samples. The driver, built
+* from m68k/driver.s, loops a single cycle sine on one SCSP slot and
+* changes its pitch at each symbol boundary.
+*
+*  This program is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <jo/jo.h>
+#include "saturn-minimodem.h"
+
+#include "simpleaudio.h"
+#include "simpleaudio_internal.h"
+#include "util.h"
+#include "scsp.h"
+
+#define DRIVER_FILENAME             "SND68K.BIN"
+#define DRIVER_MAGIC                0x5347 // "SG", written by the driver once it runs
+#define DRIVER_START_TIMEOUT        0x100000
+#define DRIVER_QUEUE_TIMEOUT        0x100000 // far longer than the 255 samples an entry plays for
+
+// sound RAM layout, must match m68k/driver.s
+#define DRIVER_MAX_BYTES            0x1000 // code and stack
+#define SHARED                      ((volatile unsigned short*)(SOUND_RAM + 0x1000))
+#define SHARED_MAGIC                0
+#define SHARED_HEAD                 1 // written by the SH-2
+#define SHARED_TAIL                 2 // written by the driver
+#define SHARED_SLOT                 3
+#define SHARED_SINE                 4
+#define SHARED_SINE_LEN             5
+#define QUEUE                       ((volatile unsigned short*)(SOUND_RAM + 0x1010))
+#define QUEUE_ENTRIES               4096
+#define SINE_OFFSET                 0x5100
+
+// a block of 128 bytes with its leader and sync bytes takes ~1300 entries,
+// ~1900 with shaped transitions. Only report busy when the next one might not fit
+#define QUEUE_BLOCK_ENTRIES         (QUEUE_ENTRIES / 2)
+
+#define DRIVER_SLOT                 30
+
+static bool g_DriverRunning = false;
+
+static ssize_t
+sa_saturn68k_read( simpleaudio *sa, void *buf, size_t nframes )
+{
+    UNUSED(sa);
+    UNUSED(buf);
+    UNUSED(nframes);
+
+    // reading not supported
+    return -1;
+}
+
+// the driver makes the samples, see sa_saturn68k_tone()
+static ssize_t
+sa_saturn68k_write( simpleaudio *sa, void *buf, size_t nframes )
+{
+    UNUSED(sa);
+    UNUSED(buf);
+    UNUSED(nframes);
+
+    jo_core_error("The 68000 driver only takes tones!!");
+    return -1;
+}
+
+static unsigned int queueUsed(void)
+{
+    return (SHARED[SHARED_HEAD] - SHARED[SHARED_TAIL]) & (QUEUE_ENTRIES - 1);
+}
+
+// one slot is left empty so a full queue isn't mistaken for an empty one
+static int queuePush(unsigned short pitch, unsigned short duration)
+{
+    unsigned int head = SHARED[SHARED_HEAD];
+    unsigned int timeout = 0;
+
+    if(g_DriverRunning == false)
+    {
+        return -1;
+    }
+
+    // the driver drains at the symbol rate, wait for it
+    while(queueUsed() >= QUEUE_ENTRIES - 1)
+    {
+        if(++timeout > DRIVER_QUEUE_TIMEOUT)
+        {
+            // stop it so the next tone fails straight away, opening the stream loads it again
+            jo_core_error("68000 driver stopped playing!!");
+            scspSoundCpuOff();
+            SCSP_SLOT_REG(DRIVER_SLOT, SCSP_SLOT_CONTROL) =
+                (SCSP_SLOT_REG(DRIVER_SLOT, SCSP_SLOT_CONTROL) & ~SCSP_KYONB) | SCSP_KYONEX;
+            g_DriverRunning = false;
+            return -1;
+        }
+    }
+
+    QUEUE[head * 2] = pitch;
+    QUEUE[head * 2 + 1] = duration;
+    SHARED[SHARED_HEAD] = (head + 1) & (QUEUE_ENTRIES - 1);
+
+    return 0;
+}
+
+// queues the tone as a pitch for the sine and a duration in SCSP samples
+static int
+sa_saturn68k_tone( simpleaudio *sa, float tone_freq, size_t nsamples_dur )
+{
+    unsigned short pitch = scspSinePitch(tone_freq);
+    unsigned int duration = scspSamples(nsamples_dur, sa->rate); // the driver counts at the SCSP's rate
+
+    // already reported by queuePush()
+    if(g_DriverRunning == false)
+    {
+        return false;
+    }
+
+    while(duration > 0)
+    {
+        unsigned int count = duration < SCSP_MAX_TIMER_SAMPLES ? duration : SCSP_MAX_TIMER_SAMPLES;
+
+        if(queuePush(pitch, count) != 0)
+        {
+            jo_core_error("Failed to queue tone!!");
+            return false;
+        }
+        duration -= count;
+    }
+
+    return true;
+}
+
+// tones are played as soon as they are queued
+static int
+sa_saturn68k_flush( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    return true;
+}
+
+// returns true once the driver has played everything queued
+// The driver only moves the tail past an entry once its timer has run out,
+// so the last entry has finished when the tail reaches the head
+static int
+sa_saturn68k_is_flushed( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    // a stopped driver won't play the rest
+    return g_DriverRunning == false || queueUsed() == 0;
+}
+
+// returns true until there is room for another block
+static int
+sa_saturn68k_is_busy( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    return g_DriverRunning && queueUsed() > QUEUE_ENTRIES - QUEUE_BLOCK_ENTRIES;
+}
+
+static void
+sa_saturn68k_close( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    if(g_DriverRunning == false)
+    {
+        return;
+    }
+
+    scspSoundCpuOff();
+    SCSP_SLOT_REG(DRIVER_SLOT, SCSP_SLOT_CONTROL) =
+        (SCSP_SLOT_REG(DRIVER_SLOT, SCSP_SLOT_CONTROL) & ~SCSP_KYONB) | SCSP_KYONEX;
+
+    g_DriverRunning = false;
+}
+
+// resets the 68000 into the driver in sound RAM with an empty queue
+static int startDriver(void)
+{
+    unsigned int timeout = 0;
+
+    SHARED[SHARED_MAGIC] = 0;
+    SHARED[SHARED_HEAD] = 0;
+    SHARED[SHARED_TAIL] = 0;
+    SHARED[SHARED_SLOT] = DRIVER_SLOT;
+    SHARED[SHARED_SINE] = SINE_OFFSET;
+    SHARED[SHARED_SINE_LEN] = SCSP_SINE_SAMPLES;
+
+    scspSoundCpuOn();
+
+    while(SHARED[SHARED_MAGIC] != DRIVER_MAGIC)
+    {
+        if(++timeout > DRIVER_START_TIMEOUT)
+        {
+            jo_core_error("68000 driver did not start!!");
+            scspSoundCpuOff();
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// replaces SGL's sound driver with ours. SGL's sound functions can't be used afterwards
+static int loadDriver(void)
+{
+    unsigned char* driver = NULL;
+    volatile unsigned short* soundRam = (volatile unsigned short*)SOUND_RAM;
+    volatile unsigned short* sine = (volatile unsigned short*)(SOUND_RAM + SINE_OFFSET);
+    int size = 0;
+
+    driver = (unsigned char*)jo_fs_read_file(DRIVER_FILENAME, &size);
+    if(driver == NULL)
+    {
+        // not built, see the makefile
+        return -1;
+    }
+
+    if(size <= 0 || size > DRIVER_MAX_BYTES)
+    {
+        jo_core_error("Invalid 68000 driver size %d!!", size);
+        jo_free(driver);
+        return -1;
+    }
+
+    scspSoundCpuOff();
+
+    // sound RAM only takes 16-bit writes
+    for(int i = 0; i < size; i += 2)
+    {
+        soundRam[i / 2] = (driver[i] << 8) | (i + 1 < size ? driver[i + 1] : 0);
+    }
+    jo_free(driver);
+
+    scspWriteSine(sine);
+
+    return startDriver();
+}
+
+// the driver only ever moves the tail forward, so the queue is emptied by
+// stopping the 68000 and starting it over
+static void
+sa_saturn68k_stop( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    if(g_DriverRunning == false)
+    {
+        return;
+    }
+
+    scspSoundCpuOff();
+    SCSP_SLOT_REG(DRIVER_SLOT, SCSP_SLOT_CONTROL) =
+        (SCSP_SLOT_REG(DRIVER_SLOT, SCSP_SLOT_CONTROL) & ~SCSP_KYONB) | SCSP_KYONEX;
+
+    if(startDriver() != 0)
+    {
+        g_DriverRunning = false;
+    }
+}
+
+static int
+sa_saturn68k_open_stream(
+        simpleaudio *sa,
+        const char *backend_device,
+        sa_direction_t sa_stream_direction,
+        sa_format_t sa_format,
+        unsigned int rate, unsigned int channels,
+        char *app_name, char *stream_name )
+{
+    UNUSED(backend_device);
+    UNUSED(sa_stream_direction);
+    UNUSED(sa_format);
+    UNUSED(rate);
+    UNUSED(channels);
+    UNUSED(app_name);
+    UNUSED(stream_name);
+
+    sa->backend_handle = NULL;
+    sa->backend_framesize = sa->channels * sa->samplesize;
+
+    if(g_DriverRunning == false)
+    {
+        if(loadDriver() != 0)
+        {
+            return 0;
+        }
+        g_DriverRunning = true;
+    }
+
+    return 1;
+}
+
+const struct simpleaudio_backend simpleaudio_backend_segasaturn68k = {
+    sa_saturn68k_open_stream,
+    sa_saturn68k_read,
+    sa_saturn68k_write,
+    sa_saturn68k_close,
+    sa_saturn68k_flush,
+    sa_saturn68k_is_flushed,
+    sa_saturn68k_is_busy,
+    sa_saturn68k_tone,
+    sa_saturn68k_stop,
+};
@@ -0,0 +1,400 @@
+/*
+* simpleaudio-saturnpitch.c
+*
+* Sega Saturn backend for simpleaudio that makes FSK in hardware from the
+* SH-2. One SCSP slot loops a single cycle sine and only its pitch is
+* changed at each symbol boundary. SCSP timer A interrupts the SH-2 through
+* the SCU at the end of each symbol, so no samples are generated and the
+* 68000 isn't needed.
+*
+* The timer has to be reloaded from the interrupt, so each symbol edge lands
+* as late as the interrupt ran. The FRT measures how late that was and it is
+* taken off the next symbol, which keeps the lateness from adding up.
+*
+*  This program is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <jo/jo.h>
+#include "saturn-minimodem.h"
+
+#include "simpleaudio.h"
+#include "simpleaudio_internal.h"
+#include "arena.h"
+#include "profile.h"
+#include "util.h"
+#include "scsp.h"
+
+#define PITCH_SLOT                  29
+
+// pitch word in the upper half, duration in samples in the lower
+#define QUEUE_ENTRIES               4096
+#define QUEUE_ENTRY(pitch, samples) (((unsigned int)(pitch) << 16) | (samples))
+#define QUEUE_PITCH(entry)          ((entry) >> 16)
+#define QUEUE_SAMPLES(entry)        ((entry) & 0xFFFF)
+
+// a block of 128 bytes with its leader and sync bytes takes ~1300 entries,
+// ~1900 with shaped transitions. Only report busy when the next one might not fit
+#define QUEUE_BLOCK_ENTRIES         (QUEUE_ENTRIES / 2)
+
+// timer A periods the FRT is measured over on open, ~23ms
+#define CALIBRATE_PERIODS           4
+#define CALIBRATE_SAMPLES           (CALIBRATE_PERIODS * SCSP_MAX_TIMER_SAMPLES)
+
+static unsigned int g_Queue[QUEUE_ENTRIES];
+static volatile unsigned int g_QueueHead = 0; // written by the tone hook
+static volatile unsigned int g_QueueTail = 0; // entry playing, advanced by the interrupt
+static volatile bool g_Idle = true; // nothing playing, the next entry starts the timer
+
+static unsigned int g_CalibrateTicks = 0; // FRT ticks per CALIBRATE_SAMPLES SCSP samples
+static volatile unsigned int g_LoadTicks = 0; // profileTicks() when the timer was last loaded
+static volatile unsigned int g_LoadSamples = 0; // samples it was loaded with
+static volatile unsigned int g_CarrySamples = 0; // lateness an entry was too short to absorb
+
+static volatile unsigned short* g_Sine = NULL; // sound RAM
+static bool g_Open = false;
+
+static ssize_t
+sa_saturnpitch_read( simpleaudio *sa, void *buf, size_t nframes )
+{
+    UNUSED(sa);
+    UNUSED(buf);
+    UNUSED(nframes);
+
+    // reading not supported
+    return -1;
+}
+
+// the SCSP makes the samples, see sa_saturnpitch_tone()
+static ssize_t
+sa_saturnpitch_write( simpleaudio *sa, void *buf, size_t nframes )
+{
+    UNUSED(sa);
+    UNUSED(buf);
+    UNUSED(nframes);
+
+    jo_core_error("The pitch backend only takes tones!!");
+    return -1;
+}
+
+static unsigned int queueUsed(void)
+{
+    return (g_QueueHead - g_QueueTail) & (QUEUE_ENTRIES - 1);
+}
+
+// starts the entry at the tail, shortened by however late the last one
+// was noticed so the edges after it are back on time
+static void startEntry(void)
+{
+    unsigned int entry = g_Queue[g_QueueTail];
+    unsigned short pitch = QUEUE_PITCH(entry);
+    unsigned int samples = QUEUE_SAMPLES(entry);
+    unsigned int now = profileTicks();
+    unsigned int expected = g_LoadSamples * g_CalibrateTicks / CALIBRATE_SAMPLES;
+    unsigned int elapsed = now - g_LoadTicks;
+    unsigned int late = g_CarrySamples;
+
+    if(elapsed > expected)
+    {
+        late += (elapsed - expected) * CALIBRATE_SAMPLES / g_CalibrateTicks;
+    }
+
+    // whatever doesn't fit is taken off the entries after this one
+    g_CarrySamples = late < samples ? 0 : late - (samples - 1);
+    samples -= late < samples ? late : samples - 1;
+
+    SCSP_TIMER_A = 256 - samples;
+    SCSP_MCIRE = SCSP_INT_TIMER_A;
+    g_LoadTicks = now;
+    g_LoadSamples = samples;
+
+    if(pitch & SCSP_PITCH_SILENCE)
+    {
+        SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_LEVEL) = SCSP_TL_MUTE;
+    }
+    else
+    {
+        SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_PITCH) = pitch;
+        SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_LEVEL) = 0;
+    }
+}
+
+// timer A overflowed, the entry at the tail has finished
+static void timerInterrupt(void)
+{
+    if(g_Idle)
+    {
+        return;
+    }
+
+    g_QueueTail = (g_QueueTail + 1) & (QUEUE_ENTRIES - 1);
+
+    if(g_QueueTail == g_QueueHead)
+    {
+        // ran dry, mute until more is queued
+        SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_LEVEL) = SCSP_TL_MUTE;
+        g_Idle = true;
+        return;
+    }
+
+    startEntry();
+}
+
+// times timer A against the FRT, their clocks come from different crystals.
+// Polled with interrupts masked so the reloads aren't late
+static int calibrateTimer(void)
+{
+    unsigned int sr = disableInterrupts();
+    unsigned short enabled = SCSP_MCIEB;
+    unsigned int start = 0;
+    unsigned int timeout = 0;
+    int result = 0;
+
+    SCSP_MCIEB = enabled | SCSP_INT_TIMER_A;
+    SCSP_TIMER_A = 256 - SCSP_MAX_TIMER_SAMPLES;
+    SCSP_MCIRE = SCSP_INT_TIMER_A;
+    start = profileTicks();
+
+    for(unsigned int i = 0; i < CALIBRATE_PERIODS && result == 0; i++)
+    {
+        while((SCSP_MCIPD & SCSP_INT_TIMER_A) == 0)
+        {
+            if(++timeout > 0x100000)
+            {
+                result = -1;
+                break;
+            }
+        }
+
+        SCSP_TIMER_A = 256 - SCSP_MAX_TIMER_SAMPLES;
+        SCSP_MCIRE = SCSP_INT_TIMER_A;
+    }
+
+    g_CalibrateTicks = profileTicks() - start;
+    SCSP_MCIRE = SCSP_INT_TIMER_A;
+    SCSP_MCIEB = enabled;
+    restoreInterrupts(sr);
+
+    if(result != 0 || g_CalibrateTicks == 0)
+    {
+        g_CalibrateTicks = 0;
+        jo_core_error("SCSP timer A isn't counting!!");
+        return -1;
+    }
+
+    return 0;
+}
+
+// one slot is left empty so a full queue isn't mistaken for an empty one
+static int queuePush(unsigned short pitch, unsigned short samples)
+{
+    unsigned int sr = 0;
+
+    // the interrupt drains at the symbol rate, wait for it
+    while(queueUsed() >= QUEUE_ENTRIES - 1)
+    {
+        if(g_Open == false)
+        {
+            return -1;
+        }
+    }
+
+    sr = disableInterrupts();
+    g_Queue[g_QueueHead] = QUEUE_ENTRY(pitch, samples);
+    g_QueueHead = (g_QueueHead + 1) & (QUEUE_ENTRIES - 1);
+
+    if(g_Idle)
+    {
+        g_Idle = false;
+        g_LoadTicks = profileTicks();
+        g_LoadSamples = 0;
+        g_CarrySamples = 0;
+        startEntry();
+    }
+    restoreInterrupts(sr);
+
+    return 0;
+}
+
+// queues the tone as a pitch for the sine and a duration in SCSP samples
+static int
+sa_saturnpitch_tone( simpleaudio *sa, float tone_freq, size_t nsamples_dur )
+{
+    unsigned short pitch = scspSinePitch(tone_freq);
+    unsigned int duration = scspSamples(nsamples_dur, sa->rate); // the timer counts at the SCSP's rate
+
+    while(duration > 0)
+    {
+        unsigned int count = duration < SCSP_MAX_TIMER_SAMPLES ? duration : SCSP_MAX_TIMER_SAMPLES;
+
+        if(queuePush(pitch, count) != 0)
+        {
+            jo_core_error("Failed to queue tone!!");
+            return false;
+        }
+        duration -= count;
+    }
+
+    return true;
+}
+
+// tones are played as soon as they are queued
+static int
+sa_saturnpitch_flush( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    return true;
+}
+
+// returns true once everything queued has been played
+static int
+sa_saturnpitch_is_flushed( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    return g_Idle;
+}
+
+// returns true until there is room for another block
+static int
+sa_saturnpitch_is_busy( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    return queueUsed() > QUEUE_ENTRIES - QUEUE_BLOCK_ENTRIES;
+}
+
+// empties the queue and mutes the slot, the timer stays installed for the next tone
+static void
+sa_saturnpitch_stop( simpleaudio *sa )
+{
+    unsigned int sr = 0;
+
+    UNUSED(sa);
+
+    sr = disableInterrupts();
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_LEVEL) = SCSP_TL_MUTE;
+    g_QueueHead = 0;
+    g_QueueTail = 0;
+    g_Idle = true;
+    restoreInterrupts(sr);
+}
+
+static void
+sa_saturnpitch_close( simpleaudio *sa )
+{
+    unsigned int sr = 0;
+
+    UNUSED(sa);
+
+    if(g_Open == false)
+    {
+        return;
+    }
+
+    scspSetInterruptHandler(SCSP_INT_TIMER_A, NULL);
+
+    sr = disableInterrupts();
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_CONTROL) =
+        (SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_CONTROL) & ~SCSP_KYONB) | SCSP_KYONEX;
+    g_QueueHead = 0;
+    g_QueueTail = 0;
+    g_Idle = true;
+    g_Open = false;
+    restoreInterrupts(sr);
+}
+
+static int
+sa_saturnpitch_open_stream(
+        simpleaudio *sa,
+        const char *backend_device,
+        sa_direction_t sa_stream_direction,
+        sa_format_t sa_format,
+        unsigned int rate, unsigned int channels,
+        char *app_name, char *stream_name )
+{
+    unsigned int offset = 0;
+
+    UNUSED(backend_device);
+    UNUSED(sa_stream_direction);
+    UNUSED(sa_format);
+    UNUSED(rate);
+    UNUSED(channels);
+    UNUSED(app_name);
+    UNUSED(stream_name);
+
+    sa->backend_handle = NULL;
+    sa->backend_framesize = sa->channels * sa->samplesize;
+
+    // kept across close and open, it is never freed
+    if(g_Sine == NULL)
+    {
+        g_Sine = regionAlloc(MEMORY_REGION_SOUND, SCSP_SINE_SAMPLES * sizeof(short));
+        if(g_Sine == NULL || (unsigned int)g_Sine < SOUND_RAM || (unsigned int)g_Sine >= SOUND_RAM + SOUND_RAM_SIZE)
+        {
+            jo_core_error("Failed to allocate the sine in sound RAM!!");
+            g_Sine = NULL;
+            return 0;
+        }
+        scspWriteSine(g_Sine);
+    }
+
+    // the 68000 could be using timer A too
+    scspSoundCpuOff();
+
+    if(g_CalibrateTicks == 0 && calibrateTimer() != 0)
+    {
+        return 0;
+    }
+
+    // loop over the sine, muted until the first tone
+    offset = (unsigned int)g_Sine - SOUND_RAM;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_CONTROL) = SCSP_KYONEX | SCSP_LPCTL_NORMAL | ((offset >> 16) & 0x0F);
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_SA) = offset & 0xFFFF;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_LSA) = 0;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_LEA) = SCSP_SINE_SAMPLES;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_ENV1) = SCSP_AR_MAX;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_ENV2) = SCSP_KRS_OFF_RR_MAX;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_LEVEL) = SCSP_TL_MUTE;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_MOD) = 0;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_PITCH) = 0;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_LFO) = 0;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_INPUT) = 0;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_OUTPUT) = SCSP_DISDL_MAX;
+    SCSP_SLOT_REG(PITCH_SLOT, SCSP_SLOT_CONTROL) |= SCSP_KYONEX | SCSP_KYONB;
+
+    g_QueueHead = 0;
+    g_QueueTail = 0;
+    g_Idle = true;
+
+    if(scspSetInterruptHandler(SCSP_INT_TIMER_A, timerInterrupt) != 0)
+    {
+        return 0;
+    }
+    g_Open = true;
+
+    return 1;
+}
+
+const struct simpleaudio_backend simpleaudio_backend_segasaturnpitch = {
+    sa_saturnpitch_open_stream,
+    sa_saturnpitch_read,
+    sa_saturnpitch_write,
+    sa_saturnpitch_close,
+    sa_saturnpitch_flush,
+    sa_saturnpitch_is_flushed,
+    sa_saturnpitch_is_busy,
+    sa_saturnpitch_tone,
+    sa_saturnpitch_stop,
+};
@@ -0,0 +1,262 @@
+/*
+* simpleaudio-wav.c
+*
+* .wav file backend for simpleaudio. Used by the host build to capture the
+* exact audio the Saturn backend would play.
+*
+*  This program is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <jo/jo.h>
+#include <stdio.h>
+#include "saturn-minimodem.h"
+
+#include "simpleaudio.h"
+#include "simpleaudio_internal.h"
+
+#define WAV_HEADER_SIZE 44
+
+typedef struct _WAV_STREAM
+{
+    FILE* file;
+    unsigned int dataBytes; // bytes of sample data written so far
+    unsigned int pendingBytes; // bytes written since the last flush
+} WAV_STREAM, *PWAV_STREAM;
+
+// .wav files are little endian regardless of the host
+static void put_le16(unsigned char* dst, unsigned int value)
+{
+    dst[0] = value & 0xFF;
+    dst[1] = (value >> 8) & 0xFF;
+}
+
+static void put_le32(unsigned char* dst, unsigned int value)
+{
+    dst[0] = value & 0xFF;
+    dst[1] = (value >> 8) & 0xFF;
+    dst[2] = (value >> 16) & 0xFF;
+    dst[3] = (value >> 24) & 0xFF;
+}
+
+// writes the RIFF header. Called with 0 on open and again on close with the final size
+static int sa_wav_write_header(simpleaudio *sa, PWAV_STREAM stream)
+{
+    unsigned char header[WAV_HEADER_SIZE] = {0};
+    unsigned int byteRate = sa->rate * sa->backend_framesize;
+
+    memcpy(header, "RIFF", 4);
+    put_le32(header + 4, 36 + stream->dataBytes);
+    memcpy(header + 8, "WAVE", 4);
+
+    memcpy(header + 12, "fmt ", 4);
+    put_le32(header + 16, 16); // PCM fmt chunk size
+    put_le16(header + 20, 1); // PCM
+    put_le16(header + 22, sa->channels);
+    put_le32(header + 24, sa->rate);
+    put_le32(header + 28, byteRate);
+    put_le16(header + 32, sa->backend_framesize);
+    put_le16(header + 34, sa->samplesize * 8);
+
+    memcpy(header + 36, "data", 4);
+    put_le32(header + 40, stream->dataBytes);
+
+    if(fseek(stream->file, 0, SEEK_SET) != 0)
+    {
+        return -1;
+    }
+
+    if(fwrite(header, 1, sizeof(header), stream->file) != sizeof(header))
+    {
+        return -1;
+    }
+
+    return fseek(stream->file, 0, SEEK_END);
+}
+
+static ssize_t
+sa_wav_read( simpleaudio *sa, void *buf, size_t nframes )
+{
+    UNUSED(sa);
+    UNUSED(buf);
+    UNUSED(nframes);
+
+    // reading not supported
+    return -1;
+}
+
+// appends the samples to the file as little endian shorts
+static ssize_t
+sa_wav_write( simpleaudio *sa, void *buf, size_t nframes )
+{
+    PWAV_STREAM stream = (PWAV_STREAM)sa->backend_handle;
+    short* samples = (short*)buf;
+    size_t nsamples = nframes * sa->channels;
+
+    for(size_t i = 0; i < nsamples; i++)
+    {
+        unsigned char le[2];
+
+        put_le16(le, (unsigned short)samples[i]);
+        if(fwrite(le, 1, sizeof(le), stream->file) != sizeof(le))
+        {
+            jo_core_error("Failed to write .wav samples");
+            return -1;
+        }
+    }
+
+    stream->dataBytes += nframes * sa->backend_framesize;
+    stream->pendingBytes += nframes * sa->backend_framesize;
+
+    return nframes;
+}
+
+// pads the block with silence to the same minimum as the Saturn backend
+static int
+sa_wav_flush( simpleaudio *sa )
+{
+    PWAV_STREAM stream = (PWAV_STREAM)sa->backend_handle;
+
+    if(stream->pendingBytes == 0)
+    {
+        return true;
+    }
+
+    while(stream->pendingBytes < FLUSH_BUFFER_MIN)
+    {
+        if(fputc(0, stream->file) == EOF)
+        {
+            jo_core_error("Failed to pad .wav block");
+            return false;
+        }
+
+        stream->pendingBytes++;
+        stream->dataBytes++;
+    }
+
+    stream->pendingBytes = 0;
+    return true;
+}
+
+static int
+sa_wav_is_flushed( simpleaudio *sa )
+{
+    PWAV_STREAM stream = (PWAV_STREAM)sa->backend_handle;
+
+    return stream->pendingBytes == 0;
+}
+
+// a file never has to wait for audio to finish playing
+static int
+sa_wav_is_busy( simpleaudio *sa )
+{
+    UNUSED(sa);
+
+    return false;
+}
+
+static void
+sa_wav_close( simpleaudio *sa )
+{
+    PWAV_STREAM stream = (PWAV_STREAM)sa->backend_handle;
+
+    if(stream == NULL)
+    {
+        return;
+    }
+
+    sa_wav_flush(sa);
+
+    if(sa_wav_write_header(sa, stream) != 0)
+    {
+        jo_core_error("Failed to finalize .wav header");
+    }
+
+    fclose(stream->file);
+    jo_free(stream);
+    sa->backend_handle = NULL;
+}
+
+// backend_device is the path of the .wav file to create
+static int
+sa_wav_open_stream(
+        simpleaudio *sa,
+        const char *backend_device,
+        sa_direction_t sa_stream_direction,
+        sa_format_t sa_format,
+        unsigned int rate, unsigned int channels,
+        char *app_name, char *stream_name )
+{
+    PWAV_STREAM stream = NULL;
+
+    UNUSED(sa_format);
+    UNUSED(rate);
+    UNUSED(channels);
+    UNUSED(app_name);
+    UNUSED(stream_name);
+
+    if(backend_device == NULL || sa_stream_direction != SA_STREAM_PLAYBACK)
+    {
+        return 0;
+    }
+
+    switch ( sa->format ) {
+
+        case SA_SAMPLE_FORMAT_S16:
+            break;
+        default:
+            return 0;
+    }
+
+    stream = jo_malloc(sizeof(WAV_STREAM));
+    if(stream == NULL)
+    {
+        return 0;
+    }
+    jo_memset(stream, 0, sizeof(WAV_STREAM));
+
+    stream->file = fopen(backend_device, "wb");
+    if(stream->file == NULL)
+    {
+        jo_core_error("Failed to open %s", backend_device);
+        jo_free(stream);
+        return 0;
+    }
+
+    sa->backend_handle = stream;
+    sa->backend_framesize = sa->channels * sa->samplesize;
+
+    // placeholder header, sizes are filled in on close
+    if(sa_wav_write_header(sa, stream) != 0)
+    {
+        jo_core_error("Failed to write .wav header");
+        fclose(stream->file);
+        jo_free(stream);
+        sa->backend_handle = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+const struct simpleaudio_backend simpleaudio_backend_wavfile = {
+    sa_wav_open_stream,
+    sa_wav_read,
+    sa_wav_write,
+    sa_wav_close,
+    sa_wav_flush,
+    sa_wav_is_flushed,
+    sa_wav_is_busy,
+    NULL,
+    NULL,
+};
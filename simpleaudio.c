@@ -64,14 +64,28 @@ simpleaudio_open_stream(
 
     switch ( sa_backend ) {
 
+#ifndef SGEX_HOST
     case SA_BACKEND_SEGASATURN:
         sa->backend = &simpleaudio_backend_segasaturn;
         break;
 
+    case SA_BACKEND_SEGASATURN_68K:
+        sa->backend = &simpleaudio_backend_segasaturn68k;
+        break;
+
+    case SA_BACKEND_SEGASATURN_PITCH:
+        sa->backend = &simpleaudio_backend_segasaturnpitch;
+        break;
+#endif
+
 #if USE_SNDFILE
 	case SA_BACKEND_FILE:
 	    sa->backend = &simpleaudio_backend_sndfile;
 	    break;
+#elif USE_WAVFILE
+	case SA_BACKEND_FILE:
+	    sa->backend = &simpleaudio_backend_wavfile;
+	    break;
 #endif
 
 #if USE_BENCHMARKS
@@ -182,3 +196,28 @@ simpleaudio_close( simpleaudio *sa )
     sa->backend->simpleaudio_close(sa);
     jo_free(sa);
 }
+
+int
+simpleaudio_flush( simpleaudio *sa )
+{
+    return sa->backend->simpleaudio_flush(sa);
+}
+
+int
+simpleaudio_is_flushed( simpleaudio *sa )
+{
+    return sa->backend->simpleaudio_is_flushed(sa);
+}
+
+int
+simpleaudio_is_busy( simpleaudio *sa )
+{
+    return sa->backend->simpleaudio_is_busy(sa);
+}
+
+void
+simpleaudio_stop( simpleaudio *sa )
+{
+    if ( sa->backend->simpleaudio_stop )
+        sa->backend->simpleaudio_stop(sa);
+}
@@ -20,8 +20,10 @@
 #ifndef SIMPLEAUDIO_H
 #define SIMPLEAUDIO_H
 
+#ifndef SGEX_HOST
 typedef int ssize_t;
 typedef unsigned int size_t;
+#endif
 
 struct simpleaudio;
 typedef struct simpleaudio simpleaudio;
@@ -40,6 +42,8 @@ typedef enum {
 	SA_BACKEND_ALSA,
 	SA_BACKEND_PULSEAUDIO,
     SA_BACKEND_SEGASATURN,
+    SA_BACKEND_SEGASATURN_68K,
+    SA_BACKEND_SEGASATURN_PITCH,
 } sa_backend_t;
 
 /* sa_stream_direction */
@@ -90,6 +94,23 @@ simpleaudio_write( simpleaudio *sa, void *buf, size_t nframes );
 void
 simpleaudio_close( simpleaudio *sa );
 
+/*
+ * SGEX additions: the transmitter buffers a block of audio and then hands
+ * the whole block to the backend
+ */
+
+int /* boolean 'ok' value */
+simpleaudio_flush( simpleaudio *sa );
+
+int /* boolean */
+simpleaudio_is_flushed( simpleaudio *sa );
+
+int /* boolean */
+simpleaudio_is_busy( simpleaudio *sa );
+
+void
+simpleaudio_stop( simpleaudio *sa );
+
 
 /*
  * simpleaudio tone generator
@@ -101,6 +122,9 @@ simpleaudio_tone_reset();
 void
 simpleaudio_tone(simpleaudio *sa_out, float tone_freq, size_t nsamples_dur);
 
+void
+simpleaudio_tone_shaping( size_t nsamples );
+
 void
 simpleaudio_tone_init( unsigned int new_sin_table_len, float mag );
 
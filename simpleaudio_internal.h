@@ -57,12 +57,38 @@ struct simpleaudio_backend {
 
 	void
 	(*simpleaudio_close)( simpleaudio *sa );
+
+	int
+	(*simpleaudio_flush)( simpleaudio *sa );
+
+	int
+	(*simpleaudio_is_flushed)( simpleaudio *sa );
+
+	int
+	(*simpleaudio_is_busy)( simpleaudio *sa );
+
+	// optional, backends that make the tones themselves take them here
+	// instead of being written samples
+	int /* boolean 'ok' value */
+	(*simpleaudio_tone)( simpleaudio *sa, float tone_freq, size_t nsamples_dur );
+
+	// optional, drops everything written or queued and goes quiet.
+	// Backends without it let the audio play out
+	void
+	(*simpleaudio_stop)( simpleaudio *sa );
 };
 
+// blocks handed to the audio hardware are padded with silence to at least
+// this many bytes. The wav backend pads the same way so its output matches
+#define FLUSH_BUFFER_MIN 26000
+
 extern const struct simpleaudio_backend simpleaudio_backend_benchmark;
 extern const struct simpleaudio_backend simpleaudio_backend_sndfile;
 extern const struct simpleaudio_backend simpleaudio_backend_alsa;
 extern const struct simpleaudio_backend simpleaudio_backend_pulseaudio;
 extern const struct simpleaudio_backend simpleaudio_backend_segasaturn;
+extern const struct simpleaudio_backend simpleaudio_backend_segasaturn68k;
+extern const struct simpleaudio_backend simpleaudio_backend_segasaturnpitch;
+extern const struct simpleaudio_backend simpleaudio_backend_wavfile;
 
 #endif
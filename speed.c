@@ -0,0 +1,181 @@
+#include <jo/jo.h>
+#include "speed.h"
+#include "encode.h"
+#include "saturn-minimodem.h"
+
+// minimodem's tones for each rate, the faster profiles trade framing and
+// parity for speed, see sgex-bench-channel
+const SPEED_PROFILE SPEED_PROFILES[SPEED_NUM_PROFILES] =
+{
+    [SPEED_CONSERVATIVE] = {"Conservative", 1200, 1200, 2200, 4, 4, 32},
+    [SPEED_FAST] = {"Fast", 2400, 1800, 3800, 1, 1, 32},
+    [SPEED_EXPERIMENTAL] = {"Experimental", 4800, 3000, 7000, 1, 1, 64},
+};
+
+int speedGetCurrent(PSPEED_PROFILE speed)
+{
+    MODEM_CONFIG config = {0};
+    unsigned int profile = 0;
+
+    if(speed == NULL || SaturnMinimodem_getConfig(&config) != 0)
+    {
+        return -1;
+    }
+
+    speed->name = "Custom";
+    speed->dataRate = config.dataRate;
+    speed->markFreq = config.markFreq;
+    speed->spaceFreq = config.spaceFreq;
+    speed->numStartBits = config.numStartBits;
+    speed->numStopBits = config.numStopBits;
+    speed->parity = g_reedSolomonParity;
+
+    profile = speedFindProfile(speed);
+    if(profile != SPEED_CUSTOM)
+    {
+        speed->name = SPEED_PROFILES[profile].name;
+    }
+
+    return 0;
+}
+
+unsigned int speedFindProfile(PSPEED_PROFILE speed)
+{
+    for(unsigned int i = 0; i < SPEED_NUM_PROFILES; i++)
+    {
+        const SPEED_PROFILE* profile = &SPEED_PROFILES[i];
+
+        if(speed->dataRate == profile->dataRate && speed->markFreq == profile->markFreq &&
+           speed->spaceFreq == profile->spaceFreq && speed->numStartBits == profile->numStartBits &&
+           speed->numStopBits == profile->numStopBits && speed->parity == profile->parity)
+        {
+            return i;
+        }
+    }
+
+    return SPEED_CUSTOM;
+}
+
+int speedApply(PSPEED_PROFILE speed)
+{
+    MODEM_CONFIG config = {0};
+
+    if(speed == NULL)
+    {
+        return -1;
+    }
+
+    SaturnMinimodem_getConfig(&config);
+    config.dataRate = speed->dataRate;
+    config.markFreq = speed->markFreq;
+    config.spaceFreq = speed->spaceFreq;
+    config.numStartBits = speed->numStartBits;
+    config.numStopBits = speed->numStopBits;
+
+    SaturnMinimodem_close();
+    if(SaturnMinimodem_setConfig(&config) != 0 || SaturnMinimodem_init() != 0)
+    {
+        jo_core_error("Failed to change the modem settings!!");
+        return -1;
+    }
+
+    if(initializeReedSolomon(speed->parity) != 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+// any single byte changed changes the check byte
+static unsigned char speedCheck(const unsigned char* record)
+{
+    unsigned char check = 0x5A;
+
+    for(unsigned int i = 0; i < SPEED_RECORD_SIZE - 1; i++)
+    {
+        check = (unsigned char)((check << 1) | (check >> 7)) ^ record[i];
+    }
+
+    return check;
+}
+
+void speedPack(PSPEED_PROFILE speed, unsigned char* record)
+{
+    unsigned int dataRate = (unsigned int)speed->dataRate;
+    unsigned int markFreq = (unsigned int)speed->markFreq;
+    unsigned int spaceFreq = (unsigned int)speed->spaceFreq;
+
+    record[0] = (unsigned char)(dataRate >> 8);
+    record[1] = (unsigned char)dataRate;
+    record[2] = (unsigned char)(markFreq >> 8);
+    record[3] = (unsigned char)markFreq;
+    record[4] = (unsigned char)(spaceFreq >> 8);
+    record[5] = (unsigned char)spaceFreq;
+    record[6] = (unsigned char)speed->numStartBits;
+    record[7] = (unsigned char)speed->numStopBits;
+    record[8] = (unsigned char)speed->parity;
+    record[9] = speedCheck(record);
+}
+
+int speedUnpack(const unsigned char* record, PSPEED_PROFILE speed)
+{
+    unsigned int profile = 0;
+
+    if(record == NULL || speed == NULL || record[9] != speedCheck(record))
+    {
+        return -1;
+    }
+
+    speed->name = "Custom";
+    speed->dataRate = (record[0] << 8) | record[1];
+    speed->markFreq = (record[2] << 8) | record[3];
+    speed->spaceFreq = (record[4] << 8) | record[5];
+    speed->numStartBits = record[6];
+    speed->numStopBits = record[7];
+    speed->parity = record[8];
+
+    // the same checks the modem and Reed Solomon encoder make
+    if(speed->dataRate < 400 || speed->markFreq == 0 || speed->spaceFreq == 0 || speed->numStartBits == 0 ||
+       speed->numStopBits == 0 || speed->parity == 0 || speed->parity % 2)
+    {
+        return -1;
+    }
+
+    profile = speedFindProfile(speed);
+    if(profile != SPEED_CUSTOM)
+    {
+        speed->name = SPEED_PROFILES[profile].name;
+    }
+
+    return 0;
+}
+
+int speedAnnouncement(unsigned char* buffer, unsigned int* size)
+{
+    SPEED_PROFILE speed = {0};
+    unsigned char record[SPEED_RECORD_SIZE] = {0};
+    unsigned int j = 0;
+
+    if(buffer == NULL || size == NULL || speedGetCurrent(&speed) != 0)
+    {
+        return -1;
+    }
+
+    *size = 0;
+    if(speedFindProfile(&speed) == SPEED_CONSERVATIVE)
+    {
+        return 0;
+    }
+
+    speedPack(&speed, record);
+    for(unsigned int i = 0; i < SPEED_ANNOUNCE_REPEATS; i++)
+    {
+        buffer[j++] = ESCAPE_BYTE;
+        buffer[j++] = ESCAPE_ANNOUNCE_BYTE;
+        j += escapeBytes(record, SPEED_RECORD_SIZE, buffer + j);
+    }
+
+    *size = j;
+    return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <jo/jo.h>
+
+/*
+ * Speed profiles, the baud rate, tones, framing and Reed Solomon parity
+ * saves and the BIOS are sent with. Picked on the main screen and kept in a
+ * small save on internal memory so they survive a power off.
+ *
+ * Anything but the default settings is announced before a transmission the
+ * user starts: ESCAPE_BYTE ESCAPE_ANNOUNCE_BYTE and the escaped settings, in
+ * a block at the default settings. A receiver left on the usual minimodem
+ * command reads it and sgex.py decodes the capture again with the settings.
+ */
+
+#define SPEED_CONSERVATIVE      0 // the modem's defaults, nothing is announced
+#define SPEED_FAST              1
+#define SPEED_EXPERIMENTAL      2
+#define SPEED_NUM_PROFILES      3
+#define SPEED_CUSTOM            SPEED_NUM_PROFILES // not a profile, e.g. a tone plan code from the test screen
+
+#define SPEED_RECORD_SIZE       10 // packed settings, see speedPack()
+#define SPEED_ANNOUNCE_REPEATS  2 // the record is sent this many times, the receiver takes the first intact one
+#define SPEED_ANNOUNCE_MAX_SIZE (SPEED_ANNOUNCE_REPEATS * (2 + SPEED_RECORD_SIZE * 2)) // every byte escaped
+
+#define SPEED_SAVE_FILENAME     "SGEX_SPEED"
+#define SPEED_SAVE_COMMENT      "Modem"
+
+typedef struct _SPEED_PROFILE
+{
+    const char* name;
+    float dataRate;
+    float markFreq;
+    float spaceFreq;
+    unsigned int numStartBits;
+    unsigned int numStopBits;
+    unsigned int parity; // Reed Solomon parity bytes per codeword
+} SPEED_PROFILE, *PSPEED_PROFILE;
+
+extern const SPEED_PROFILE SPEED_PROFILES[SPEED_NUM_PROFILES];
+
+// the settings in use, named after the profile they match or "Custom"
+int speedGetCurrent(PSPEED_PROFILE speed);
+
+// SPEED_PROFILES index of the settings, SPEED_CUSTOM if they aren't one
+unsigned int speedFindProfile(PSPEED_PROFILE speed);
+
+// reopens the modem and the Reed Solomon encoder with the settings
+int speedApply(PSPEED_PROFILE speed);
+
+// settings to and from SPEED_RECORD_SIZE bytes: the rate, mark and space
+// tones as big-endian 16-bit numbers, the start and stop bits, the parity
+// and a check byte. Unpacking fails if the check byte doesn't match
+void speedPack(PSPEED_PROFILE speed, unsigned char* record);
+int speedUnpack(const unsigned char* record, PSPEED_PROFILE speed);
+
+// the announcement of the settings in use into buffer, which needs
+// SPEED_ANNOUNCE_MAX_SIZE bytes. *size is 0 with the default settings
+int speedAnnouncement(unsigned char* buffer, unsigned int* size);
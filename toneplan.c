@@ -0,0 +1,64 @@
+#include <jo/jo.h>
+#include "toneplan.h"
+
+// the rates the test screen offers, below 400 minimodem moves to the Bell 103 tones
+const unsigned int TONE_PLAN_RATES[TONE_PLAN_NUM_RATES] = {600, 1200, 2400, 4800};
+
+float sweepStepFreq(unsigned int step)
+{
+    return SWEEP_START_FREQ + step * SWEEP_STEP_FREQ;
+}
+
+// same shift as SaturnMinimodem_init() for 400 baud and up
+float tonePlanSpaceFreq(float dataRate, float markFreq)
+{
+    return markFreq + dataRate * 5 / 6;
+}
+
+// weights 3, 7 and 1 catch any single wrong digit
+static unsigned int checkDigit(unsigned int rateIndex, unsigned int markStep)
+{
+    return (10 - (rateIndex * 3 + (markStep / 10) * 7 + markStep % 10) % 10) % 10;
+}
+
+int tonePlanEncode(PTONE_PLAN plan, unsigned int* code)
+{
+    unsigned int rateIndex = 0;
+    unsigned int markStep = 0;
+
+    if(plan == NULL || code == NULL || plan->markFreq < SWEEP_START_FREQ)
+    {
+        return -1;
+    }
+
+    while(rateIndex < TONE_PLAN_NUM_RATES && TONE_PLAN_RATES[rateIndex] != (unsigned int)plan->dataRate)
+    {
+        rateIndex++;
+    }
+
+    markStep = (unsigned int)(plan->markFreq - SWEEP_START_FREQ) / SWEEP_STEP_FREQ;
+    if(rateIndex >= TONE_PLAN_NUM_RATES || markStep >= SWEEP_NUM_STEPS || sweepStepFreq(markStep) != plan->markFreq)
+    {
+        return -1;
+    }
+
+    *code = rateIndex * 1000 + markStep * 10 + checkDigit(rateIndex, markStep);
+    return 0;
+}
+
+int tonePlanDecode(unsigned int code, PTONE_PLAN plan)
+{
+    unsigned int rateIndex = code / 1000;
+    unsigned int markStep = (code / 10) % 100;
+
+    if(plan == NULL || rateIndex >= TONE_PLAN_NUM_RATES || markStep >= SWEEP_NUM_STEPS ||
+       code % 10 != checkDigit(rateIndex, markStep))
+    {
+        return -1;
+    }
+
+    plan->dataRate = TONE_PLAN_RATES[rateIndex];
+    plan->markFreq = sweepStepFreq(markStep);
+    plan->spaceFreq = tonePlanSpaceFreq(plan->dataRate, plan->markFreq);
+    return 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <jo/jo.h>
+
+/*
+ * Tone plans, the baud rate and the mark and space tones the modem uses.
+ *
+ * The calibration sweep on the test screen plays SWEEP_NUM_STEPS tones with
+ * a gap of silence after each. sgex-sweep measures the level and the noise
+ * at every step and prints the code of the fastest plan that fits the flat,
+ * quiet part of the line. Entering the code on the test screen switches the
+ * modem to that plan for the rest of the session.
+ *
+ * Codes are TONE_PLAN_CODE_DIGITS digits: the TONE_PLAN_RATES index, the mark
+ * tone in sweep steps (two digits) and a check digit. The space tone follows
+ * the mark tone the same way SaturnMinimodem_init() picks it.
+ */
+
+#define SWEEP_START_FREQ        400
+#define SWEEP_STEP_FREQ         100
+#define SWEEP_NUM_STEPS         97 // up to 10000Hz, room for the 4800 baud tones
+#define SWEEP_STEP_MS           100
+#define SWEEP_GAP_MS            20 // silence after each step, the receiver measures the noise in it
+
+#define TONE_PLAN_NUM_RATES     4
+#define TONE_PLAN_CODE_DIGITS   4
+
+typedef struct _TONE_PLAN
+{
+    float dataRate;
+    float markFreq;
+    float spaceFreq;
+} TONE_PLAN, *PTONE_PLAN;
+
+extern const unsigned int TONE_PLAN_RATES[TONE_PLAN_NUM_RATES];
+
+// frequency of a sweep step
+float sweepStepFreq(unsigned int step);
+
+// the space tone that goes with a mark tone at a rate
+float tonePlanSpaceFreq(float dataRate, float markFreq);
+
+// code for a plan. The rate must be one of TONE_PLAN_RATES and the mark tone a sweep step
+int tonePlanEncode(PTONE_PLAN plan, unsigned int* code);
+
+// plan for a code, -1 if the check digit doesn't match
+int tonePlanDecode(unsigned int code, PTONE_PLAN plan);
@@ -5,7 +5,57 @@
 #define COUNTOF(x) sizeof(x)/sizeof(x[0])
 
 #define LWRAM 0x00200000 // start of LWRAM memory. Doesn't appear to be used
-#define LWRAM_HEAP_SIZE 0x100000 // number of bytes to extend heap by
+#define LWRAM_SIZE 0x100000 // number of bytes of LWRAM, used for the transfer arena
+#define SOUND_RAM 0x25A00000 // start of sound RAM
+#define SOUND_RAM_SIZE 0x80000 // number of bytes of sound RAM
+#define SOUND_RAM_ARENA (SOUND_RAM + 0x40000) // past the SGL sound driver and its maps
+#define SOUND_RAM_ARENA_SIZE 0x30000 // stops short of the SGL PCM stream buffers
+
+#define SCU_IST (*(volatile unsigned int*)0x25FE00A4) // SCU interrupt status, write 0 to clear
+
+// BIOS calls, the same as SGL's SYS_SETSINT and SYS_CHGSCUIM
+#define BIOS_SET_SCU_INTERRUPT(vector, func) \
+        ((**(void(**)(unsigned int, void*))0x06000310)((vector), (func)))
+#define BIOS_CHANGE_SCU_MASK(andMask, orMask) \
+        ((**(void(**)(unsigned int, unsigned int))0x06000344)((andMask), (orMask)))
+
+#ifndef SGEX_HOST
+// masks interrupts on the master SH-2, returns the old status register for restoreInterrupts()
+static inline unsigned int disableInterrupts(void)
+{
+    unsigned int sr = 0;
+
+    __asm__ volatile("stc sr, %0" : "=r"(sr));
+    __asm__ volatile("ldc %0, sr" : : "r"(sr | 0xF0) : "memory");
+    return sr;
+}
+
+// masks interrupts at or below level, anything above can still nest
+static inline unsigned int setInterruptLevel(unsigned int level)
+{
+    unsigned int sr = 0;
+
+    __asm__ volatile("stc sr, %0" : "=r"(sr));
+    __asm__ volatile("ldc %0, sr" : : "r"((sr & ~0xF0) | ((level & 0x0F) << 4)) : "memory");
+    return sr;
+}
+
+static inline void restoreInterrupts(unsigned int sr)
+{
+    __asm__ volatile("ldc %0, sr" : : "r"(sr) : "memory");
+}
+#else
+// nothing runs from interrupts on the host
+static inline unsigned int disableInterrupts(void)
+{
+    return 0;
+}
+
+static inline void restoreInterrupts(unsigned int sr)
+{
+    (void)sr;
+}
+#endif
 
 // This function prototype is not in jo/malloc.h
 // Extend the heap